@@ -35,6 +35,9 @@ typedef enum
 
 typedef void (*ProgressCallback) (GitgWindow *window, GitgProgress progress, gpointer data);
 
+/* Like ProgressCallback, with the output lines of the command joined */
+typedef void (*CommandCallback) (GitgWindow *window, GitgProgress progress, gchar const *output, gpointer data);
+
 typedef struct
 {
 	GitgWindow *window;
@@ -44,11 +47,21 @@ typedef struct
 	gpointer callback_data;
 
 	guint timeout_id;
+	gboolean reported;
 
 	GtkDialog *dialog;
 	GtkProgressBar *progress;
 } ProgressInfo;
 
+typedef struct
+{
+	GitgWindow *window;
+	GString *output;
+
+	CommandCallback callback;
+	gpointer callback_data;
+} CommandInfo;
+
 static void
 free_progress_info (ProgressInfo *info)
 {
@@ -80,23 +93,28 @@ parse_valist (va_list ap)
 	return ret;
 }
 
-static void
-on_progress_end (GitgShell *shell, gboolean cancelled, ProgressInfo *info)
+static GitgProgress
+shell_progress (GitgShell *shell,
+                GError    *error)
 {
-	GitgProgress progress;
-
-	if (cancelled)
+	if (gitg_io_get_cancelled (GITG_IO (shell)))
 	{
-		progress = GITG_PROGRESS_CANCELLED;
+		return GITG_PROGRESS_CANCELLED;
 	}
-	else if (gitg_io_get_exit_status (GITG_IO (shell)) != 0)
+	else if (error || gitg_io_get_exit_status (GITG_IO (shell)) != 0)
 	{
-		progress = GITG_PROGRESS_ERROR;
+		return GITG_PROGRESS_ERROR;
 	}
 	else
 	{
-		progress = GITG_PROGRESS_SUCCESS;
+		return GITG_PROGRESS_SUCCESS;
 	}
+}
+
+static void
+on_progress_end (GitgShell *shell, GError *error, ProgressInfo *info)
+{
+	GitgProgress progress = shell_progress (shell, error);
 
 	GitgWindow *window = info->window;
 	ProgressCallback callback = info->callback;
@@ -115,31 +133,163 @@ on_progress_response (GtkDialog *dialog, GtkResponseType response, ProgressInfo
 static gboolean
 on_progress_timeout (ProgressInfo *info)
 {
-	gtk_progress_bar_pulse (info->progress);
+	if (!info->reported)
+	{
+		gtk_progress_bar_pulse (info->progress);
+	}
+
 	return TRUE;
 }
 
-static GitgShell *
-run_progress (GitgWindow       *window,
-              gchar const      *title,
-              gchar const      *message,
-              ProgressCallback  callback,
-              gpointer          callback_data,
-              ...)
+/* Parses a counter like "Rebasing (3/10)", which git uses where it does
+   not report percentages */
+static gboolean
+parse_progress_counter (gchar const  *line,
+                        gchar       **phase,
+                        gdouble      *fraction)
 {
-	va_list ap;
+	gchar const *open = strrchr (line, '(');
+	gchar *end;
+	guint64 num;
+	guint64 total;
 
-	va_start (ap, callback_data);
+	if (!open || open == line)
+	{
+		return FALSE;
+	}
+
+	num = g_ascii_strtoull (open + 1, &end, 10);
+
+	if (end == open + 1 || *end != '/')
+	{
+		return FALSE;
+	}
+
+	total = g_ascii_strtoull (end + 1, &end, 10);
+
+	if (total == 0 || *end != ')')
+	{
+		return FALSE;
+	}
+
+	while (open > line && *(open - 1) == ' ')
+	{
+		--open;
+	}
+
+	*phase = g_strndup (line, open - line);
+	*fraction = CLAMP ((gdouble)num / total, 0, 1);
+
+	return TRUE;
+}
+
+static gboolean
+parse_progress (gchar const  *line,
+                gchar       **phase,
+                gdouble      *fraction)
+{
+	/* Like "Writing objects:  45% (9/20)", the phase may be prefixed
+	   with remote: */
+	gchar const *percent = strchr (line, '%');
+	gchar const *start;
+	gchar const *end;
+
+	if (!percent)
+	{
+		return parse_progress_counter (line, phase, fraction);
+	}
+
+	start = percent;
+
+	while (start > line && g_ascii_isdigit (*(start - 1)))
+	{
+		--start;
+	}
+
+	if (start == percent)
+	{
+		return FALSE;
+	}
+
+	end = start;
+
+	while (end > line && (*(end - 1) == ' ' || *(end - 1) == ':'))
+	{
+		--end;
+	}
+
+	*phase = g_strndup (line, end - line);
+	*fraction = CLAMP (g_ascii_strtoull (start, NULL, 10) / 100.0, 0, 1);
+
+	return TRUE;
+}
+
+static void
+on_progress_update (GitgShell     *shell,
+                    gchar        **lines,
+                    ProgressInfo  *info)
+{
+	gchar *phase = NULL;
+	gdouble fraction = 0;
+
+	/* Only the last report of the batch is shown */
+	while (lines && *lines)
+	{
+		gchar *p;
+		gdouble f;
+
+		if (parse_progress (*lines, &p, &f))
+		{
+			g_free (phase);
+
+			phase = p;
+			fraction = f;
+		}
+
+		++lines;
+	}
+
+	if (phase)
+	{
+		info->reported = TRUE;
+
+		gtk_progress_bar_set_fraction (info->progress, fraction);
+		gtk_progress_bar_set_text (info->progress, phase);
+
+		g_free (phase);
+	}
+}
 
+static GitgShell *
+run_progress_argv (GitgWindow          *window,
+                   gchar const         *title,
+                   gchar const         *message,
+                   GOutputStream       *output,
+                   gboolean             report,
+                   ProgressCallback     callback,
+                   gpointer             callback_data,
+                   gchar const * const *argv)
+{
 	GitgShell *shell = gitg_shell_new (1000);
-	gchar const **argv = parse_valist (ap);
 
 	GitgCommand *cmd = gitg_command_newv (gitg_window_get_repository (window),
-	                                      (gchar const * const *)argv);
+	                                      argv);
+
+	/* The output is spliced into the stream directly, without going
+	   through the line parser */
+	if (output)
+	{
+		gitg_io_set_output (GITG_IO (shell), output);
+	}
+
+	/* git reports progress on standard error */
+	if (report)
+	{
+		gitg_command_set_merge_error (cmd, TRUE);
+	}
 
 	if (!gitg_shell_run (shell, cmd, NULL))
 	{
-		g_free (argv);
 		g_object_unref (shell);
 
 		callback (window, GITG_PROGRESS_ERROR, callback_data);
@@ -147,12 +297,17 @@ run_progress (GitgWindow       *window,
 		return NULL;
 	}
 
-	g_free (argv);
-
 	// Create dialog to show progress
-	GtkDialogFlags flags = GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT;
+	GtkDialogFlags flags = GTK_DIALOG_DESTROY_WITH_PARENT;
 	GtkWidget *dlg;
 
+	/* Writing to a file does not touch the repository, no need to block
+	   the window for it */
+	if (!output)
+	{
+		flags |= GTK_DIALOG_MODAL;
+	}
+
 	dlg = gtk_message_dialog_new (GTK_WINDOW (window),
 	                              flags,
 	                              GTK_MESSAGE_INFO,
@@ -189,9 +344,186 @@ run_progress (GitgWindow       *window,
 	g_signal_connect (dlg, "response", G_CALLBACK (on_progress_response), info);
 	g_signal_connect (shell, "end", G_CALLBACK (on_progress_end), info);
 
+	if (report)
+	{
+		g_signal_connect (shell, "update", G_CALLBACK (on_progress_update), info);
+	}
+
+	return shell;
+}
+
+static GitgShell *
+run_progress (GitgWindow       *window,
+              gchar const      *title,
+              gchar const      *message,
+              gboolean          report,
+              ProgressCallback  callback,
+              gpointer          callback_data,
+              ...)
+{
+	va_list ap;
+	gchar const **argv;
+	GitgShell *ret;
+
+	va_start (ap, callback_data);
+	argv = parse_valist (ap);
+	va_end (ap);
+
+	ret = run_progress_argv (window,
+	                         title,
+	                         message,
+	                         NULL,
+	                         report,
+	                         callback,
+	                         callback_data,
+	                         (gchar const * const *)argv);
+
+	g_free (argv);
+	return ret;
+}
+
+static void
+update_buffer (GitgShell *shell, gchar **lines, GString *buffer)
+{
+	gchar **ptr = lines;
+
+	while (ptr && *ptr)
+	{
+		if (buffer->len != 0)
+		{
+			g_string_append_c (buffer, '\n');
+		}
+
+		g_string_append (buffer, *ptr);
+		++ptr;
+	}
+}
+
+static void
+on_command_update (GitgShell    *shell,
+                   gchar       **lines,
+                   CommandInfo  *info)
+{
+	update_buffer (shell, lines, info->output);
+}
+
+static void
+on_command_end (GitgShell   *shell,
+                GError      *error,
+                CommandInfo *info)
+{
+	info->callback (info->window,
+	                shell_progress (shell, error),
+	                info->output->str,
+	                info->callback_data);
+
+	g_string_free (info->output, TRUE);
+	g_slice_free (CommandInfo, info);
+}
+
+/* Runs one of the quick steps of an action in the background, without a
+   progress dialog. The returned shell is owned by the caller, like the
+   ones of run_progress */
+static GitgShell *
+run_command (GitgWindow      *window,
+             GitgCommand     *command,
+             gchar const     *input,
+             CommandCallback  callback,
+             gpointer         callback_data)
+{
+	GitgShell *shell = gitg_shell_new (1000);
+
+	if (input)
+	{
+		GInputStream *stream;
+
+		stream = g_memory_input_stream_new_from_data (g_strdup (input),
+		                                              -1,
+		                                              (GDestroyNotify)g_free);
+
+		gitg_io_set_input (GITG_IO (shell), stream);
+		g_object_unref (stream);
+	}
+
+	if (!gitg_shell_run (shell, command, NULL))
+	{
+		g_object_unref (shell);
+
+		callback (window, GITG_PROGRESS_ERROR, "", callback_data);
+		return NULL;
+	}
+
+	CommandInfo *info = g_slice_new (CommandInfo);
+
+	info->window = window;
+	info->output = g_string_new ("");
+	info->callback = callback;
+	info->callback_data = callback_data;
+
+	g_signal_connect (shell, "update", G_CALLBACK (on_command_update), info);
+	g_signal_connect (shell, "end", G_CALLBACK (on_command_end), info);
+
 	return shell;
 }
 
+/* Runs a later step of an action, the window keeps track of it so that
+   it is cancelled with the window */
+static void
+run_step (GitgWindow      *window,
+          GitgCommand     *command,
+          gchar const     *input,
+          CommandCallback  callback,
+          gpointer         callback_data)
+{
+	gitg_window_add_branch_action (window,
+	                               run_command (window,
+	                                            command,
+	                                            input,
+	                                            callback,
+	                                            callback_data));
+}
+
+static void
+reload (GitgWindow *window)
+{
+	gitg_repository_reload (gitg_window_get_repository (window));
+}
+
+static void
+on_head_described (GitgWindow   *window,
+                   GitgProgress  progress,
+                   gchar const  *output,
+                   gpointer      data)
+{
+	GitgRepository *repository = gitg_window_get_repository (window);
+
+	if (progress != GITG_PROGRESS_SUCCESS ||
+	    !gitg_repository_update_head (repository, output))
+	{
+		gitg_repository_reload (repository);
+	}
+}
+
+/* Inserts the commit that was just made on top of the checked out branch
+   into the loaded history, or reloads it when that is not possible */
+static void
+refresh_head (GitgWindow *window)
+{
+	GitgCommand *command;
+
+	command = gitg_repository_update_head_command (gitg_window_get_repository (window),
+	                                               "HEAD");
+
+	if (!command)
+	{
+		reload (window);
+	}
+	else
+	{
+		run_step (window, command, NULL, on_head_described, NULL);
+	}
+}
+
 static gint
 message_dialog (GitgWindow     *window,
                 GtkMessageType  type,
@@ -256,19 +588,41 @@ message_dialog (GitgWindow     *window,
 	return ret;
 }
 
-static GitgShell *
-remove_local_branch (GitgWindow *window,
-                     GitgRef    *ref)
+static void
+on_force_remove_local_result (GitgWindow   *window,
+                              GitgProgress  progress,
+                              gchar const  *output,
+                              gpointer      data)
+{
+	GitgRef *ref = (GitgRef *)data;
+
+	if (progress == GITG_PROGRESS_ERROR)
+	{
+		message_dialog (window,
+		                GTK_MESSAGE_ERROR,
+		                _ ("Branch <%s> could not be forcefully removed"),
+		                NULL,
+		                NULL,
+		                gitg_ref_get_shortname (ref));
+	}
+	else if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		reload (window);
+	}
+
+	gitg_ref_free (ref);
+}
+
+static void
+on_remove_local_result (GitgWindow   *window,
+                        GitgProgress  progress,
+                        gchar const  *output,
+                        gpointer      data)
 {
+	GitgRef *ref = (GitgRef *)data;
 	gchar const *name = gitg_ref_get_shortname (ref);
-	GitgRepository *repository = gitg_window_get_repository (window);
 
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "branch",
-	                                             "-d",
-	                                             name,
-	                                             NULL),
-	                          NULL))
+	if (progress == GITG_PROGRESS_ERROR)
 	{
 		gint ret = message_dialog (window,
 		                           GTK_MESSAGE_ERROR,
@@ -279,37 +633,40 @@ remove_local_branch (GitgWindow *window,
 
 		if (ret == GTK_RESPONSE_ACCEPT)
 		{
-			if (!gitg_shell_run_sync (gitg_command_new (repository,
-			                                             "branch",
-			                                             "-D",
-			                                             name,
-			                                             NULL),
-			                          NULL))
-			{
-				message_dialog (window,
-				                GTK_MESSAGE_ERROR,
-				                _ ("Branch <%s> could not be forcefully removed"),
-				                NULL,
-				                NULL,
-				                name);
-
-				return NULL;
-			}
-			else
-			{
-				gitg_repository_reload (repository);
-				return NULL;
-			}
+			run_step (window,
+			          gitg_command_new (gitg_window_get_repository (window),
+			                            "branch",
+			                            "-D",
+			                            name,
+			                            NULL),
+			          NULL,
+			          on_force_remove_local_result,
+			          ref);
+
+			return;
 		}
 	}
-	else
+	else if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		gitg_repository_reload (repository);
-
-		return NULL;
+		reload (window);
 	}
 
-	return NULL;
+	gitg_ref_free (ref);
+}
+
+static GitgShell *
+remove_local_branch (GitgWindow *window,
+                     GitgRef    *ref)
+{
+	return run_command (window,
+	                    gitg_command_new (gitg_window_get_repository (window),
+	                                      "branch",
+	                                      "-d",
+	                                      gitg_ref_get_shortname (ref),
+	                                      NULL),
+	                    NULL,
+	                    on_remove_local_result,
+	                    gitg_ref_copy (ref));
 }
 
 static void
@@ -328,7 +685,7 @@ on_remove_remote_result (GitgWindow *window, GitgProgress progress, gpointer dat
 	}
 	else if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		gitg_repository_reload (gitg_window_get_repository (window));
+		reload (window);
 	}
 
 	gitg_ref_free (ref);
@@ -361,32 +718,24 @@ remove_remote_branch (GitgWindow *window,
 	ret = run_progress (window,
 	                    _ ("Remove branch"),
 	                    message,
+	                    TRUE,
 	                    on_remove_remote_result,
 	                    gitg_ref_copy (ref),
 	                    "push",
+	                    "--progress",
 	                    gitg_ref_get_prefix (ref),
 	                    rm,
 	                    NULL);
 	g_free (message);
+	g_free (rm);
 
 	return ret;
 }
 
 static gchar *
-get_stash_refspec (GitgRepository *repository, GitgRef *stash)
+get_stash_refspec (gchar const *reflog, GitgRef *stash)
 {
-	gchar **out;
-
-	out = gitg_shell_run_sync_with_output (gitg_command_new (repository,
-	                                                          "log",
-	                                                          "--no-color",
-	                                                          "--pretty=oneline",
-	                                                          "-g",
-	                                                          "refs/stash",
-	                                                          NULL),
-	                                       FALSE,
-	                                       NULL);
-
+	gchar **out = g_strsplit (reflog, "\n", -1);
 	gchar **ptr = out;
 	gchar *sha1 = gitg_hash_hash_to_sha1_new (gitg_ref_get_hash (stash));
 	gchar *ret = NULL;
@@ -413,36 +762,50 @@ get_stash_refspec (GitgRepository *repository, GitgRef *stash)
 	return ret;
 }
 
-static GitgShell *
-remove_stash (GitgWindow *window, GitgRef *ref)
+static void
+on_stash_ref_removed (GitgWindow   *window,
+                      GitgProgress  progress,
+                      gchar const  *output,
+                      gpointer      data)
 {
-	gint r = message_dialog (window,
-	                         GTK_MESSAGE_QUESTION,
-	                         _ ("Are you sure you want to remove this stash item?"),
-	                         _ ("This permanently removes the stash item"),
-	                         _ ("Remove stash"));
-
-	if (r != GTK_RESPONSE_ACCEPT)
+	if (progress != GITG_PROGRESS_CANCELLED)
 	{
-		return NULL;
+		reload (window);
 	}
+}
 
-	GitgRepository *repository = gitg_window_get_repository (window);
-	gchar *spec = get_stash_refspec (repository, ref);
-
-	if (!spec)
+static void
+on_stash_verified (GitgWindow   *window,
+                   GitgProgress  progress,
+                   gchar const  *output,
+                   gpointer      data)
+{
+	if (progress == GITG_PROGRESS_ERROR)
 	{
-		return NULL;
+		/* That was the last stash item */
+		run_step (window,
+		          gitg_command_new (gitg_window_get_repository (window),
+		                            "update-ref",
+		                            "-d",
+		                            "refs/stash",
+		                            NULL),
+		          NULL,
+		          on_stash_ref_removed,
+		          NULL);
+	}
+	else if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		reload (window);
 	}
+}
 
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "reflog",
-	                                             "delete",
-	                                             "--updateref",
-	                                             "--rewrite",
-	                                             spec,
-	                                             NULL),
-	                          NULL))
+static void
+on_stash_dropped (GitgWindow   *window,
+                  GitgProgress  progress,
+                  gchar const  *output,
+                  gpointer      data)
+{
+	if (progress == GITG_PROGRESS_ERROR)
 	{
 		message_dialog (window,
 		                GTK_MESSAGE_ERROR,
@@ -450,72 +813,136 @@ remove_stash (GitgWindow *window, GitgRef *ref)
 		                _ ("The stash item could not be successfully removed"),
 		                NULL);
 	}
-	else
+	else if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		if (!gitg_shell_run_sync (gitg_command_new (repository,
-		                                             "rev-parse",
-		                                             "--verify",
-		                                             "refs/stash@{0}",
-		                                             NULL),
-		                          NULL))
-		{
-			gitg_shell_run_sync (gitg_command_new (repository,
-			                                        "update-ref",
-			                                        "-d",
-			                                        "refs/stash",
-			                                        NULL),
-			                     NULL);
-		}
+		run_step (window,
+		          gitg_command_new (gitg_window_get_repository (window),
+		                            "rev-parse",
+		                            "--verify",
+		                            "refs/stash@{0}",
+		                            NULL),
+		          NULL,
+		          on_stash_verified,
+		          NULL);
+	}
+}
 
-		gitg_repository_reload (repository);
+static void
+on_stash_reflog (GitgWindow   *window,
+                 GitgProgress  progress,
+                 gchar const  *output,
+                 gpointer      data)
+{
+	GitgRef *ref = (GitgRef *)data;
+	gchar *spec = NULL;
+
+	if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		spec = get_stash_refspec (output, ref);
+	}
+
+	if (spec)
+	{
+		run_step (window,
+		          gitg_command_new (gitg_window_get_repository (window),
+		                            "reflog",
+		                            "delete",
+		                            "--updateref",
+		                            "--rewrite",
+		                            spec,
+		                            NULL),
+		          NULL,
+		          on_stash_dropped,
+		          NULL);
 	}
 
 	g_free (spec);
-	return NULL;
+	gitg_ref_free (ref);
 }
 
 static GitgShell *
-remove_tag (GitgWindow *window, GitgRef *ref)
+remove_stash (GitgWindow *window, GitgRef *ref)
 {
-	gchar const *name = gitg_ref_get_shortname (ref);
-	gchar *message = g_strdup_printf (_ ("Are you sure you want to remove the tag <%s>?"),
-	                                  name);
 	gint r = message_dialog (window,
 	                         GTK_MESSAGE_QUESTION,
-	                         _ ("Remove tag"),
-	                         message,
-	                         _ ("Remove tag"));
-	g_free (message);
+	                         _ ("Are you sure you want to remove this stash item?"),
+	                         _ ("This permanently removes the stash item"),
+	                         _ ("Remove stash"));
 
 	if (r != GTK_RESPONSE_ACCEPT)
 	{
 		return NULL;
 	}
 
-	GitgRepository *repository = gitg_window_get_repository (window);
+	return run_command (window,
+	                    gitg_command_new (gitg_window_get_repository (window),
+	                                      "log",
+	                                      "--no-color",
+	                                      "--pretty=oneline",
+	                                      "-g",
+	                                      "refs/stash",
+	                                      NULL),
+	                    NULL,
+	                    on_stash_reflog,
+	                    gitg_ref_copy (ref));
+}
+
+static void
+on_remove_tag_result (GitgWindow   *window,
+                      GitgProgress  progress,
+                      gchar const  *output,
+                      gpointer      data)
+{
+	GitgRef *ref = (GitgRef *)data;
 
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "tag",
-	                                             "-d",
-	                                             name,
-	                                             NULL),
-	                          NULL))
+	if (progress == GITG_PROGRESS_ERROR)
 	{
+		gchar *message;
+
 		message = g_strdup_printf (_ ("The tag <%s> could not be successfully removed"),
-		                           name);
+		                           gitg_ref_get_shortname (ref));
 		message_dialog (window,
 		                GTK_MESSAGE_ERROR,
 		                _ ("Failed to remove tag"),
 		                message,
 		                NULL);
 		g_free (message);
-		return NULL;
 	}
-	else
+	else if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		reload (window);
+	}
+
+	gitg_ref_free (ref);
+}
+
+static GitgShell *
+remove_tag (GitgWindow *window, GitgRef *ref)
+{
+	gchar const *name = gitg_ref_get_shortname (ref);
+	gchar *message = g_strdup_printf (_ ("Are you sure you want to remove the tag <%s>?"),
+	                                  name);
+	gint r = message_dialog (window,
+	                         GTK_MESSAGE_QUESTION,
+	                         _ ("Remove tag"),
+	                         message,
+	                         _ ("Remove tag"));
+	g_free (message);
+
+	if (r != GTK_RESPONSE_ACCEPT)
 	{
-		gitg_repository_reload (repository);
 		return NULL;
 	}
+
+	return run_command (window,
+	                    gitg_command_new (gitg_window_get_repository (window),
+	                                      "tag",
+	                                      "-d",
+	                                      name,
+	                                      NULL),
+	                    NULL,
+	                    on_remove_tag_result,
+	                    gitg_ref_copy (ref));
 }
 
 GitgShell *
@@ -550,63 +977,108 @@ gitg_branch_actions_remove (GitgWindow *window,
 	return ret;
 }
 
-static GitgShell *
-rename_branch (GitgWindow  *window,
-               GitgRef     *ref,
-               const gchar *newname)
+typedef struct
 {
-	gchar const *oldname = gitg_ref_get_shortname (ref);
-	GitgRepository *repository = gitg_window_get_repository (window);
+	GitgRef *ref;
+	gchar *newname;
+} RenameInfo;
+
+static void
+rename_info_free (RenameInfo *info)
+{
+	gitg_ref_free (info->ref);
+	g_free (info->newname);
+
+	g_slice_free (RenameInfo, info);
+}
+
+static void
+on_force_rename_result (GitgWindow   *window,
+                        GitgProgress  progress,
+                        gchar const  *output,
+                        gpointer      data)
+{
+	RenameInfo *info = (RenameInfo *)data;
+
+	if (progress == GITG_PROGRESS_ERROR)
+	{
+		message_dialog (window,
+		                GTK_MESSAGE_ERROR,
+		                _ ("Branch <%s> could not be forcefully renamed"),
+		                NULL,
+		                NULL,
+		                gitg_ref_get_shortname (info->ref));
+	}
+	else if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		reload (window);
+	}
+
+	rename_info_free (info);
+}
+
+static void
+on_rename_result (GitgWindow   *window,
+                  GitgProgress  progress,
+                  gchar const  *output,
+                  gpointer      data)
+{
+	RenameInfo *info = (RenameInfo *)data;
+	gchar const *oldname = gitg_ref_get_shortname (info->ref);
 
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "branch",
-	                                             "-m",
-	                                             oldname,
-	                                             newname,
-	                                             NULL),
-	                          NULL))
+	if (progress == GITG_PROGRESS_ERROR)
 	{
 		gint ret = message_dialog (window,
 		                           GTK_MESSAGE_ERROR,
 		                           _ ("Branch <%s> could not be renamed to <%s>"),
 		                           _ ("This usually means that a branch with that name already exists. Do you want to overwrite the branch?"),
 		                           _ ("Force rename"),
-		                           oldname, newname);
+		                           oldname, info->newname);
 
 		if (ret == GTK_RESPONSE_ACCEPT)
 		{
-			if (!gitg_shell_run_sync (gitg_command_new (repository,
-			                                             "branch",
-			                                             "-M",
-			                                             oldname,
-			                                             newname,
-			                                             NULL),
-			                         NULL))
-			{
-				message_dialog (window,
-				                GTK_MESSAGE_ERROR,
-				                _ ("Branch <%s> could not be forcefully renamed"),
-				                NULL,
-				                NULL,
-				                oldname);
-
-				return NULL;
-			}
-			else
-			{
-				gitg_repository_reload (repository);
-				return NULL;
-			}
+			run_step (window,
+			          gitg_command_new (gitg_window_get_repository (window),
+			                            "branch",
+			                            "-M",
+			                            oldname,
+			                            info->newname,
+			                            NULL),
+			          NULL,
+			          on_force_rename_result,
+			          info);
+
+			return;
 		}
 	}
-	else
+	else if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		gitg_repository_reload (repository);
-
-		return NULL;
+		reload (window);
 	}
 
-	return NULL;
+	rename_info_free (info);
+}
+
+static GitgShell *
+rename_branch (GitgWindow  *window,
+               GitgRef     *ref,
+               const gchar *newname)
+{
+	RenameInfo *info = g_slice_new (RenameInfo);
+
+	info->ref = gitg_ref_copy (ref);
+	info->newname = g_strdup (newname);
+
+	return run_command (window,
+	                    gitg_command_new (gitg_window_get_repository (window),
+	                                      "branch",
+	                                      "-m",
+	                                      gitg_ref_get_shortname (ref),
+	                                      newname,
+	                                      NULL),
+	                    NULL,
+	                    on_rename_result,
+	                    info);
 }
 
 static gchar *
@@ -682,179 +1154,154 @@ gitg_branch_actions_rename (GitgWindow *window,
 	return NULL;
 }
 
-static void
-reset_buffer (GitgShell *shell, GString *buffer)
-{
-	g_string_erase (buffer, 0, -1);
-}
-
-static void
-update_buffer (GitgShell *shell, gchar **lines, GString *buffer)
+typedef struct
 {
-	gchar **ptr = lines;
+	guint step;
 
-	while (ptr && *ptr)
-	{
-		if (buffer->len != 0)
-		{
-			g_string_append_c (buffer, '\n');
-		}
+	ProgressCallback callback;
+	gpointer callback_data;
+} ChangesInfo;
 
-		g_string_append (buffer, *ptr);
-		++ptr;
+static GitgCommand *
+changes_command (GitgRepository *repository,
+                 guint           step)
+{
+	switch (step)
+	{
+		case 0:
+			return gitg_command_new (repository,
+			                         "update-index",
+			                         "--refresh",
+			                         NULL);
+		case 1:
+			return gitg_command_new (repository,
+			                         "diff-files",
+			                         "--no-ext-diff",
+			                         "--quiet",
+			                         NULL);
+		case 2:
+			return gitg_command_new (repository,
+			                         "diff-index",
+			                         "--no-ext-diff",
+			                         "--cached",
+			                         "--quiet",
+			                         "HEAD",
+			                         "--",
+			                         NULL);
+		default:
+			return NULL;
 	}
 }
 
-static gboolean
-no_changes (GitgRepository *repository)
-{
-	return gitg_shell_run_sync (gitg_command_new (repository,
-	                                               "update-index",
-	                                               "--refresh",
-	                                               NULL),
-	                            NULL) &&
-	       gitg_shell_run_sync (gitg_command_new (repository,
-	                                               "diff-files",
-	                                               "--no-ext-diff",
-	                                               "--quiet",
-	                                               NULL),
-	                            NULL) &&
-	       gitg_shell_run_sync (gitg_command_new (repository,
-	                                               "diff-index",
-	                                               "--no-ext-diff",
-	                                               "--cached",
-	                                               "--quiet",
-	                                               "HEAD",
-	                                               "--",
-	                                               NULL),
-	                            NULL);
-}
-
-static gboolean
-stash_changes_real (GitgWindow *window, gchar **ref, gboolean storeref)
+static void
+on_changes_step (GitgWindow   *window,
+                 GitgProgress  progress,
+                 gchar const  *output,
+                 gpointer      data)
 {
-	GitgRepository *repository = gitg_window_get_repository (window);
-	gboolean ret;
-	gchar *tree = NULL;
-	gchar *commit = NULL;
-	gchar *head = NULL;
-	gchar *msg = NULL;
-	gboolean showerror = FALSE;
-
-	GitgShell *shell = gitg_shell_new_synchronized (1000);
-	GString *buffer = g_string_new ("");
+	ChangesInfo *info = (ChangesInfo *)data;
+	GitgCommand *command = NULL;
 
-	g_signal_connect (shell, "begin", G_CALLBACK (reset_buffer), buffer);
-	g_signal_connect (shell, "update", G_CALLBACK (update_buffer), buffer);
-
-	gchar const *secondary;
-
-	if (storeref)
+	if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		secondary = _ ("Do you want to temporarily stash these changes?");
-	}
-	else
-	{
-		secondary = _ ("Do you want to stash and reapply these changes?");
+		command = changes_command (gitg_window_get_repository (window),
+		                           ++info->step);
 	}
 
-	gint r = message_dialog (window,
-	                         GTK_MESSAGE_QUESTION,
-	                         _ ("You have uncommited changes in your current working tree"),
-	                         secondary,
-	                         _ ("Stash changes"));
-
-	if (r != GTK_RESPONSE_ACCEPT)
+	if (command)
 	{
-		ret = FALSE;
-		goto cleanup;
+		run_step (window, command, NULL, on_changes_step, info);
+		return;
 	}
 
-	gitg_shell_run (shell,
-	                gitg_command_new (repository,
-	                                   "log",
-	                                   "--no-color",
-	                                   "--abbrev-commit",
-	                                   "--pretty=oneline",
-	                                   "-n",
-	                                   "1",
-	                                   "HEAD",
-	                                   NULL),
-	                NULL);
-
-	GitgRef *working = gitg_repository_get_current_working_ref (repository);
+	info->callback (window, progress, info->callback_data);
+	g_slice_free (ChangesInfo, info);
+}
 
-	if (working)
-	{
-		msg = g_strconcat (gitg_ref_get_shortname (working), ": ", buffer->str, NULL);
-	}
-	else
-	{
-		msg = g_strconcat (" (no branch): ", buffer->str, NULL);
-	}
+/* Checks the work tree and the index for changes. The callback gets
+   GITG_PROGRESS_SUCCESS when there are none, GITG_PROGRESS_ERROR when
+   there are */
+static GitgShell *
+no_changes (GitgWindow       *window,
+            ProgressCallback  callback,
+            gpointer          callback_data)
+{
+	ChangesInfo *info = g_slice_new0 (ChangesInfo);
 
-	// Create tree object of the current index
-	gitg_shell_run (shell,
-	                gitg_command_new (repository,
-	                                   "write-tree",
-	                                   NULL),
-	                NULL);
+	info->callback = callback;
+	info->callback_data = callback_data;
 
-	if (buffer->len == 0)
-	{
-		ret = FALSE;
-		showerror = TRUE;
+	return run_command (window,
+	                    changes_command (gitg_window_get_repository (window), 0),
+	                    NULL,
+	                    on_changes_step,
+	                    info);
+}
 
-		goto cleanup;
-	}
+typedef enum
+{
+	STASH_STAGE_HEAD,
+	STASH_STAGE_INDEX_TREE,
+	STASH_STAGE_INDEX_COMMIT,
+	STASH_STAGE_READ_TREE,
+	STASH_STAGE_ADD,
+	STASH_STAGE_WORK_TREE,
+	STASH_STAGE_WORK_COMMIT,
+	STASH_STAGE_UPDATE_REF,
+	STASH_STAGE_RESET
+} StashStage;
 
-	tree = g_strndup (buffer->str, buffer->len);
-	head = gitg_repository_parse_head (repository);
+typedef struct
+{
+	StashStage stage;
 
-	gchar *idxmsg = g_strconcat ("index on ", msg, NULL);
+	gchar *head;
+	gchar *msg;
+	gchar *tree;
+	gchar *commit;
+	gchar *stash;
 
-	GInputStream *inp = g_memory_input_stream_new_from_data (idxmsg, -1, NULL);
-	gitg_io_set_input (GITG_IO (shell), inp);
-	g_object_unref (inp);
+	/* Copy of the index, to which the work tree is added */
+	GFile *index;
 
-	gitg_shell_run (shell,
-	                gitg_command_new (repository,
-	                                   "commit-tree",
-	                                   tree,
-	                                   "-p",
-	                                   head,
-	                                   NULL),
-	                NULL);
+	CommandCallback callback;
+	gpointer callback_data;
+} StashInfo;
 
-	g_free (idxmsg);
-	gitg_io_set_input (GITG_IO (shell), NULL);
+static void
+stash_info_free (StashInfo *info)
+{
+	g_free (info->head);
+	g_free (info->msg);
+	g_free (info->tree);
+	g_free (info->commit);
+	g_free (info->stash);
 
-	if (buffer->len == 0)
+	if (info->index)
 	{
-		ret = FALSE;
-		showerror = TRUE;
-
-		goto cleanup;
+		g_file_delete (info->index, NULL, NULL);
+		g_object_unref (info->index);
 	}
 
-	commit = g_strndup (buffer->str, buffer->len);
+	g_slice_free (StashInfo, info);
+}
 
-	// Working tree
+static GFile *
+copy_index (GitgRepository *repository)
+{
 	gchar *tmpname = NULL;
 	gint fd = g_file_open_tmp ("gitg-temp-index-XXXXXX", &tmpname, NULL);
 
 	if (fd == -1)
 	{
-		ret = FALSE;
-		showerror = TRUE;
-
-		goto cleanup;
+		return NULL;
 	}
 
-	GFile *customindex = g_file_new_for_path (tmpname);
-
 	close (fd);
 
+	GFile *customindex = g_file_new_for_path (tmpname);
+	g_free (tmpname);
+
 	GFile *git_dir = gitg_repository_get_git_dir (repository);
 	GFile *index_ = g_file_get_child (git_dir, "index");
 
@@ -865,328 +1312,665 @@ stash_changes_real (GitgWindow *window, gchar **ref, gboolean storeref)
 
 	if (!copied)
 	{
+		g_file_delete (customindex, NULL, NULL);
 		g_object_unref (customindex);
 
-		ret = FALSE;
-		showerror = TRUE;
-		goto cleanup;
+		return NULL;
 	}
 
-	tmpname = g_file_get_path (customindex);
-
-	GitgCommand *cmd_read_tree = gitg_command_new (repository,
-	                                                "read-tree",
-	                                                "-m",
-	                                                tree,
-	                                                NULL);
+	return customindex;
+}
 
-	gitg_command_add_environment (cmd_read_tree,
-	                              "GIT_INDEX_FILE",
-	                              tmpname,
-	                              NULL);
+static GitgCommand *
+stash_index_command (StashInfo      *info,
+                     GitgRepository *repository,
+                     ...)
+{
+	va_list ap;
+	gchar const **argv;
+	GitgCommand *command;
+	gchar *path;
 
-	GitgCommand *cmd_add = gitg_command_new (repository,
-	                                          "add",
-	                                          "-u",
-	                                          NULL);
+	va_start (ap, repository);
+	argv = parse_valist (ap);
+	va_end (ap);
 
-	gitg_command_add_environment (cmd_add,
-	                              "GIT_INDEX_FILE",
-	                              tmpname,
-	                              NULL);
+	command = gitg_command_newv (repository, argv);
+	g_free (argv);
 
-	GitgCommand *cmd_write_tree = gitg_command_new (repository,
-	                                                 "write-tree",
-	                                                 NULL);
+	path = g_file_get_path (info->index);
 
-	gitg_command_add_environment (cmd_write_tree,
+	gitg_command_add_environment (command,
 	                              "GIT_INDEX_FILE",
-	                              tmpname,
+	                              path,
 	                              NULL);
 
-	g_free (tmpname);
+	g_free (path);
+	return command;
+}
+
+static void
+create_stash_reflog (GitgRepository *repository)
+{
+	GFile *git_dir = gitg_repository_get_git_dir (repository);
+	gchar *git_path = g_file_get_path (git_dir);
 
-	gboolean writestash;
+	gchar *path = g_build_filename (git_path,
+	                                "logs",
+	                                "refs",
+	                                "stash",
+	                                NULL);
 
-	writestash = gitg_shell_run (shell, cmd_read_tree, NULL) &&
-	             gitg_shell_run (shell, cmd_add, NULL) &&
-	             gitg_shell_run (shell, cmd_write_tree, NULL);
+	g_object_unref (git_dir);
+	g_free (git_path);
 
-	g_file_delete (customindex, NULL, NULL);
-	g_object_unref (customindex);
+	GFile *reflog = g_file_new_for_path (path);
+	GFileOutputStream *stream = g_file_create (reflog, G_FILE_CREATE_NONE, NULL, NULL);
 
-	if (!writestash)
+	if (stream)
 	{
-		ret = FALSE;
-		showerror = TRUE;
-
-		goto cleanup;
+		g_output_stream_close (G_OUTPUT_STREAM (stream), NULL, NULL);
+		g_object_unref (stream);
 	}
 
-	gchar *stashtree = g_strndup (buffer->str, buffer->len);
-	gchar *reason = g_strconcat ("gitg auto stash: ", msg, NULL);
+	g_object_unref (reflog);
+	g_free (path);
+}
 
-	inp = g_memory_input_stream_new_from_data (reason, -1, NULL);
-	gitg_io_set_input (GITG_IO (shell), inp);
-	g_object_unref (inp);
+static void
+on_stash_step (GitgWindow   *window,
+               GitgProgress  progress,
+               gchar const  *output,
+               gpointer      data)
+{
+	StashInfo *info = (StashInfo *)data;
+	GitgRepository *repository = gitg_window_get_repository (window);
+	GitgCommand *command = NULL;
+	gchar *input = NULL;
+	gchar const *sep;
 
-	gitg_shell_run (shell,
-	                gitg_command_new (repository,
-	                                   "commit-tree",
-	                                   stashtree,
-	                                   "-p",
-	                                   head,
-	                                   "-p",
-	                                   commit,
-	                                   NULL),
-	                NULL);
+	if (progress != GITG_PROGRESS_SUCCESS)
+	{
+		goto failed;
+	}
 
-	gitg_io_set_input (GITG_IO (shell), NULL);
+	switch (info->stage)
+	{
+		case STASH_STAGE_HEAD:
+		{
+			/* The full hash, followed by the abbreviated oneline */
+			sep = strchr (output, '\n');
 
-	g_free (stashtree);
+			if (!sep)
+			{
+				goto failed;
+			}
 
-	if (buffer->len == 0)
-	{
-		g_free (reason);
+			GitgRef *working = gitg_repository_get_current_working_ref (repository);
 
-		ret = FALSE;
-		showerror = TRUE;
+			info->head = g_strndup (output, sep - output);
+			info->msg = g_strconcat (working ? gitg_ref_get_shortname (working) : " (no branch)",
+			                         ": ",
+			                         sep + 1,
+			                         NULL);
 
-		goto cleanup;
-	}
+			// Create tree object of the current index
+			command = gitg_command_new (repository, "write-tree", NULL);
+			info->stage = STASH_STAGE_INDEX_TREE;
+		}
+		break;
+		case STASH_STAGE_INDEX_TREE:
+			if (!*output)
+			{
+				goto failed;
+			}
 
-	gchar *rref = g_strndup (buffer->str, buffer->len);
+			info->tree = g_strdup (output);
 
-	if (ref)
-	{
-		*ref = g_strdup (rref);
-	}
+			command = gitg_command_new (repository,
+			                            "commit-tree",
+			                            info->tree,
+			                            "-p",
+			                            info->head,
+			                            NULL);
 
-	git_dir = gitg_repository_get_git_dir (repository);
-	gchar *git_path = g_file_get_path (git_dir);
+			input = g_strconcat ("index on ", info->msg, NULL);
+			info->stage = STASH_STAGE_INDEX_COMMIT;
+		break;
+		case STASH_STAGE_INDEX_COMMIT:
+			if (!*output)
+			{
+				goto failed;
+			}
 
-	gchar *path = g_build_filename (git_path,
-	                                "logs",
-	                                "refs",
-	                                "stash",
-	                                NULL);
+			info->commit = g_strdup (output);
 
-	g_object_unref (git_dir);
-	g_free (git_path);
+			// Working tree
+			info->index = copy_index (repository);
 
-	GFile *reflog = g_file_new_for_path (path);
-	GFileOutputStream *stream = g_file_create (reflog, G_FILE_CREATE_NONE, NULL, NULL);
+			if (!info->index)
+			{
+				goto failed;
+			}
 
-	g_output_stream_close (G_OUTPUT_STREAM (stream), NULL, NULL);
+			command = stash_index_command (info,
+			                               repository,
+			                               "read-tree",
+			                               "-m",
+			                               info->tree,
+			                               NULL);
 
-	g_object_unref (stream);
-	g_object_unref (reflog);
+			info->stage = STASH_STAGE_READ_TREE;
+		break;
+		case STASH_STAGE_READ_TREE:
+			command = stash_index_command (info, repository, "add", "-u", NULL);
+			info->stage = STASH_STAGE_ADD;
+		break;
+		case STASH_STAGE_ADD:
+			command = stash_index_command (info, repository, "write-tree", NULL);
+			info->stage = STASH_STAGE_WORK_TREE;
+		break;
+		case STASH_STAGE_WORK_TREE:
+			if (!*output)
+			{
+				goto failed;
+			}
 
-	g_free (path);
+			command = gitg_command_new (repository,
+			                            "commit-tree",
+			                            output,
+			                            "-p",
+			                            info->head,
+			                            "-p",
+			                            info->commit,
+			                            NULL);
+
+			input = g_strconcat ("gitg auto stash: ", info->msg, NULL);
+			info->stage = STASH_STAGE_WORK_COMMIT;
+		break;
+		case STASH_STAGE_WORK_COMMIT:
+		{
+			if (!*output)
+			{
+				goto failed;
+			}
+
+			info->stash = g_strdup (output);
+			create_stash_reflog (repository);
+
+			gchar *reason = g_strconcat ("gitg auto stash: ", info->msg, NULL);
+
+			command = gitg_command_new (repository,
+			                            "update-ref",
+			                            "-m",
+			                            reason,
+			                            "refs/stash",
+			                            info->stash,
+			                            NULL);
+
+			g_free (reason);
+			info->stage = STASH_STAGE_UPDATE_REF;
+		}
+		break;
+		case STASH_STAGE_UPDATE_REF:
+			command = gitg_command_new (repository, "reset", "--hard", NULL);
+			info->stage = STASH_STAGE_RESET;
+		break;
+		case STASH_STAGE_RESET:
+			info->callback (window,
+			                GITG_PROGRESS_SUCCESS,
+			                info->stash,
+			                info->callback_data);
+
+			stash_info_free (info);
+			return;
+	}
+
+	run_step (window, command, input, on_stash_step, info);
+	g_free (input);
 
-	gitg_shell_run (shell,
-	                gitg_command_new (repository,
-	                                   "update-ref",
-	                                   "-m",
-	                                   reason,
-	                                   "refs/stash",
-	                                   rref,
-	                                   NULL),
-	                NULL);
-
-	g_free (rref);
-
-	gitg_shell_run (shell,
-	                gitg_command_new (repository,
-	                                   "reset",
-	                                   "--hard",
-	                                   NULL),
-	                NULL);
-
-	ret = TRUE;
-
-cleanup:
-	g_string_free (buffer, TRUE);
-	g_object_unref (shell);
-	g_free (commit);
-	g_free (tree);
-	g_free (head);
-	g_free (msg);
-
-	if (showerror)
+	return;
+
+failed:
+	if (progress != GITG_PROGRESS_CANCELLED)
 	{
 		message_dialog (window,
 		                GTK_MESSAGE_ERROR,
 		                _ ("Failed to save current index state"),
 		                NULL,
 		                NULL);
+
+		progress = GITG_PROGRESS_ERROR;
 	}
 
-	return ret;
+	info->callback (window, progress, NULL, info->callback_data);
+	stash_info_free (info);
 }
 
-static gboolean
-stash_changes (GitgWindow *window, gchar **ref, gboolean storeref)
+/* Asks to stash the changes in the work tree and stashes them. The
+   callback gets the stash commit, or GITG_PROGRESS_CANCELLED when the
+   changes should not be stashed */
+static void
+stash_changes_real (GitgWindow      *window,
+                    gboolean         storeref,
+                    CommandCallback  callback,
+                    gpointer         callback_data)
 {
-	if (no_changes (gitg_window_get_repository (window)))
+	gchar const *secondary;
+
+	if (storeref)
 	{
-		if (ref)
-		{
-			*ref = NULL;
-		}
+		secondary = _ ("Do you want to temporarily stash these changes?");
+	}
+	else
+	{
+		secondary = _ ("Do you want to stash and reapply these changes?");
+	}
+
+	gint r = message_dialog (window,
+	                         GTK_MESSAGE_QUESTION,
+	                         _ ("You have uncommited changes in your current working tree"),
+	                         secondary,
+	                         _ ("Stash changes"));
 
-		return TRUE;
+	if (r != GTK_RESPONSE_ACCEPT)
+	{
+		callback (window, GITG_PROGRESS_CANCELLED, NULL, callback_data);
+		return;
 	}
 
-	return stash_changes_real (window, ref, storeref);
+	StashInfo *info = g_slice_new0 (StashInfo);
+
+	info->stage = STASH_STAGE_HEAD;
+	info->callback = callback;
+	info->callback_data = callback_data;
+
+	run_step (window,
+	          gitg_command_new (gitg_window_get_repository (window),
+	                            "log",
+	                            "--no-color",
+	                            "--abbrev-commit",
+	                            "--pretty=format:%H%n%h %s",
+	                            "-n",
+	                            "1",
+	                            "HEAD",
+	                            NULL),
+	          NULL,
+	          on_stash_step,
+	          info);
 }
 
-static gboolean
-checkout_local_branch_real (GitgWindow *window, GitgRef *ref)
+typedef struct
 {
-	GitgRepository *repository = gitg_window_get_repository (window);
+	gboolean storeref;
+
+	CommandCallback callback;
+	gpointer callback_data;
+} StashChangesInfo;
 
-	return gitg_shell_run_sync (gitg_command_new (repository,
-	                                               "checkout",
-	                                               gitg_ref_get_shortname (ref),
-	                                               NULL),
-	                            NULL);
+static void
+on_stash_changes_checked (GitgWindow   *window,
+                          GitgProgress  progress,
+                          gpointer      data)
+{
+	StashChangesInfo *info = (StashChangesInfo *)data;
+
+	if (progress == GITG_PROGRESS_ERROR)
+	{
+		stash_changes_real (window,
+		                    info->storeref,
+		                    info->callback,
+		                    info->callback_data);
+	}
+	else
+	{
+		/* Nothing to stash */
+		info->callback (window, progress, NULL, info->callback_data);
+	}
+
+	g_slice_free (StashChangesInfo, info);
 }
 
-static gboolean
-checkout_local_branch (GitgWindow *window,
-                       GitgRef    *ref)
+/* Stashes the changes in the work tree, if there are any. The callback
+   gets the stash commit, or NULL when nothing had to be stashed */
+static GitgShell *
+stash_changes (GitgWindow      *window,
+               gboolean         storeref,
+               CommandCallback  callback,
+               gpointer         callback_data)
 {
-	if (!stash_changes (window, NULL, TRUE))
+	StashChangesInfo *info = g_slice_new (StashChangesInfo);
+
+	info->storeref = storeref;
+	info->callback = callback;
+	info->callback_data = callback_data;
+
+	return no_changes (window, on_stash_changes_checked, info);
+}
+
+static void
+on_checkout_result (GitgWindow   *window,
+                    GitgProgress  progress,
+                    gpointer      data)
+{
+	GitgRef *ref = (GitgRef *)data;
+	gchar const *name = gitg_ref_get_shortname (ref);
+	gchar const *local = gitg_ref_get_local_name (ref);
+
+	if (progress == GITG_PROGRESS_ERROR)
 	{
-		return FALSE;
+		switch (gitg_ref_get_ref_type (ref))
+		{
+			case GITG_REF_TYPE_REMOTE:
+				message_dialog (window,
+				                GTK_MESSAGE_ERROR,
+				                _ ("Failed to checkout remote branch <%s> to local branch <%s>"),
+				                NULL,
+				                NULL,
+				                name,
+				                local);
+			break;
+			case GITG_REF_TYPE_TAG:
+				message_dialog (window,
+				                GTK_MESSAGE_ERROR,
+				                _ ("Failed to checkout tag <%s> to local branch <%s>"),
+				                NULL,
+				                NULL,
+				                name,
+				                name);
+			break;
+			default:
+				message_dialog (window,
+				                GTK_MESSAGE_ERROR,
+				                _ ("Failed to checkout local branch <%s>"),
+				                NULL,
+				                NULL,
+				                name);
+			break;
+		}
 	}
+	else if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		if (gitg_ref_get_ref_type (ref) == GITG_REF_TYPE_REMOTE)
+		{
+			name = local;
+		}
 
+		gitg_repository_load (gitg_window_get_repository (window),
+		                      1,
+		                      &name,
+		                      NULL);
+	}
+
+	gitg_ref_free (ref);
+}
+
+static GitgShell *
+checkout_ref (GitgWindow       *window,
+              GitgRef          *ref,
+              ProgressCallback  callback,
+              gpointer          callback_data)
+{
 	gchar const *name = gitg_ref_get_shortname (ref);
+	gchar *message = g_strdup_printf (_ ("Checking out <%s>"), name);
+	GitgShell *ret;
 
-	if (!checkout_local_branch_real (window, ref))
+	switch (gitg_ref_get_ref_type (ref))
 	{
-		message_dialog (window,
-		                GTK_MESSAGE_ERROR,
-		                _ ("Failed to checkout local branch <%s>"),
-		                NULL,
-		                NULL,
-		                name);
-		return FALSE;
+		case GITG_REF_TYPE_REMOTE:
+			ret = run_progress (window,
+			                    _ ("Checkout"),
+			                    message,
+			                    TRUE,
+			                    callback,
+			                    callback_data,
+			                    "checkout",
+			                    "--progress",
+			                    "--track",
+			                    "-b",
+			                    gitg_ref_get_local_name (ref),
+			                    name,
+			                    NULL);
+		break;
+		case GITG_REF_TYPE_TAG:
+			ret = run_progress (window,
+			                    _ ("Checkout"),
+			                    message,
+			                    TRUE,
+			                    callback,
+			                    callback_data,
+			                    "checkout",
+			                    "--progress",
+			                    "-b",
+			                    name,
+			                    name,
+			                    NULL);
+		break;
+		default:
+			ret = run_progress (window,
+			                    _ ("Checkout"),
+			                    message,
+			                    TRUE,
+			                    callback,
+			                    callback_data,
+			                    "checkout",
+			                    "--progress",
+			                    name,
+			                    NULL);
+		break;
 	}
-	else
+
+	g_free (message);
+	return ret;
+}
+
+static void
+on_checkout_stashed (GitgWindow   *window,
+                     GitgProgress  progress,
+                     gchar const  *output,
+                     gpointer      data)
+{
+	GitgRef *ref = (GitgRef *)data;
+
+	if (progress != GITG_PROGRESS_SUCCESS)
 	{
-		gitg_repository_load (gitg_window_get_repository (window), 1, (gchar const **)&name, NULL);
-		return TRUE;
+		gitg_ref_free (ref);
+		return;
 	}
+
+	gitg_window_add_branch_action (window,
+	                               checkout_ref (window,
+	                                             ref,
+	                                             on_checkout_result,
+	                                             ref));
 }
 
-static gboolean
-checkout_remote_branch (GitgWindow *window,
-                        GitgRef    *ref)
+GitgShell *
+gitg_branch_actions_checkout (GitgWindow *window,
+                              GitgRef    *ref)
 {
-	if (!stash_changes (window, NULL, TRUE))
+	g_return_val_if_fail (GITG_IS_WINDOW (window), NULL);
+
+	switch (gitg_ref_get_ref_type (ref))
 	{
-		return FALSE;
+		case GITG_REF_TYPE_BRANCH:
+		case GITG_REF_TYPE_REMOTE:
+		case GITG_REF_TYPE_TAG:
+			return stash_changes (window,
+			                      TRUE,
+			                      on_checkout_stashed,
+			                      gitg_ref_copy (ref));
+		default:
+			return NULL;
 	}
+}
 
-	GitgRepository *repository = gitg_window_get_repository (window);
-	gchar const *name = gitg_ref_get_shortname (ref);
-	gchar const *local = gitg_ref_get_local_name (ref);
-	gboolean ret;
+typedef struct
+{
+	GitgRef *head;
+	gchar *stashcommit;
+
+	/* Whether head has to be checked out again */
+	gboolean checkout;
+} RestoreInfo;
 
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "checkout",
-	                                             "--track",
-	                                             "-b",
-	                                             local,
-	                                             name,
-	                                             NULL),
-	                          NULL))
+static void
+restore_info_free (RestoreInfo *info)
+{
+	gitg_ref_free (info->head);
+	g_free (info->stashcommit);
+
+	g_slice_free (RestoreInfo, info);
+}
+
+static void
+restore_done (GitgWindow  *window,
+              RestoreInfo *info)
+{
+	/* Only the checked out branch moved when nothing was stashed or
+	   checked out in between */
+	if (!info->checkout && !info->stashcommit)
 	{
-		message_dialog (window,
-		                GTK_MESSAGE_ERROR,
-		                _ ("Failed to checkout remote branch <%s> to local branch <%s>"),
-		                NULL,
-		                NULL,
-		                name,
-		                local);
-		ret = FALSE;
+		refresh_head (window);
 	}
 	else
 	{
-		gitg_repository_load (repository, 1, (gchar const **)&local, NULL);
-		ret = TRUE;
+		reload (window);
 	}
 
-	return ret;
+	restore_info_free (info);
 }
 
-static gboolean
-checkout_tag (GitgWindow *window,
-              GitgRef    *ref)
+static void
+on_stash_saved (GitgWindow   *window,
+                GitgProgress  progress,
+                gchar const  *output,
+                gpointer      data)
 {
-	if (!stash_changes (window, NULL, TRUE))
+	restore_done (window, (RestoreInfo *)data);
+}
+
+static void
+save_stash (GitgWindow  *window,
+            RestoreInfo *info)
+{
+	run_step (window,
+	          gitg_command_new (gitg_window_get_repository (window),
+	                            "update-ref",
+	                            "-m",
+	                            "gitg autosave stash",
+	                            "refs/stash",
+	                            info->stashcommit,
+	                            NULL),
+	          NULL,
+	          on_stash_saved,
+	          info);
+}
+
+static void
+on_stash_reapplied (GitgWindow   *window,
+                    GitgProgress  progress,
+                    gchar const  *output,
+                    gpointer      data)
+{
+	RestoreInfo *info = (RestoreInfo *)data;
+
+	if (progress == GITG_PROGRESS_ERROR)
 	{
-		return FALSE;
+		message_dialog (window,
+		                GTK_MESSAGE_ERROR,
+		                _ ("Failed to reapply stash correctly"),
+		                _ ("There might be unresolved conflicts in the working tree or index which you need to resolve manually"),
+		                NULL);
 	}
 
-	GitgRepository *repository = gitg_window_get_repository (window);
-	gchar const *name = gitg_ref_get_shortname (ref);
-	gboolean ret;
+	if (progress != GITG_PROGRESS_SUCCESS)
+	{
+		save_stash (window, info);
+	}
+	else
+	{
+		restore_done (window, info);
+	}
+}
 
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "checkout",
-	                                             "-b",
-	                                             name,
-	                                             name,
-	                                             NULL),
-	                         NULL))
+static void
+on_head_restored (GitgWindow   *window,
+                  GitgProgress  progress,
+                  gpointer      data)
+{
+	RestoreInfo *info = (RestoreInfo *)data;
+
+	if (progress != GITG_PROGRESS_SUCCESS)
 	{
+		gchar const *message = NULL;
+
+		if (info->stashcommit)
+		{
+			message = _ ("The stashed changes have been stored to be reapplied manually");
+		}
+
 		message_dialog (window,
 		                GTK_MESSAGE_ERROR,
-		                _ ("Failed to checkout tag <%s> to local branch <%s>"),
-		                NULL,
-		                NULL,
-		                name,
-		                name);
-		ret = FALSE;
+		                _ ("Failed to checkout previously checked out branch"),
+		                message,
+		                NULL);
+
+		if (info->stashcommit)
+		{
+			save_stash (window, info);
+		}
+		else
+		{
+			restore_done (window, info);
+		}
+	}
+	else if (info->stashcommit)
+	{
+		// Reapply stash
+		run_step (window,
+		          gitg_command_new (gitg_window_get_repository (window),
+		                            "stash",
+		                            "apply",
+		                            "--index",
+		                            info->stashcommit,
+		                            NULL),
+		          NULL,
+		          on_stash_reapplied,
+		          info);
 	}
 	else
 	{
-		gitg_repository_load (repository, 1, (gchar const **)&name, NULL);
-		ret = TRUE;
+		restore_done (window, info);
 	}
-
-	return ret;
 }
 
-gboolean
-gitg_branch_actions_checkout (GitgWindow *window,
-                              GitgRef    *ref)
+/* Checks out head again after an action which needed another branch to be
+   checked out, and reapplies the changes stashed before the action */
+static void
+restore_head (GitgWindow  *window,
+              GitgRef     *head,
+              gchar const *stashcommit,
+              gboolean     checkout)
 {
-	g_return_val_if_fail (GITG_IS_WINDOW (window), FALSE);
+	RestoreInfo *info = g_slice_new (RestoreInfo);
 
-	GitgRef *cp = gitg_ref_copy (ref);
-	gboolean ret = FALSE;
+	info->head = gitg_ref_copy (head);
+	info->stashcommit = g_strdup (stashcommit);
+	info->checkout = checkout && head != NULL;
 
-	switch (gitg_ref_get_ref_type (cp))
+	if (info->checkout)
 	{
-		case GITG_REF_TYPE_BRANCH:
-			ret = checkout_local_branch (window, cp);
-		break;
-		case GITG_REF_TYPE_REMOTE:
-			ret = checkout_remote_branch (window, cp);
-		break;
-		case GITG_REF_TYPE_TAG:
-			ret = checkout_tag (window, cp);
-		break;
-		default:
-		break;
+		gitg_window_add_branch_action (window,
+		                               checkout_ref (window,
+		                                             head,
+		                                             on_head_restored,
+		                                             info));
+	}
+	else
+	{
+		on_head_restored (window, GITG_PROGRESS_SUCCESS, info);
 	}
-
-	gitg_ref_free (cp);
-	return ret;
 }
 
 typedef struct
@@ -1255,65 +2039,79 @@ on_merge_rebase_result (GitgWindow   *window,
 	}
 	else if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		GitgRepository *repository = gitg_window_get_repository (window);
-
 		// Checkout head
-		if (!checkout_local_branch_real (window, info->head))
-		{
-			gchar const *message = NULL;
+		restore_head (window, info->head, info->stashcommit, TRUE);
+	}
 
-			if (info->stashcommit)
-			{
-				gitg_shell_run_sync (gitg_command_new (repository,
-				                                        "update-ref",
-				                                        "-m",
-				                                        "gitg autosave stash",
-				                                        "refs/stash",
-				                                        info->stashcommit,
-				                                        NULL),
-				                     NULL);
-
-				message = _ ("The stashed changes have been stored to be reapplied manually");
-			}
+	ref_info_free (info);
+}
 
+static void
+on_merge_checkout (GitgWindow   *window,
+                   GitgProgress  progress,
+                   gpointer      data)
+{
+	RefInfo *info = (RefInfo *)data;
+
+	if (progress != GITG_PROGRESS_SUCCESS)
+	{
+		if (progress == GITG_PROGRESS_ERROR)
+		{
 			message_dialog (window,
 			                GTK_MESSAGE_ERROR,
-			                _ ("Failed to checkout previously checked out branch"),
-			                message,
-			                NULL);
+			                _ ("Failed to checkout local branch <%s>"),
+			                _ ("The branch on which to merge could not be checked out"),
+			                NULL,
+			                gitg_ref_get_shortname (info->dest));
 		}
-		else if (info->stashcommit)
-		{
-			// Reapply stash
-			if (!gitg_shell_run_sync (gitg_command_new (gitg_window_get_repository (window),
-			                                             "stash",
-			                                             "apply",
-			                                             "--index",
-			                                             info->stashcommit,
-			                                             NULL),
-			                          NULL))
-			{
-				gitg_shell_run_sync (gitg_command_new (repository,
-				                                        "update-ref",
-				                                        "-m",
-				                                        "gitg autosave stash",
-				                                        "refs/stash",
-				                                        info->stashcommit,
-				                                        NULL),
-				                     NULL);
 
-				message_dialog (window,
-				                GTK_MESSAGE_ERROR,
-				                _ ("Failed to reapply stash correctly"),
-				                _ ("There might be unresolved conflicts in the working tree or index which you need to resolve manually"),
-				                NULL);
-			}
-		}
+		ref_info_free (info);
+		return;
+	}
 
-		gitg_repository_reload (gitg_window_get_repository (window));
+	gchar *message = g_strdup_printf (_ ("Merging %s branch <%s> onto %s branch <%s>"),
+	                                  gitg_ref_get_ref_type (info->source) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
+	                                  gitg_ref_get_shortname (info->source),
+	                                  gitg_ref_get_ref_type (info->dest) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
+	                                  gitg_ref_get_shortname (info->dest));
+
+	gitg_window_add_branch_action (window,
+	                               run_progress (window,
+	                                             _ ("Merge"),
+	                                             message,
+	                                             TRUE,
+	                                             on_merge_rebase_result,
+	                                             info,
+	                                             "merge",
+	                                             "--progress",
+	                                             gitg_ref_get_shortname (info->source),
+	                                             NULL));
+
+	g_free (message);
+}
+
+static void
+on_merge_stashed (GitgWindow   *window,
+                  GitgProgress  progress,
+                  gchar const  *output,
+                  gpointer      data)
+{
+	RefInfo *info = (RefInfo *)data;
+
+	if (progress != GITG_PROGRESS_SUCCESS)
+	{
+		ref_info_free (info);
+		return;
 	}
 
-	ref_info_free (info);
+	info->stashcommit = g_strdup (output);
+
+	// First checkout the correct branch on which to merge, e.g. dest
+	gitg_window_add_branch_action (window,
+	                               checkout_ref (window,
+	                                             info->dest,
+	                                             on_merge_checkout,
+	                                             info));
 }
 
 GitgShell *
@@ -1344,57 +2142,87 @@ gitg_branch_actions_merge (GitgWindow *window,
 
 	g_free (message);
 	GitgRepository *repository = gitg_window_get_repository (window);
-	gchar *stashcommit = NULL;
 
-	if (!stash_changes (window, &stashcommit, FALSE))
-	{
-		return NULL;
-	}
+	RefInfo *info = ref_info_new (source, dest);
+	info->head = gitg_ref_copy (gitg_repository_get_current_working_ref (repository));
+	info->rebase = FALSE;
 
-	GitgRef *head = gitg_repository_get_current_working_ref (repository);
+	return stash_changes (window, FALSE, on_merge_stashed, info);
+}
 
-	// First checkout the correct branch on which to merge, e.g. dest
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "checkout",
-	                                             gitg_ref_get_shortname (dest),
-	                                             NULL),
-	                          NULL))
-	{
-		g_free (stashcommit);
+static void
+on_rebase_stashed (GitgWindow   *window,
+                   GitgProgress  progress,
+                   gchar const  *output,
+                   gpointer      data)
+{
+	RefInfo *info = (RefInfo *)data;
 
-		message_dialog (window,
-		                GTK_MESSAGE_ERROR,
-		                _ ("Failed to checkout local branch <%s>"),
-		                _ ("The branch on which to merge could not be checked out"),
-		                NULL,
-		                gitg_ref_get_shortname (dest));
-		return NULL;
+	if (progress != GITG_PROGRESS_SUCCESS)
+	{
+		ref_info_free (info);
+		return;
 	}
 
-	message = g_strdup_printf (_ ("Merging %s branch <%s> onto %s branch <%s>"),
-	                           gitg_ref_get_ref_type (source) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
-	                           gitg_ref_get_shortname (source),
-	                           gitg_ref_get_ref_type (dest) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
-	                           gitg_ref_get_shortname (dest));
+	info->stashcommit = g_strdup (output);
 
-	GitgShell *ret;
-	RefInfo *info = ref_info_new (source, dest);
-	info->stashcommit = stashcommit;
-	info->head = gitg_ref_copy (head);
-	info->rebase = FALSE;
+	gchar *merge_head = gitg_hash_hash_to_sha1_new (gitg_ref_get_hash (info->dest));
 
-	ret = run_progress (window,
-	                    _ ("Merge"),
-	                    message,
-	                    on_merge_rebase_result,
-	                    info,
-	                    "merge",
-	                    gitg_ref_get_shortname (source),
-	                    NULL);
+	gchar *message = g_strdup_printf (_ ("Rebasing %s branch <%s> onto %s branch <%s>"),
+	                                  gitg_ref_get_ref_type (info->source) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
+	                                  gitg_ref_get_shortname (info->source),
+	                                  gitg_ref_get_ref_type (info->dest) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
+	                                  gitg_ref_get_shortname (info->dest));
+
+	/* rebase has no --progress, it reports "Rebasing (n/m)" by itself */
+	gitg_window_add_branch_action (window,
+	                               run_progress (window,
+	                                             _ ("Rebase"),
+	                                             message,
+	                                             TRUE,
+	                                             on_merge_rebase_result,
+	                                             info,
+	                                             "rebase",
+	                                             merge_head,
+	                                             gitg_ref_get_shortname (info->source),
+	                                             NULL));
 
 	g_free (message);
+	g_free (merge_head);
+}
 
-	return ret;
+static void
+on_rebase_checked (GitgWindow   *window,
+                   GitgProgress  progress,
+                   gpointer      data)
+{
+	RefInfo *info = (RefInfo *)data;
+
+	if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		on_rebase_stashed (window, GITG_PROGRESS_SUCCESS, NULL, info);
+	}
+	else if (progress == GITG_PROGRESS_CANCELLED)
+	{
+		ref_info_free (info);
+	}
+	else if (info->head &&
+	         gitg_hash_hash_equal (gitg_ref_get_hash (info->head),
+	                               gitg_ref_get_hash (info->dest)))
+	{
+		// Destination is current HEAD
+		message_dialog (window,
+		                GTK_MESSAGE_ERROR,
+		                _ ("Unable to rebase"),
+		                _ ("There are still uncommitted changes in your working tree and you are trying to rebase a branch onto the currently checked out branch. Either remove, stash or commit your changes first and try again"),
+		                NULL);
+
+		ref_info_free (info);
+	}
+	else
+	{
+		stash_changes_real (window, FALSE, on_rebase_stashed, info);
+	}
 }
 
 GitgShell *
@@ -1425,61 +2253,12 @@ gitg_branch_actions_rebase (GitgWindow *window,
 
 	g_free (message);
 	GitgRepository *repository = gitg_window_get_repository (window);
-	gchar *stashcommit = NULL;
-
-	if (!no_changes (repository))
-	{
-		// Check if destination is current HEAD
-		gchar *head = gitg_repository_parse_head (repository);
-		GitgHash hash;
-
-		gitg_hash_sha1_to_hash (head, hash);
-		g_free (head);
-
-		if (gitg_hash_hash_equal (hash, gitg_ref_get_hash (dest)))
-		{
-			message_dialog (window,
-			                GTK_MESSAGE_ERROR,
-			                _ ("Unable to rebase"),
-			                _ ("There are still uncommitted changes in your working tree and you are trying to rebase a branch onto the currently checked out branch. Either remove, stash or commit your changes first and try again"),
-			                NULL);
-			return NULL;
-		}
-
-		if (!stash_changes_real (window, &stashcommit, FALSE))
-		{
-			return NULL;
-		}
-	}
-
-	gchar *merge_head = gitg_hash_hash_to_sha1_new (gitg_ref_get_hash (dest));
-
-	message = g_strdup_printf (_ ("Rebasing %s branch <%s> onto %s branch <%s>"),
-	                           gitg_ref_get_ref_type (source) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
-	                           gitg_ref_get_shortname (source),
-	                           gitg_ref_get_ref_type (dest) == GITG_REF_TYPE_BRANCH ? _ ("local") : _ ("remote"),
-	                           gitg_ref_get_shortname (dest));
-
-	GitgShell *ret;
-	RefInfo *info = ref_info_new (source, dest);
-	info->stashcommit = stashcommit;
-	info->head = gitg_ref_copy (gitg_repository_get_current_working_ref (repository));
-	info->rebase = TRUE;
-
-	ret = run_progress (window,
-	                    _ ("Rebase"),
-	                    message,
-	                    on_merge_rebase_result,
-	                    info,
-	                    "rebase",
-	                    merge_head,
-	                    gitg_ref_get_shortname (source),
-	                    NULL);
-
-	g_free (message);
-	g_free (merge_head);
 
-	return ret;
+	RefInfo *info = ref_info_new (source, dest);
+	info->head = gitg_ref_copy (gitg_repository_get_current_working_ref (repository));
+	info->rebase = TRUE;
+
+	return no_changes (window, on_rebase_checked, info);
 }
 
 static void
@@ -1546,15 +2325,22 @@ gitg_branch_actions_push (GitgWindow *window,
 	GitgShell *ret;
 	RefInfo *info = ref_info_new (source, dest);
 
-	ret = run_progress (window,
-	                    _ ("Push"),
-	                    message,
-	                    on_push_result,
-	                    info,
-	                    "push",
-	                    prefix,
-	                    spec,
-	                    NULL);
+	gchar const *argv[] = {
+		"push",
+		"--progress",
+		prefix,
+		spec,
+		NULL
+	};
+
+	ret = run_progress_argv (window,
+	                         _ ("Push"),
+	                         message,
+	                         NULL,
+	                         TRUE,
+	                         on_push_result,
+	                         info,
+	                         argv);
 
 	g_free (message);
 	g_free (spec);
@@ -1603,15 +2389,22 @@ gitg_branch_actions_push_remote (GitgWindow  *window,
 	RefInfo *info = ref_info_new (source, rmref);
 	gitg_ref_free (rmref);
 
-	ret = run_progress (window,
-	                    _ ("Push"),
-	                    message,
-	                    on_push_result,
-	                    info,
-	                    "push",
-	                    remote,
-	                    spec,
-	                    NULL);
+	gchar const *argv[] = {
+		"push",
+		"--progress",
+		remote,
+		spec,
+		NULL
+	};
+
+	ret = run_progress_argv (window,
+	                         _ ("Push"),
+	                         message,
+	                         NULL,
+	                         TRUE,
+	                         on_push_result,
+	                         info,
+	                         argv);
 
 	g_free (message);
 	g_free (spec);
@@ -1619,159 +2412,237 @@ gitg_branch_actions_push_remote (GitgWindow  *window,
 	return ret;
 }
 
-gboolean
-gitg_branch_actions_apply_stash (GitgWindow *window,
-                                 GitgRef    *stash,
-                                 GitgRef    *branch)
+typedef struct
 {
-	g_return_val_if_fail (GITG_IS_WINDOW (window), FALSE);
-	g_return_val_if_fail (gitg_ref_get_ref_type (stash) == GITG_REF_TYPE_STASH, FALSE);
-	g_return_val_if_fail (gitg_ref_get_ref_type (branch) == GITG_REF_TYPE_BRANCH, FALSE);
+	GitgRef *stash;
+	GitgRef *branch;
+	GitgRef *current;
+} ApplyStashInfo;
 
-	gchar *message = g_strdup_printf (_ ("Are you sure you want to apply the stash item to local branch <%s>?"),
-	                                  gitg_ref_get_shortname (branch));
+static void
+apply_stash_info_free (ApplyStashInfo *info)
+{
+	gitg_ref_free (info->stash);
+	gitg_ref_free (info->branch);
+	gitg_ref_free (info->current);
 
-	if (message_dialog (window,
-	                    GTK_MESSAGE_QUESTION,
-	                    _ ("Apply stash"),
-	                    message,
-	                    _ ("Apply stash")) != GTK_RESPONSE_ACCEPT)
-	{
-		g_free (message);
-		return FALSE;
-	}
+	g_slice_free (ApplyStashInfo, info);
+}
 
-	GitgRepository *repository = gitg_window_get_repository (window);
-	GitgRef *current = gitg_repository_get_current_working_ref (repository);
+static void
+on_apply_stash_checked (GitgWindow   *window,
+                        GitgProgress  progress,
+                        gpointer      data)
+{
+	ApplyStashInfo *info = (ApplyStashInfo *)data;
 
-	if (!gitg_ref_equal (branch, current))
+	if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		if (!stash_changes (window, NULL, TRUE))
-		{
-			return FALSE;
-		}
-
-		if (!checkout_local_branch_real (window, branch))
-		{
-			message_dialog (window,
-				            GTK_MESSAGE_ERROR,
-				            _ ("Failed to checkout local branch <%s>"),
-				            NULL,
-				            NULL,
-				            gitg_ref_get_shortname (branch));
-			return FALSE;
-		}
+		// Go back to the previously checked out branch
+		gitg_window_add_branch_action (window,
+		                               checkout_ref (window,
+		                                             info->current,
+		                                             on_checkout_result,
+		                                             gitg_ref_copy (info->current)));
 	}
 
-	gchar *sha1 = gitg_hash_hash_to_sha1_new (gitg_ref_get_hash (stash));
-	gboolean ret;
+	apply_stash_info_free (info);
+}
 
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "stash",
-	                                             "apply",
-	                                             "--index",
-	                                             sha1,
-	                                             NULL),
-	                          NULL))
+static void
+on_stash_applied (GitgWindow   *window,
+                  GitgProgress  progress,
+                  gchar const  *output,
+                  gpointer      data)
+{
+	ApplyStashInfo *info = (ApplyStashInfo *)data;
+
+	if (progress == GITG_PROGRESS_ERROR)
 	{
-		message = g_strdup_printf (_ ("The stash could not be applied to local branch <%s>"),
-		                           gitg_ref_get_shortname (branch));
+		gchar *message = g_strdup_printf (_ ("The stash could not be applied to local branch <%s>"),
+		                                  gitg_ref_get_shortname (info->branch));
+
 		message_dialog (window,
 		                GTK_MESSAGE_ERROR,
 		                _ ("Failed to apply stash"),
 		                message,
 		                NULL);
 		g_free (message);
-		ret = FALSE;
 
-		if (!gitg_ref_equal (current, branch)  && no_changes (repository))
+		if (info->current && !gitg_ref_equal (info->current, info->branch))
 		{
-			checkout_local_branch_real (window, current);
+			gitg_window_add_branch_action (window,
+			                               no_changes (window,
+			                                           on_apply_stash_checked,
+			                                           info));
+			return;
 		}
 	}
-	else
+	else if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		ret = TRUE;
-		gitg_repository_reload (repository);
+		reload (window);
 	}
 
-	return ret;
+	apply_stash_info_free (info);
 }
 
-gboolean
-gitg_branch_actions_create (GitgWindow *window, gchar const *sha1, gchar const *name)
+static GitgShell *
+apply_stash (GitgWindow     *window,
+             ApplyStashInfo *info)
 {
-	g_return_val_if_fail (GITG_IS_WINDOW (window), FALSE);
-	g_return_val_if_fail (sha1 != NULL, FALSE);
-	g_return_val_if_fail (name != NULL, FALSE);
+	gchar *sha1 = gitg_hash_hash_to_sha1_new (gitg_ref_get_hash (info->stash));
+	GitgShell *ret;
 
-	GitgRepository *repository;
-	gboolean result = FALSE;
+	ret = run_command (window,
+	                   gitg_command_new (gitg_window_get_repository (window),
+	                                     "stash",
+	                                     "apply",
+	                                     "--index",
+	                                     sha1,
+	                                     NULL),
+	                   NULL,
+	                   on_stash_applied,
+	                   info);
 
-	repository = gitg_window_get_repository (window);
+	g_free (sha1);
+	return ret;
+}
 
-	result = gitg_shell_run_sync (gitg_command_new (repository,
-	                                                 "branch",
-	                                                 name,
-	                                                 sha1,
-	                                                 NULL),
-	                              NULL);
+static void
+on_apply_stash_checkout (GitgWindow   *window,
+                         GitgProgress  progress,
+                         gpointer      data)
+{
+	ApplyStashInfo *info = (ApplyStashInfo *)data;
 
-	if (!result)
+	if (progress != GITG_PROGRESS_SUCCESS)
 	{
-		gchar const *message;
-
-		message = _ ("The branch could not be successfully created");
+		if (progress == GITG_PROGRESS_ERROR)
+		{
+			message_dialog (window,
+			                GTK_MESSAGE_ERROR,
+			                _ ("Failed to checkout local branch <%s>"),
+			                NULL,
+			                NULL,
+			                gitg_ref_get_shortname (info->branch));
+		}
 
-		message_dialog (window,
-		                GTK_MESSAGE_ERROR,
-		                _ ("Failed to create a branch"),
-		                message,
-		                NULL);
-		return FALSE;
+		apply_stash_info_free (info);
+		return;
 	}
-	else
+
+	gitg_window_add_branch_action (window, apply_stash (window, info));
+}
+
+static void
+on_apply_stash_stashed (GitgWindow   *window,
+                        GitgProgress  progress,
+                        gchar const  *output,
+                        gpointer      data)
+{
+	ApplyStashInfo *info = (ApplyStashInfo *)data;
+
+	if (progress != GITG_PROGRESS_SUCCESS)
 	{
-		gitg_repository_reload (repository);
-		return TRUE;
+		apply_stash_info_free (info);
+		return;
 	}
+
+	gitg_window_add_branch_action (window,
+	                               checkout_ref (window,
+	                                             info->branch,
+	                                             on_apply_stash_checkout,
+	                                             info));
 }
 
-gboolean
-gitg_branch_actions_tag (GitgWindow *window, gchar const *sha1, gchar const *name, gchar const *message, gboolean sign)
+GitgShell *
+gitg_branch_actions_apply_stash (GitgWindow *window,
+                                 GitgRef    *stash,
+                                 GitgRef    *branch)
 {
-	g_return_val_if_fail (GITG_IS_WINDOW (window), FALSE);
-	g_return_val_if_fail (sha1 != NULL, FALSE);
-	g_return_val_if_fail (name != NULL, FALSE);
+	g_return_val_if_fail (GITG_IS_WINDOW (window), NULL);
+	g_return_val_if_fail (gitg_ref_get_ref_type (stash) == GITG_REF_TYPE_STASH, NULL);
+	g_return_val_if_fail (gitg_ref_get_ref_type (branch) == GITG_REF_TYPE_BRANCH, NULL);
 
-	GitgRepository *repository;
-	gboolean result = FALSE;
+	gchar *message = g_strdup_printf (_ ("Are you sure you want to apply the stash item to local branch <%s>?"),
+	                                  gitg_ref_get_shortname (branch));
 
-	repository = gitg_window_get_repository (window);
+	if (message_dialog (window,
+	                    GTK_MESSAGE_QUESTION,
+	                    _ ("Apply stash"),
+	                    message,
+	                    _ ("Apply stash")) != GTK_RESPONSE_ACCEPT)
+	{
+		g_free (message);
+		return NULL;
+	}
 
-	if (message != NULL && message[0] != '\0')
+	g_free (message);
+
+	GitgRepository *repository = gitg_window_get_repository (window);
+	ApplyStashInfo *info = g_slice_new (ApplyStashInfo);
+
+	info->stash = gitg_ref_copy (stash);
+	info->branch = gitg_ref_copy (branch);
+	info->current = gitg_ref_copy (gitg_repository_get_current_working_ref (repository));
+
+	if (!gitg_ref_equal (info->branch, info->current))
 	{
-		result = gitg_shell_run_sync (gitg_command_new (repository,
-		                                                 "tag",
-		                                                 "-m",
-		                                                 message,
-		                                                 sign ? "-s" : "-a",
-		                                                 name,
-		                                                 sha1,
-		                                                 NULL),
-		                              NULL);
+		return stash_changes (window, TRUE, on_apply_stash_stashed, info);
 	}
 	else
 	{
-		result = gitg_shell_run_sync (gitg_command_new (repository,
-		                                                 "tag",
-		                                                 name,
-		                                                 sha1,
-		                                                 NULL),
-		                              NULL);
+		return apply_stash (window, info);
+	}
+}
+
+static void
+on_branch_created (GitgWindow   *window,
+                   GitgProgress  progress,
+                   gchar const  *output,
+                   gpointer      data)
+{
+	if (progress == GITG_PROGRESS_ERROR)
+	{
+		message_dialog (window,
+		                GTK_MESSAGE_ERROR,
+		                _ ("Failed to create a branch"),
+		                _ ("The branch could not be successfully created"),
+		                NULL);
+	}
+	else if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		reload (window);
 	}
+}
+
+GitgShell *
+gitg_branch_actions_create (GitgWindow *window, gchar const *sha1, gchar const *name)
+{
+	g_return_val_if_fail (GITG_IS_WINDOW (window), NULL);
+	g_return_val_if_fail (sha1 != NULL, NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	return run_command (window,
+	                    gitg_command_new (gitg_window_get_repository (window),
+	                                      "branch",
+	                                      name,
+	                                      sha1,
+	                                      NULL),
+	                    NULL,
+	                    on_branch_created,
+	                    NULL);
+}
+
+static void
+on_tag_created (GitgWindow   *window,
+                GitgProgress  progress,
+                gchar const  *output,
+                gpointer      data)
+{
+	gboolean sign = GPOINTER_TO_INT (data);
 
-	if (!result)
+	if (progress == GITG_PROGRESS_ERROR)
 	{
 		gchar const *secondary;
 
@@ -1789,13 +2660,50 @@ gitg_branch_actions_tag (GitgWindow *window, gchar const *sha1, gchar const *nam
 		                _ ("Failed to create tag"),
 		                secondary,
 		                NULL);
-		return FALSE;
+	}
+	else if (progress == GITG_PROGRESS_SUCCESS)
+	{
+		reload (window);
+	}
+}
+
+GitgShell *
+gitg_branch_actions_tag (GitgWindow *window, gchar const *sha1, gchar const *name, gchar const *message, gboolean sign)
+{
+	g_return_val_if_fail (GITG_IS_WINDOW (window), NULL);
+	g_return_val_if_fail (sha1 != NULL, NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	GitgRepository *repository;
+	GitgCommand *command;
+
+	repository = gitg_window_get_repository (window);
+
+	if (message != NULL && message[0] != '\0')
+	{
+		command = gitg_command_new (repository,
+		                            "tag",
+		                            "-m",
+		                            message,
+		                            sign ? "-s" : "-a",
+		                            name,
+		                            sha1,
+		                            NULL);
 	}
 	else
 	{
-		gitg_repository_reload (repository);
-		return TRUE;
+		command = gitg_command_new (repository,
+		                            "tag",
+		                            name,
+		                            sha1,
+		                            NULL);
 	}
+
+	return run_command (window,
+	                    command,
+	                    NULL,
+	                    on_tag_created,
+	                    GINT_TO_POINTER (sign));
 }
 
 typedef struct
@@ -1848,65 +2756,88 @@ on_cherry_pick_result (GitgWindow   *window,
 	}
 	else if (progress == GITG_PROGRESS_SUCCESS)
 	{
-		GitgRepository *repository = gitg_window_get_repository (window);
+		/* When picking onto the checked out branch, only its head
+		   moved and the new commit can be put into the history as is */
+		restore_head (window,
+		              info->head,
+		              info->stashcommit,
+		              !gitg_ref_equal (info->head, info->dest));
+	}
 
-		// Checkout head
-		if (!checkout_local_branch_real (window, info->head))
-		{
-			gchar const *message = NULL;
+	cherry_pick_info_free (info);
+}
 
-			if (info->stashcommit)
-			{
-				gitg_shell_run_sync (gitg_command_new (repository,
-				                                        "update-ref",
-				                                        "-m",
-				                                        "gitg autosave stash",
-				                                        "refs/stash",
-				                                        info->stashcommit,
-				                                        NULL),
-				                     NULL);
-
-				message = _ ("The stashed changes have been stored to be reapplied manually");
-			}
+static void
+on_cherry_pick_checkout (GitgWindow   *window,
+                         GitgProgress  progress,
+                         gpointer      data)
+{
+	CherryPickInfo *info = (CherryPickInfo *)data;
 
+	if (progress != GITG_PROGRESS_SUCCESS)
+	{
+		if (progress == GITG_PROGRESS_ERROR)
+		{
 			message_dialog (window,
-				            GTK_MESSAGE_ERROR,
-				            _ ("Failed to checkout previously checked out branch"),
-				            message,
-				            NULL);
+			                GTK_MESSAGE_ERROR,
+			                _ ("Failed to checkout local branch <%s>"),
+			                _ ("The branch on which to cherry-pick could not be checked out"),
+			                NULL,
+			                gitg_ref_get_shortname (info->dest));
 		}
-		else if (info->stashcommit)
-		{
-			// Reapply stash
-			if (!gitg_shell_run_sync (gitg_command_new (gitg_window_get_repository (window),
-			                                             "stash",
-			                                             "apply",
-			                                             "--index",
-			                                             info->stashcommit,
-			                                             NULL),
-			                          NULL))
-			{
-				gitg_shell_run_sync (gitg_command_new (repository,
-				                                        "update-ref",
-				                                        "-m",
-				                                        "gitg autosave stash",
-				                                        "refs/stash",
-				                                        info->stashcommit,
-				                                        NULL),
-				                     NULL);
 
-				message_dialog (window,
-				                GTK_MESSAGE_ERROR,
-				                _ ("Failed to reapply stash correctly"),
-				                _ ("There might be unresolved conflicts in the working tree or index which you need to resolve manually"),
-				                NULL);
-			}
-		}
+		cherry_pick_info_free (info);
+		return;
+	}
 
-		gitg_repository_reload (gitg_window_get_repository (window));
+	gchar *message = g_strdup_printf (_ ("Cherry-picking on <%s>"),
+	                                  gitg_ref_get_shortname (info->dest));
+	gchar *sha1 = gitg_revision_get_sha1 (info->revision);
+
+	gitg_window_add_branch_action (window,
+	                               run_progress (window,
+	                                             _ ("Cherry-pick"),
+	                                             message,
+	                                             FALSE,
+	                                             on_cherry_pick_result,
+	                                             info,
+	                                             "cherry-pick",
+	                                             sha1,
+	                                             NULL));
+
+	g_free (message);
+	g_free (sha1);
+}
+
+static void
+on_cherry_pick_stashed (GitgWindow   *window,
+                        GitgProgress  progress,
+                        gchar const  *output,
+                        gpointer      data)
+{
+	CherryPickInfo *info = (CherryPickInfo *)data;
+
+	if (progress != GITG_PROGRESS_SUCCESS)
+	{
+		cherry_pick_info_free (info);
+		return;
 	}
 
-	cherry_pick_info_free (info);
+	info->stashcommit = g_strdup (output);
+
+	if (gitg_ref_equal (info->head, info->dest))
+	{
+		on_cherry_pick_checkout (window, GITG_PROGRESS_SUCCESS, info);
+	}
+	else
+	{
+		// First checkout the correct branch on which to cherry-pick
+		gitg_window_add_branch_action (window,
+		                               checkout_ref (window,
+		                                             info->dest,
+		                                             on_cherry_pick_checkout,
+		                                             info));
+	}
 }
 
 GitgShell *
@@ -1931,60 +2862,14 @@ gitg_branch_actions_cherry_pick (GitgWindow   *window,
 		return NULL;
 	}
 
-	gchar *stashcommit;
-
-	if (!stash_changes (window, &stashcommit, FALSE))
-	{
-		return NULL;
-	}
+	g_free (message);
 
 	GitgRepository *repository = gitg_window_get_repository (window);
-	GitgRef *head = gitg_repository_get_current_working_ref (repository);
-
-	// First checkout the correct branch on which to cherry-pick
-	if (!gitg_shell_run_sync (gitg_command_new (repository,
-	                                             "checkout",
-	                                             gitg_ref_get_shortname (dest),
-	                                             NULL),
-	                          NULL))
-	{
-		g_free (stashcommit);
-
-		message_dialog (window,
-		                GTK_MESSAGE_ERROR,
-		                _ ("Failed to checkout local branch <%s>"),
-		                _ ("The branch on which to cherry-pick could not be checked out"),
-		                NULL,
-		                gitg_ref_get_shortname (dest));
-
-		return NULL;
-	}
-
-	message = g_strdup_printf (_ ("Cherry-picking on <%s>"),
-	                           gitg_ref_get_shortname (dest));
-
-	GitgShell *ret;
-
 	CherryPickInfo *info = cherry_pick_info_new (revision, dest);
 
-	info->stashcommit = stashcommit;
-	info->head = gitg_ref_copy (head);
-
-	gchar *sha1 = gitg_revision_get_sha1 (revision);
-
-	ret = run_progress (window,
-	                    _ ("Cherry-pick"),
-	                    message,
-	                    on_cherry_pick_result,
-	                    info,
-	                    "cherry-pick",
-	                    sha1,
-	                    NULL);
-
-	g_free (message);
-	g_free (sha1);
+	info->head = gitg_ref_copy (gitg_repository_get_current_working_ref (repository));
 
-	return ret;
+	return stash_changes (window, FALSE, on_cherry_pick_stashed, info);
 }
 
 typedef struct
@@ -2037,19 +2922,6 @@ on_format_patch_result (GitgWindow   *window,
 	format_patch_info_free (info);
 }
 
-static void
-on_format_patch_update (GitgShell        *shell,
-                        gchar           **lines,
-                        FormatPatchInfo  *info)
-{
-	while (lines && *lines)
-	{
-		g_output_stream_write_all (info->stream, *lines, strlen (*lines), NULL, NULL, NULL);
-		g_output_stream_write_all (info->stream, "\n", 1, NULL, NULL, NULL);
-		++lines;
-	}
-}
-
 GitgShell *
 gitg_branch_actions_format_patch (GitgWindow   *window,
                                   GitgRevision *revision,
@@ -2085,21 +2957,22 @@ gitg_branch_actions_format_patch (GitgWindow   *window,
 	                                               destination,
 	                                               G_OUTPUT_STREAM (stream));
 
-	ret = run_progress (window,
-	                    _ ("Format patch"),
-	                    message,
-	                    on_format_patch_result,
-	                    info,
-	                    "format-patch",
-	                    "-1",
-	                    "--stdout",
-	                    sha1,
-	                    NULL);
+	gchar const *argv[] = {
+		"format-patch",
+		"-1",
+		"--stdout",
+		sha1,
+		NULL
+	};
 
-	if (ret)
-	{
-		g_signal_connect (ret, "update", G_CALLBACK (on_format_patch_update), info);
-	}
+	ret = run_progress_argv (window,
+	                         _ ("Format patch"),
+	                         message,
+	                         info->stream,
+	                         FALSE,
+	                         on_format_patch_result,
+	                         info,
+	                         argv);
 
 	g_free (sha1);
 	g_free (message);
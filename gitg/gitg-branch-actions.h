@@ -28,10 +28,10 @@
 
 G_BEGIN_DECLS
 
-gboolean gitg_branch_actions_create (GitgWindow *window, gchar const *sha1, gchar const *name);
+GitgShell *gitg_branch_actions_create (GitgWindow *window, gchar const *sha1, gchar const *name);
 GitgShell *gitg_branch_actions_remove (GitgWindow *window, GitgRef *ref);
 GitgShell *gitg_branch_actions_rename (GitgWindow *window, GitgRef *ref);
-gboolean gitg_branch_actions_checkout (GitgWindow *window, GitgRef *ref);
+GitgShell *gitg_branch_actions_checkout (GitgWindow *window, GitgRef *ref);
 
 GitgShell *gitg_branch_actions_merge (GitgWindow *window, GitgRef *source, GitgRef *dest);
 GitgShell *gitg_branch_actions_rebase (GitgWindow *window, GitgRef *source, GitgRef *dest);
@@ -39,9 +39,9 @@ GitgShell *gitg_branch_actions_rebase (GitgWindow *window, GitgRef *source, Gitg
 GitgShell *gitg_branch_actions_push (GitgWindow *window, GitgRef *source, GitgRef *dest);
 GitgShell *gitg_branch_actions_push_remote (GitgWindow *window, GitgRef *source, gchar const *remote, gchar const *branch);
 
-gboolean gitg_branch_actions_apply_stash (GitgWindow *window, GitgRef *stash, GitgRef *branch);
+GitgShell *gitg_branch_actions_apply_stash (GitgWindow *window, GitgRef *stash, GitgRef *branch);
 
-gboolean gitg_branch_actions_tag (GitgWindow *window, gchar const *sha1, gchar const *name, gchar const *message, gboolean sign);
+GitgShell *gitg_branch_actions_tag (GitgWindow *window, gchar const *sha1, gchar const *name, gchar const *message, gboolean sign);
 
 GitgShell *gitg_branch_actions_cherry_pick (GitgWindow *window, GitgRevision *revision, GitgRef *dest);
 
@@ -34,6 +34,9 @@
 
 #define DEFAULT_LANE_WIDTH (DEFAULT_DOT_WIDTH + 6)
 
+/* Maximum number of rendered graph cells kept around */
+#define GRAPH_CACHE_SIZE 500
+
 /* Properties */
 enum
 {
@@ -57,6 +60,9 @@ struct _GitgCellRendererPathPrivate
 	guint dot_width;
 
 	gint last_height;
+
+	/* Rendered graph cells, keyed by everything that is drawn in them */
+	GHashTable *graph_cache;
 };
 
 static GtkCellRendererTextClass *parent_class = NULL;
@@ -84,19 +90,29 @@ is_dummy(GitgRevision *revision)
 }
 
 static gint
-total_width(GitgCellRendererPath *self, GtkWidget *widget)
+graph_width(GitgCellRendererPath *self)
 {
-	PangoFontDescription *font;
-	g_object_get(self, "font-desc", &font, NULL);
-
 	gint offset = 0;
 
 	if (is_dummy(self->priv->revision))
 		offset = self->priv->lane_width;
 
-	return num_lanes(self) * self->priv->lane_width + 
-	       gitg_label_renderer_width(widget, font, self->priv->labels) +
-	       offset;
+	return num_lanes(self) * self->priv->lane_width + offset;
+}
+
+static gint
+total_width(GitgCellRendererPath *self, GtkWidget *widget)
+{
+	PangoFontDescription *font;
+	gint width;
+
+	g_object_get(self, "font-desc", &font, NULL);
+
+	width = graph_width(self) +
+	        gitg_label_renderer_width(widget, font, self->priv->labels);
+
+	pango_font_description_free(font);
+	return width;
 }
 
 static void
@@ -108,6 +124,7 @@ gitg_cell_renderer_path_finalize(GObject *object)
 	gitg_revision_unref(self->priv->next_revision);
 
 	g_slist_free(self->priv->labels);
+	g_hash_table_destroy(self->priv->graph_cache);
 
 	G_OBJECT_CLASS(gitg_cell_renderer_path_parent_class)->finalize(object);
 }
@@ -126,8 +143,11 @@ renderer_get_size(GtkCellRenderer *renderer, GtkWidget *widget, GdkRectangle *ar
 	if (width)
 		*width = total_width(self, widget);
 
+	/* The row height comes from the text font (see
+	   gtk_cell_renderer_text_set_fixed_height_from_font), so that all
+	   rows are the same height whatever their lanes or labels */
 	if (height)
-		*height = area ? area->height : 1;
+		GTK_CELL_RENDERER_CLASS(parent_class)->get_size(renderer, widget, area, NULL, NULL, NULL, height);
 }
 
 static void
@@ -246,6 +266,8 @@ draw_labels(GitgCellRendererPath *self, GtkWidget *widget, cairo_t *context, Gdk
 
 	cairo_translate(context, offset, 0.0);
 	gitg_label_renderer_draw(widget, font, context, self->priv->labels, area);
+
+	pango_font_description_free(font);
 }
 
 static void
@@ -317,10 +339,111 @@ draw_indicator(GitgCellRendererPath *self, cairo_t *context, GdkRectangle *area)
 		draw_indicator_circle(self, lane, context, area);
 }
 
+static void
+append_lanes_key(GString *key, GitgRevision *revision, gboolean with_type)
+{
+	GSList *lanes = revision ? gitg_revision_get_lanes(revision) : NULL;
+
+	/* Values are printed separated, prefixed by their count, so that
+	   different lanes never give the same key, however many there are */
+	g_string_append_printf(key, "%u;", g_slist_length(lanes));
+
+	for (; lanes; lanes = lanes->next)
+	{
+		GitgLane *lane = (GitgLane *)lanes->data;
+		GSList *item;
+
+		g_string_append_printf(key,
+		                       "%u,%d,%d,",
+		                       g_slist_length(lane->from),
+		                       lane->color->index,
+		                       with_type ? lane->type : 0);
+
+		for (item = lane->from; item; item = item->next)
+			g_string_append_printf(key, "%d,", GPOINTER_TO_INT(item->data));
+	}
+
+	g_string_append_c(key, ';');
+}
+
+static gchar *
+graph_key(GitgCellRendererPath *self, gint height)
+{
+	GString *key = g_string_sized_new(64);
+
+	g_string_printf(key,
+	                "%d:%u:%u:%u:%d:%d:",
+	                height,
+	                self->priv->lane_width,
+	                self->priv->dot_width,
+	                self->priv->triangle_width,
+	                is_dummy(self->priv->revision),
+	                gitg_revision_get_mylane(self->priv->revision));
+
+	append_lanes_key(key, self->priv->revision, TRUE);
+	append_lanes_key(key, self->priv->next_revision, FALSE);
+
+	return g_string_free(key, FALSE);
+}
+
+static gint
+lanes_extent(GitgRevision *revision)
+{
+	GSList *lanes = revision ? gitg_revision_get_lanes(revision) : NULL;
+	gint ret = g_slist_length(lanes);
+
+	/* Paths may come from lanes beyond the ones of the revision itself */
+	for (; lanes; lanes = lanes->next)
+	{
+		GSList *item;
+
+		for (item = ((GitgLane *)lanes->data)->from; item; item = item->next)
+			ret = MAX(ret, GPOINTER_TO_INT(item->data) + 1);
+	}
+
+	return ret;
+}
+
+static cairo_surface_t *
+get_graph_surface(GitgCellRendererPath *self, gint height)
+{
+	gchar *key = graph_key(self, height);
+	cairo_surface_t *surface = g_hash_table_lookup(self->priv->graph_cache, key);
+
+	if (surface)
+	{
+		g_free(key);
+		return surface;
+	}
+
+	gint width = MAX(lanes_extent(self->priv->revision),
+	                 lanes_extent(self->priv->next_revision)) * self->priv->lane_width;
+
+	if (is_dummy(self->priv->revision))
+		width += self->priv->lane_width;
+
+	GdkRectangle area = {0, 0, width, height};
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+	cairo_t *cr = cairo_create(surface);
+
+	draw_paths(self, cr, &area);
+	draw_indicator(self, cr, &area);
+
+	cairo_destroy(cr);
+
+	if (g_hash_table_size(self->priv->graph_cache) >= GRAPH_CACHE_SIZE)
+		g_hash_table_remove_all(self->priv->graph_cache);
+
+	g_hash_table_insert(self->priv->graph_cache, key, surface);
+	return surface;
+}
+
 static void
 renderer_render(GtkCellRenderer *renderer, GdkDrawable *window, GtkWidget *widget, GdkRectangle *area, GdkRectangle *cell_area, GdkRectangle *expose_area, GtkCellRendererState flags)
 {
 	GitgCellRendererPath *self = GITG_CELL_RENDERER_PATH(renderer);
+	gint total;
 
 	self->priv->last_height = area->height;
 
@@ -329,17 +452,23 @@ renderer_render(GtkCellRenderer *renderer, GdkDrawable *window, GtkWidget *widge
 	gdk_cairo_rectangle (cr, area);
 	cairo_clip(cr);
 
-	draw_paths(self, cr, area);
+	/* draw paths and indicator from the cache */
+	if (area->height > 0 && num_lanes(self) > 0)
+	{
+		cairo_surface_t *surface = get_graph_surface(self, area->height);
 
-	/* draw indicator */
-	draw_indicator(self, cr, area);
+		cairo_set_source_surface(cr, surface, area->x, area->y);
+		cairo_paint(cr);
+	}
 
 	/* draw labels */
 	draw_labels(self, widget, cr, area);
 	cairo_destroy(cr);
 
-	area->x += total_width(self, widget);
-	cell_area->x += total_width(self, widget);
+	total = total_width(self, widget);
+
+	area->x += total;
+	cell_area->x += total;
 
 	if (GTK_CELL_RENDERER_CLASS(parent_class)->render)
 		GTK_CELL_RENDERER_CLASS(parent_class)->render(renderer, window, widget, area, cell_area, expose_area, flags);
@@ -483,6 +612,11 @@ gitg_cell_renderer_path_init(GitgCellRendererPath *self)
 	self->priv->lane_width = DEFAULT_LANE_WIDTH;
 	self->priv->dot_width = DEFAULT_DOT_WIDTH;
 	self->priv->triangle_width = DEFAULT_TRIANGLE_WIDTH;
+
+	self->priv->graph_cache = g_hash_table_new_full(g_str_hash,
+	                                                g_str_equal,
+	                                                g_free,
+	                                                (GDestroyNotify)cairo_surface_destroy);
 }
 
 GtkCellRenderer *
@@ -507,7 +641,10 @@ gitg_cell_renderer_path_get_ref_at_pos (GtkWidget *widget, GitgCellRendererPath
 
 	x -= num_lanes(renderer) * renderer->priv->lane_width + offset;
 
-	return gitg_label_renderer_get_ref_at_pos (widget, font, renderer->priv->labels, x, hot_x);
+	GitgRef *ret = gitg_label_renderer_get_ref_at_pos (widget, font, renderer->priv->labels, x, hot_x);
+	pango_font_description_free (font);
+
+	return ret;
 }
 
 GdkPixbuf *
@@ -519,5 +656,8 @@ gitg_cell_renderer_path_render_ref (GtkWidget *widget, GitgCellRendererPath *ren
 	PangoFontDescription *font;
 	g_object_get(renderer, "font-desc", &font, NULL);
 
-	return gitg_label_renderer_render_ref (widget, font, ref, renderer->priv->last_height, minwidth);
+	GdkPixbuf *ret = gitg_label_renderer_render_ref (widget, font, ref, renderer->priv->last_height, minwidth);
+	pango_font_description_free (font);
+
+	return ret;
 }
@@ -73,6 +73,7 @@ struct _GitgCommitViewPrivate
 	GtkTextView *comment_view;
 	GtkCheckButton *check_button_signed_off_by;
 	GtkCheckButton *check_button_amend;
+	GtkButton *button_commit;
 
 	GtkHScale *hscale_context;
 	gint context_size;
@@ -106,6 +107,8 @@ static GtkBuildableIface parent_iface;
 
 static void on_commit_file_inserted(GitgCommit *commit, GitgChangedFile *file, GitgCommitView *view);
 static void on_commit_file_removed(GitgCommit *commit, GitgChangedFile *file, GitgCommitView *view);
+static void on_commit_progress(GitgCommit *commit, GitgCommitStage stage, GitgCommitView *view);
+static void on_committed(GitgCommit *commit, GError *error, GitgCommitView *view);
 
 static void on_staged_button_press(GtkWidget *widget, GdkEventButton *event, GitgCommitView *view);
 static void on_unstaged_button_press(GtkWidget *widget, GdkEventButton *event, GitgCommitView *view);
@@ -121,6 +124,7 @@ static gboolean on_staged_motion(GtkWidget *widget, GdkEventMotion *event, GitgC
 static gboolean on_unstaged_motion(GtkWidget *widget, GdkEventMotion *event, GitgCommitView *view);
 
 static void on_commit_clicked(GtkButton *button, GitgCommitView *view);
+static void reset_commit_button(GitgCommitView *view);
 static void on_context_value_changed(GtkHScale *scale, GitgCommitView *view);
 
 static void on_changes_view_popup_menu(GtkTextView *textview, GtkMenu *menu, GitgCommitView *view);
@@ -226,35 +230,58 @@ show_binary_information (GitgCommitView *view)
 }
 
 static void
-on_changes_update (GitgShell *shell, gchar **buffer, GitgCommitView *view)
+add_hunk_marks (GitgCommitView *view, gint from_line)
 {
-	gchar *line;
+	GitgDiffView *diff_view = GITG_DIFF_VIEW (view->priv->changes_view);
 	GtkTextBuffer *buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW(view->priv->changes_view));
-	GtkTextIter iter;
+	GitgDiffIter diff_iter;
+	gchar const *category;
 
-	gtk_text_buffer_get_end_iter (buf, &iter);
+	if (view->priv->current_changes & GITG_CHANGED_FILE_CHANGES_UNSTAGED)
+		category = CATEGORY_STAGE_HUNK;
+	else
+		category = CATEGORY_UNSTAGE_HUNK;
+
+	if (!gitg_diff_view_get_end_iter (diff_view, &diff_iter))
+		return;
 
-	while ((line = *(buffer++)))
+	/* Walk back over the regions which were added for the new lines */
+	do
 	{
-		if (view->priv->is_diff && g_str_has_prefix (line, "@@"))
+		GtkTextIter start;
+		GtkTextIter end;
+
+		gitg_diff_iter_get_bounds (&diff_iter, &start, &end);
+
+		if (gtk_text_iter_get_line (&start) < from_line)
+			break;
+
+		if (gitg_diff_iter_get_type (&diff_iter) == GITG_DIFF_ITER_TYPE_HUNK)
 		{
-			if (view->priv->current_changes & GITG_CHANGED_FILE_CHANGES_UNSTAGED)
-			{
-				gtk_source_buffer_create_source_mark (GTK_SOURCE_BUFFER(buf),
-				                                      NULL,
-				                                      CATEGORY_STAGE_HUNK,
-				                                      &iter);
-			}
-			else
-			{
-				gtk_source_buffer_create_source_mark (GTK_SOURCE_BUFFER(buf),
-				                                      NULL,
-				                                      CATEGORY_UNSTAGE_HUNK,
-				                                      &iter);
-			}
+			gtk_source_buffer_create_source_mark (GTK_SOURCE_BUFFER(buf),
+			                                      NULL,
+			                                      category,
+			                                      &start);
 		}
+	} while (gitg_diff_iter_backward (&diff_iter));
+}
+
+static void
+on_changes_update (GitgShell *shell, gchar **buffer, GitgCommitView *view)
+{
+	GtkTextBuffer *buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW(view->priv->changes_view));
+	GtkTextIter iter;
+
+	gtk_text_buffer_get_end_iter (buf, &iter);
+	gint from_line = gtk_text_iter_get_line (&iter);
+
+	gitg_diff_view_append_lines (GITG_DIFF_VIEW (view->priv->changes_view),
+	                             (gchar const * const *)buffer,
+	                             FALSE);
 
-		gtk_text_buffer_insert (buf, &iter, line, -1);
+	if (view->priv->is_diff)
+	{
+		add_hunk_marks (view, from_line);
 	}
 
 	if (gtk_source_buffer_get_language (GTK_SOURCE_BUFFER(buf)) == NULL)
@@ -1542,7 +1569,8 @@ gitg_commit_view_parser_finished(GtkBuildable *buildable, GtkBuilder *builder)
 	g_signal_connect(self->priv->tree_view_unstaged, "motion-notify-event", G_CALLBACK(on_unstaged_motion), self);
 	g_signal_connect(self->priv->tree_view_staged, "motion-notify-event", G_CALLBACK(on_staged_motion), self);
 
-	g_signal_connect(gtk_builder_get_object(builder, "button_commit"), "clicked", G_CALLBACK(on_commit_clicked), self);
+	self->priv->button_commit = GTK_BUTTON(gtk_builder_get_object(builder, "button_commit"));
+	g_signal_connect(self->priv->button_commit, "clicked", G_CALLBACK(on_commit_clicked), self);
 
 	g_signal_connect(self->priv->hscale_context, "value-changed", G_CALLBACK(on_context_value_changed), self);
 
@@ -1587,6 +1615,8 @@ gitg_commit_view_dispose(GObject *object)
 	{
 		g_signal_handlers_disconnect_by_func(self->priv->commit, on_commit_file_inserted, self);
 		g_signal_handlers_disconnect_by_func(self->priv->commit, on_commit_file_removed, self);
+		g_signal_handlers_disconnect_by_func(self->priv->commit, on_commit_progress, self);
+		g_signal_handlers_disconnect_by_func(self->priv->commit, on_committed, self);
 
 		g_object_unref(self->priv->commit);
 		self->priv->commit = NULL;
@@ -1641,6 +1671,8 @@ initialize_commit(GitgCommitView *self)
 
 	g_signal_connect(self->priv->commit, "inserted", G_CALLBACK(on_commit_file_inserted), self);
 	g_signal_connect(self->priv->commit, "removed", G_CALLBACK(on_commit_file_removed), self);
+	g_signal_connect(self->priv->commit, "commit-progress", G_CALLBACK(on_commit_progress), self);
+	g_signal_connect(self->priv->commit, "committed", G_CALLBACK(on_committed), self);
 
 	gitg_commit_refresh(self->priv->commit);
 }
@@ -1718,8 +1750,13 @@ gitg_commit_view_set_repository(GitgCommitView *view, GitgRepository *repository
 
 	if (view->priv->commit)
 	{
+		g_signal_handlers_disconnect_by_func(view->priv->commit, on_commit_progress, view);
+		g_signal_handlers_disconnect_by_func(view->priv->commit, on_committed, view);
+
 		g_object_unref(view->priv->commit);
 		view->priv->commit = NULL;
+
+		reset_commit_button(view);
 	}
 
 	gtk_list_store_clear(view->priv->store_unstaged);
@@ -2023,9 +2060,65 @@ show_error(GitgCommitView *view, gchar const *error)
 	gtk_widget_destroy(dlg);
 }
 
+static void
+reset_commit_button(GitgCommitView *view)
+{
+	if (!view->priv->button_commit)
+		return;
+
+	gtk_button_set_label(view->priv->button_commit, _("Commit"));
+	gtk_widget_set_sensitive(GTK_WIDGET(view->priv->button_commit), TRUE);
+}
+
+static void
+on_commit_progress(GitgCommit *commit, GitgCommitStage stage, GitgCommitView *view)
+{
+	gchar const *label;
+
+	switch (stage)
+	{
+		case GITG_COMMIT_STAGE_WRITE_TREE:
+			label = _("Writing tree...");
+		break;
+		case GITG_COMMIT_STAGE_COMMIT_TREE:
+			label = _("Creating commit...");
+		break;
+		case GITG_COMMIT_STAGE_UPDATE_REF:
+			label = _("Updating HEAD...");
+		break;
+		case GITG_COMMIT_STAGE_UPDATE_HISTORY:
+			label = _("Updating history...");
+		break;
+		default:
+			return;
+	}
+
+	gtk_widget_set_sensitive(GTK_WIDGET(view->priv->button_commit), FALSE);
+	gtk_button_set_label(view->priv->button_commit, label);
+}
+
+static void
+on_committed(GitgCommit *commit, GError *error, GitgCommitView *view)
+{
+	reset_commit_button(view);
+
+	if (error)
+	{
+		show_error(view, _("Something went wrong while trying to commit"));
+		return;
+	}
+
+	gtk_text_buffer_set_text(gtk_text_view_get_buffer(view->priv->comment_view), "", -1);
+	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (view->priv->check_button_amend), FALSE);
+	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (view->priv->check_button_signed_off_by), FALSE);
+}
+
 static void
 on_commit_clicked(GtkButton *button, GitgCommitView *view)
 {
+	if (gitg_commit_get_committing(view->priv->commit))
+		return;
+
 	if (!gitg_commit_has_changes(view->priv->commit))
 	{
 		show_error(view, _("You must first stage some changes before committing"));
@@ -2045,7 +2138,8 @@ on_commit_clicked(GtkButton *button, GitgCommitView *view)
 
 	GError *error = NULL;
 
-	if (!gitg_commit_commit(view->priv->commit, comment, signoff, amend, &error))
+	/* The result is reported through the "committed" signal */
+	if (!gitg_commit_commit_async(view->priv->commit, comment, signoff, amend, &error))
 	{
 		if (error && error->domain == GITG_COMMIT_ERROR && error->code == GITG_COMMIT_ERROR_SIGNOFF)
 			show_error(view, _("Your user name or email could not be retrieved for use in the sign off message"));
@@ -2055,12 +2149,6 @@ on_commit_clicked(GtkButton *button, GitgCommitView *view)
 		if (error)
 			g_error_free(error);
 	}
-	else
-	{
-		gtk_text_buffer_set_text(gtk_text_view_get_buffer(view->priv->comment_view), "", -1);
-		gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (view->priv->check_button_amend), FALSE);
-		gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (view->priv->check_button_signed_off_by), FALSE);
-	}
 
 	g_free(comment);
 }
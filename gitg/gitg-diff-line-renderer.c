@@ -39,6 +39,12 @@ struct _GitgDiffLineRendererPrivate
 	gint line_old;
 	gint line_new;
 	gchar *label;
+
+	/* Digit glyphs, laid out once for the widget they are drawn on */
+	GtkWidget *cache_widget;
+	gulong style_set_id;
+	PangoLayout *digits[10];
+	gint digit_width[10];
 };
 
 G_DEFINE_TYPE (GitgDiffLineRenderer, gitg_diff_line_renderer, GTK_TYPE_CELL_RENDERER)
@@ -94,6 +100,114 @@ gitg_diff_line_renderer_get_property (GObject    *object,
 	}
 }
 
+static void
+clear_digit_cache (GitgDiffLineRenderer *lr)
+{
+	gint i;
+
+	if (lr->priv->cache_widget)
+	{
+		g_signal_handler_disconnect (lr->priv->cache_widget,
+		                             lr->priv->style_set_id);
+
+		g_object_remove_weak_pointer (G_OBJECT (lr->priv->cache_widget),
+		                              (gpointer *)&lr->priv->cache_widget);
+
+		lr->priv->cache_widget = NULL;
+		lr->priv->style_set_id = 0;
+	}
+
+	for (i = 0; i < 10; ++i)
+	{
+		if (lr->priv->digits[i])
+		{
+			g_object_unref (lr->priv->digits[i]);
+			lr->priv->digits[i] = NULL;
+		}
+	}
+}
+
+static void
+on_cache_widget_style_set (GtkWidget            *widget,
+                           GtkStyle             *previous,
+                           GitgDiffLineRenderer *lr)
+{
+	/* Font might have changed, lay out the digits again on next use */
+	clear_digit_cache (lr);
+}
+
+static void
+ensure_digit_cache (GitgDiffLineRenderer *lr,
+                    GtkWidget            *widget)
+{
+	gint i;
+
+	if (lr->priv->cache_widget == widget && lr->priv->digits[0])
+	{
+		return;
+	}
+
+	clear_digit_cache (lr);
+
+	for (i = 0; i < 10; ++i)
+	{
+		gchar str[2] = {'0' + i, '\0'};
+
+		lr->priv->digits[i] = gtk_widget_create_pango_layout (widget, str);
+
+		pango_layout_get_pixel_size (lr->priv->digits[i],
+		                             &lr->priv->digit_width[i],
+		                             NULL);
+	}
+
+	lr->priv->cache_widget = widget;
+	g_object_add_weak_pointer (G_OBJECT (widget),
+	                           (gpointer *)&lr->priv->cache_widget);
+
+	lr->priv->style_set_id =
+		g_signal_connect (widget,
+		                  "style-set",
+		                  G_CALLBACK (on_cache_widget_style_set),
+		                  lr);
+}
+
+static gint
+number_width (GitgDiffLineRenderer *lr,
+              guint                 number)
+{
+	gint width = 0;
+
+	do
+	{
+		width += lr->priv->digit_width[number % 10];
+		number /= 10;
+	} while (number > 0);
+
+	return width;
+}
+
+static void
+draw_number (GitgDiffLineRenderer *lr,
+             cairo_t              *ctx,
+             guint                 number,
+             gint                  right,
+             gint                  y)
+{
+	/* Draw right aligned at right, starting from the least significant
+	   digit */
+	do
+	{
+		guint digit = number % 10;
+
+		right -= lr->priv->digit_width[digit];
+
+		cairo_move_to (ctx, right, y);
+		pango_cairo_show_layout (ctx, lr->priv->digits[digit]);
+
+		number /= 10;
+	} while (number > 0);
+}
+
 static void
 darken_or_lighten (cairo_t        *ctx,
                    GdkColor const *color)
@@ -199,68 +313,48 @@ render_lines (GitgDiffLineRenderer *lr,
               GtkCellRendererState  flags)
 {
 	/* Render new/old in the cell area */
-	gchar old_str[16];
-	gchar new_str[16];
 	guint xpad;
-	guint ypad;
 	GtkStyle *style;
+	GtkStateType state;
+	cairo_t *ctx;
+
+	ensure_digit_cache (lr, widget);
+
+	g_object_get (lr, "xpad", &xpad, NULL);
 
-	PangoLayout *layout = gtk_widget_create_pango_layout (widget, "");
-	pango_layout_set_width (layout, cell_area->width / 2);
+	style = gtk_widget_get_style (widget);
+	state = gtk_widget_get_state (widget);
+
+	ctx = gdk_cairo_create (window);
 
-	pango_layout_set_alignment (layout, PANGO_ALIGN_RIGHT);
+	gdk_cairo_rectangle (ctx, expose_area);
+	cairo_clip (ctx);
+
+	gdk_cairo_set_source_color (ctx, &(style->fg[state]));
 
 	if (lr->priv->line_old >= 0)
 	{
-		g_snprintf (old_str, sizeof (old_str), "%d", lr->priv->line_old);
-	}
-	else
-	{
-		*old_str = '\0';
+		draw_number (lr,
+		             ctx,
+		             lr->priv->line_old,
+		             cell_area->x + cell_area->width / 2 - 1 - xpad,
+		             cell_area->y);
 	}
 
 	if (lr->priv->line_new >= 0)
 	{
-		g_snprintf (new_str, sizeof (old_str), "%d", lr->priv->line_new);
+		draw_number (lr,
+		             ctx,
+		             lr->priv->line_new,
+		             cell_area->x + cell_area->width - xpad,
+		             cell_area->y);
 	}
-	else
-	{
-		*new_str = '\0';
-	}
-
-	g_object_get (lr, "xpad", &xpad, "ypad", &ypad, NULL);
-
-	pango_layout_set_text (layout, old_str, -1);
-	style = gtk_widget_get_style (widget);
-
-	gtk_paint_layout (style,
-	                  window,
-	                  gtk_widget_get_state (widget),
-	                  FALSE,
-	                  NULL,
-	                  widget,
-	                  NULL,
-	                  cell_area->x + cell_area->width / 2 - 1 - xpad,
-	                  cell_area->y,
-	                  layout);
 
-	pango_layout_set_text (layout, new_str, -1);
-	gtk_paint_layout (style,
-	                  window,
-	                  gtk_widget_get_state (widget),
-	                  FALSE,
-	                  NULL,
-	                  widget,
-	                  NULL,
-	                  cell_area->x + cell_area->width - xpad,
-	                  cell_area->y,
-	                  layout);
-
-	g_object_unref (layout);
+	cairo_destroy (ctx);
 
 	gtk_paint_vline (style,
 	                 window,
-	                 gtk_widget_get_state (widget),
+	                 state,
 	                 NULL,
 	                 widget,
 	                 NULL,
@@ -314,16 +408,15 @@ gitg_diff_line_renderer_get_size_impl (GtkCellRenderer *cell,
 	GitgDiffLineRenderer *lr = GITG_DIFF_LINE_RENDERER (cell);
 
 	/* Get size of this rendering */
-	PangoLayout *layout;
-	gchar str[16];
 	gint pixel_width;
 	gint pixel_height;
 	guint xpad;
 	guint ypad;
 
-	g_snprintf(str, sizeof(str), "%d", MAX(MAX(99, lr->priv->line_old), lr->priv->line_new));
-	layout = gtk_widget_create_pango_layout (widget, str);
-	pango_layout_get_pixel_size(layout, &pixel_width, &pixel_height);
+	ensure_digit_cache (lr, widget);
+
+	pixel_width = number_width (lr, MAX (MAX (99, lr->priv->line_old), lr->priv->line_new));
+	pango_layout_get_pixel_size (lr->priv->digits[0], NULL, &pixel_height);
 
 	g_object_get (cell, "xpad", &xpad, "ypad", &ypad, NULL);
 	pixel_width += pixel_width + xpad * 2 + 3;
@@ -343,6 +436,8 @@ gitg_diff_line_renderer_get_size_impl (GtkCellRenderer *cell,
 		                             &lbl_pixel_width,
 		                             &lbl_pixel_height);
 
+		g_object_unref (lbl_layout);
+
 		lbl_pixel_width += 4;
 
 		if (lbl_pixel_width > pixel_width)
@@ -378,8 +473,17 @@ gitg_diff_line_renderer_get_size_impl (GtkCellRenderer *cell,
 	{
 		*y_offset = 0;
 	}
+}
+
+static void
+gitg_diff_line_renderer_finalize (GObject *object)
+{
+	GitgDiffLineRenderer *self = GITG_DIFF_LINE_RENDERER (object);
+
+	clear_digit_cache (self);
+	g_free (self->priv->label);
 
-	g_object_unref (G_OBJECT (layout));
+	G_OBJECT_CLASS (gitg_diff_line_renderer_parent_class)->finalize (object);
 }
 
 static void
@@ -391,6 +495,7 @@ gitg_diff_line_renderer_class_init (GitgDiffLineRendererClass *klass)
 	cell_renderer_class->render = gitg_diff_line_renderer_render_impl;
 	cell_renderer_class->get_size = gitg_diff_line_renderer_get_size_impl;
 
+	object_class->finalize = gitg_diff_line_renderer_finalize;
 	object_class->set_property = gitg_diff_line_renderer_set_property;
 	object_class->get_property = gitg_diff_line_renderer_get_property;
 
@@ -0,0 +1,359 @@
+/*
+ * gitg-diff-spool.c
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "gitg-diff-spool.h"
+#include "gitg-utils.h"
+
+#include <libgitg/gitg-hash.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The diff output is kept in memory while it is being read, and moved to
+   a temporary file once it gets larger than SPOOL_MEMORY_SIZE. Once
+   complete, that file is mapped into memory and lines are only copied out
+   of it for the parts which are actually shown. */
+#define SPOOL_MEMORY_SIZE (4 * 1024 * 1024)
+
+typedef struct
+{
+	guint start;
+
+	gchar index_from[GITG_HASH_SHA_SIZE + 1];
+	gchar index_to[GITG_HASH_SHA_SIZE + 1];
+} SpoolFile;
+
+struct _GitgDiffSpool
+{
+	GString *memory;
+
+	gchar *filename;
+	FILE *out;
+	GMappedFile *mapped;
+
+	/* Offset of the start of each line, followed by the total size */
+	GArray *offsets;
+	GArray *files;
+
+	guint64 size;
+	gboolean failed;
+	gboolean finished;
+};
+
+GitgDiffSpool *
+gitg_diff_spool_new ()
+{
+	GitgDiffSpool *spool;
+
+	spool = g_slice_new0 (GitgDiffSpool);
+
+	spool->memory = g_string_new ("");
+	spool->offsets = g_array_new (FALSE, FALSE, sizeof (guint64));
+	spool->files = g_array_new (FALSE, FALSE, sizeof (SpoolFile));
+
+	return spool;
+}
+
+/* Moves the diff read so far to the temporary file */
+static gboolean
+spill (GitgDiffSpool *spool)
+{
+	gint fd;
+
+	fd = g_file_open_tmp ("gitg-diff-XXXXXX", &spool->filename, NULL);
+
+	if (fd == -1)
+	{
+		return FALSE;
+	}
+
+	spool->out = fdopen (fd, "w");
+
+	if (!spool->out)
+	{
+		close (fd);
+		return FALSE;
+	}
+
+	if (fwrite (spool->memory->str, 1, spool->memory->len, spool->out) != spool->memory->len)
+	{
+		return FALSE;
+	}
+
+	g_string_free (spool->memory, TRUE);
+	spool->memory = NULL;
+
+	return TRUE;
+}
+
+void
+gitg_diff_spool_free (GitgDiffSpool *spool)
+{
+	if (!spool)
+	{
+		return;
+	}
+
+	if (spool->out)
+	{
+		fclose (spool->out);
+	}
+
+	if (spool->mapped)
+	{
+		g_mapped_file_unref (spool->mapped);
+	}
+
+	if (spool->memory)
+	{
+		g_string_free (spool->memory, TRUE);
+	}
+
+	if (spool->filename)
+	{
+		g_unlink (spool->filename);
+		g_free (spool->filename);
+	}
+
+	g_array_free (spool->offsets, TRUE);
+	g_array_free (spool->files, TRUE);
+
+	g_slice_free (GitgDiffSpool, spool);
+}
+
+gboolean
+gitg_diff_spool_append (GitgDiffSpool       *spool,
+                        gchar const * const *lines)
+{
+	g_return_val_if_fail (spool != NULL, FALSE);
+	g_return_val_if_fail (lines != NULL, FALSE);
+
+	if (spool->failed || spool->finished)
+	{
+		return FALSE;
+	}
+
+	for (; *lines; ++lines)
+	{
+		gchar const *line = *lines;
+		gsize len = strlen (line);
+
+		if (g_str_has_prefix (line, "diff --git") ||
+		    g_str_has_prefix (line, "diff --cc"))
+		{
+			SpoolFile file = {spool->offsets->len, "", ""};
+			g_array_append_val (spool->files, file);
+		}
+		else if (spool->files->len > 0 && g_str_has_prefix (line, "index "))
+		{
+			SpoolFile *file = &g_array_index (spool->files,
+			                                  SpoolFile,
+			                                  spool->files->len - 1);
+
+			if (!*file->index_to)
+			{
+				gitg_utils_parse_index_line (line,
+				                             file->index_from,
+				                             file->index_to);
+			}
+		}
+
+		g_array_append_val (spool->offsets, spool->size);
+		spool->size += len + 1;
+
+		if (spool->memory)
+		{
+			g_string_append_len (spool->memory, line, len);
+			g_string_append_c (spool->memory, '\n');
+
+			if (spool->memory->len > SPOOL_MEMORY_SIZE && !spill (spool))
+			{
+				spool->failed = TRUE;
+				return FALSE;
+			}
+		}
+		else if (fwrite (line, 1, len, spool->out) != len ||
+		         fputc ('\n', spool->out) == EOF)
+		{
+			spool->failed = TRUE;
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+gboolean
+gitg_diff_spool_finish (GitgDiffSpool *spool)
+{
+	g_return_val_if_fail (spool != NULL, FALSE);
+
+	if (spool->finished)
+	{
+		return TRUE;
+	}
+
+	if (spool->failed)
+	{
+		return FALSE;
+	}
+
+	if (spool->memory)
+	{
+		/* Small enough to never have needed the file */
+		g_array_append_val (spool->offsets, spool->size);
+		spool->finished = TRUE;
+
+		return TRUE;
+	}
+
+	if (fclose (spool->out) != 0)
+	{
+		spool->out = NULL;
+		spool->failed = TRUE;
+
+		return FALSE;
+	}
+
+	spool->out = NULL;
+	g_array_append_val (spool->offsets, spool->size);
+
+	if (spool->size == 0)
+	{
+		/* Empty files can not be mapped */
+		spool->failed = TRUE;
+		return FALSE;
+	}
+
+	spool->mapped = g_mapped_file_new (spool->filename, FALSE, NULL);
+
+	if (!spool->mapped)
+	{
+		spool->failed = TRUE;
+		return FALSE;
+	}
+
+	/* The mapping stays valid, so the file does not need to stay around */
+	g_unlink (spool->filename);
+	g_free (spool->filename);
+	spool->filename = NULL;
+
+	spool->finished = TRUE;
+	return TRUE;
+}
+
+guint
+gitg_diff_spool_get_n_lines (GitgDiffSpool *spool)
+{
+	g_return_val_if_fail (spool != NULL, 0);
+
+	return spool->finished ? spool->offsets->len - 1 : spool->offsets->len;
+}
+
+guint
+gitg_diff_spool_get_n_files (GitgDiffSpool *spool)
+{
+	g_return_val_if_fail (spool != NULL, 0);
+
+	return spool->files->len;
+}
+
+gboolean
+gitg_diff_spool_get_file_index (GitgDiffSpool  *spool,
+                                guint           file,
+                                gchar const   **from,
+                                gchar const   **to)
+{
+	g_return_val_if_fail (spool != NULL, FALSE);
+
+	if (file >= spool->files->len)
+	{
+		return FALSE;
+	}
+
+	SpoolFile *f = &g_array_index (spool->files, SpoolFile, file);
+
+	if (!*f->index_to)
+	{
+		return FALSE;
+	}
+
+	*from = f->index_from;
+	*to = f->index_to;
+
+	return TRUE;
+}
+
+/* Returns the lines (including their line endings) of the given file in
+   the diff, at most @max_lines of them. Only works after the spool was
+   finished. */
+gchar **
+gitg_diff_spool_get_file_lines (GitgDiffSpool *spool,
+                                guint          file,
+                                guint          max_lines)
+{
+	g_return_val_if_fail (spool != NULL, NULL);
+
+	if (!spool->finished || file >= spool->files->len)
+	{
+		return NULL;
+	}
+
+	gchar const *contents;
+
+	if (spool->mapped)
+	{
+		contents = g_mapped_file_get_contents (spool->mapped);
+	}
+	else
+	{
+		contents = spool->memory->str;
+	}
+	guint start = g_array_index (spool->files, SpoolFile, file).start;
+	guint end;
+	guint i;
+
+	if (file + 1 < spool->files->len)
+	{
+		end = g_array_index (spool->files, SpoolFile, file + 1).start;
+	}
+	else
+	{
+		end = spool->offsets->len - 1;
+	}
+
+	end = MIN (end, start + max_lines);
+
+	gchar **ret = g_new (gchar *, end - start + 1);
+
+	for (i = start; i < end; ++i)
+	{
+		guint64 offset = g_array_index (spool->offsets, guint64, i);
+		guint64 next = g_array_index (spool->offsets, guint64, i + 1);
+
+		ret[i - start] = g_strndup (contents + offset, next - offset);
+	}
+
+	ret[end - start] = NULL;
+	return ret;
+}
@@ -0,0 +1,53 @@
+/*
+ * gitg-diff-spool.h
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GITG_DIFF_SPOOL_H__
+#define __GITG_DIFF_SPOOL_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GitgDiffSpool GitgDiffSpool;
+
+GitgDiffSpool *gitg_diff_spool_new            (void);
+void           gitg_diff_spool_free           (GitgDiffSpool       *spool);
+
+gboolean       gitg_diff_spool_append         (GitgDiffSpool       *spool,
+                                               gchar const * const *lines);
+gboolean       gitg_diff_spool_finish         (GitgDiffSpool       *spool);
+
+guint          gitg_diff_spool_get_n_lines    (GitgDiffSpool       *spool);
+guint          gitg_diff_spool_get_n_files    (GitgDiffSpool       *spool);
+
+gboolean       gitg_diff_spool_get_file_index (GitgDiffSpool       *spool,
+                                               guint                file,
+                                               gchar const        **from,
+                                               gchar const        **to);
+
+gchar        **gitg_diff_spool_get_file_lines (GitgDiffSpool       *spool,
+                                               guint                file,
+                                               guint                max_lines);
+
+G_END_DECLS
+
+#endif /* __GITG_DIFF_SPOOL_H__ */
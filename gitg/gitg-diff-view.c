@@ -108,11 +108,22 @@ typedef struct
 	gchar index_to[GITG_HASH_SHA_SIZE + 1];
 } Header;
 
+typedef struct
+{
+	gint old;
+	gint new;
+} LineCounters;
+
 typedef struct
 {
 	Region region;
 	guint old;
 	guint new;
+
+	/* Old/new line numbers of the lines in the hunk, filled on demand */
+	GArray *lines;
+	guint num_old;
+	guint num_new;
 } Hunk;
 
 struct _GitgDiffViewPrivate
@@ -134,7 +145,6 @@ struct _GitgDiffViewPrivate
 
 	Region *lines_current_region;
 	gint lines_previous_line;
-	guint lines_counters[2];
 
 	gboolean ignore_changes;
 
@@ -180,6 +190,7 @@ region_free (Region   *region,
 	}
 	else
 	{
+		g_array_free (((Hunk *)region)->lines, TRUE);
 		g_slice_free (Hunk, (Hunk *)region);
 	}
 }
@@ -577,7 +588,8 @@ add_region (GitgDiffView *view, Region *region)
 		hide_header_details (view, region->prev);
 	}
 
-	g_sequence_insert_sorted (view->priv->regions_index, region, index_compare, NULL);
+	/* Regions are always scanned in order of their lines */
+	g_sequence_append (view->priv->regions_index, region);
 
 	GitgDiffIter iter;
 	region_to_iter (view, region, &iter);
@@ -593,18 +605,14 @@ add_region (GitgDiffView *view, Region *region)
 }
 
 static void
-parse_hunk_info (Hunk *hunk, GtkTextIter *iter)
+parse_hunk_info (Hunk        *hunk,
+                 gchar const *text)
 {
-	GtkTextIter end = *iter;
-
-	gtk_text_iter_forward_to_line_end (&end);
-	gchar *text = gtk_text_iter_get_text (iter, &end);
-
 	hunk->old = 0;
 	hunk->new = 0;
 
-	gchar *old = g_utf8_strchr (text, -1, '-');
-	gchar *new = g_utf8_strchr (text, -1, '+');
+	gchar const *old = strchr (text, '-');
+	gchar const *new = strchr (text, '+');
 
 	if (!old || !new)
 	{
@@ -613,8 +621,57 @@ parse_hunk_info (Hunk *hunk, GtkTextIter *iter)
 
 	hunk->old = atoi (old + 1);
 	hunk->new = atoi (new + 1);
+}
 
-	g_free (text);
+static void
+scan_line (GitgDiffView *view,
+           guint         line,
+           gchar const  *text)
+{
+	if (g_str_has_prefix (text, "@@ ") || g_str_has_prefix (text, "@@@"))
+	{
+		/* start new hunk region */
+		Hunk *hunk = g_slice_new (Hunk);
+		hunk->region.type = GITG_DIFF_ITER_TYPE_HUNK;
+		hunk->region.line = line;
+		hunk->region.visible = TRUE;
+		hunk->region.next = NULL;
+
+		hunk->lines = g_array_new (FALSE, FALSE, sizeof (LineCounters));
+		hunk->num_old = 0;
+		hunk->num_new = 0;
+
+		parse_hunk_info (hunk, text);
+
+		add_region (view, (Region *)hunk);
+	}
+	else if (g_str_has_prefix (text, "diff --git") || g_str_has_prefix (text, "diff --cc"))
+	{
+		/* start new header region */
+		Header *header = g_slice_new (Header);
+		header->region.type = GITG_DIFF_ITER_TYPE_HEADER;
+		header->region.line = line;
+		header->region.visible = TRUE;
+		header->region.next = NULL;
+
+		header->index_to[0] = '\0';
+		header->index_from[0] = '\0';
+
+		add_region (view, (Region *)header);
+	}
+	else if (view->priv->last_region &&
+	         view->priv->last_region->type == GITG_DIFF_ITER_TYPE_HEADER &&
+	         *text == 'i')
+	{
+		Header *header = (Header *)view->priv->last_region;
+
+		if (!*header->index_to)
+		{
+			gitg_utils_parse_index_line (text,
+			                             header->index_from,
+			                             header->index_to);
+		}
+	}
 }
 
 static void
@@ -628,62 +685,25 @@ ensure_scan (GitgDiffView *view, guint last_line)
 	while (view->priv->last_scan_line <= last_line)
 	{
 		GtkTextIter start = iter;
-		GtkTextIter end = iter;
 
 		if (!gtk_text_iter_forward_line (&iter))
 		{
 			break;
 		}
 
-		++view->priv->last_scan_line;
-
-		if (!gtk_text_iter_forward_chars (&end, 3))
-		{
-			continue;
-		}
-
-		gchar *text = gtk_text_iter_get_text (&start, &end);
+		gunichar ch = gtk_text_iter_get_char (&start);
 
-		if (g_str_has_prefix (text, "@@ ") || g_str_has_prefix (text, "@@@"))
+		/* Only lines starting with one of these can start a region or
+		   carry the index of a header, skip the rest without copying */
+		if (ch == '@' || ch == 'd' || ch == 'i')
 		{
-			/* start new hunk region */
-			Hunk *hunk = g_slice_new (Hunk);
-			hunk->region.type = GITG_DIFF_ITER_TYPE_HUNK;
-			hunk->region.line = view->priv->last_scan_line - 1;
-			hunk->region.visible = TRUE;
-
-			parse_hunk_info (hunk, &start);
-
-			add_region (view, (Region *)hunk);
+			gchar *text = gtk_text_iter_get_slice (&start, &iter);
 
+			scan_line (view, view->priv->last_scan_line, text);
 			g_free (text);
-			continue;
-		}
-
-		g_free (text);
-
-		if (!gtk_text_iter_forward_chars (&end, 7))
-		{
-			continue;
-		}
-
-		text = gtk_text_iter_get_text (&start, &end);
-
-		if (g_str_has_prefix (text, "diff --git") || g_str_has_prefix (text, "diff --cc"))
-		{
-			/* start new header region */
-			Header *header = g_slice_new (Header);
-			header->region.type = GITG_DIFF_ITER_TYPE_HEADER;
-			header->region.line = view->priv->last_scan_line - 1;
-			header->region.visible = TRUE;
-
-			header->index_to[0] = '\0';
-			header->index_from[0] = '\0';
-
-			add_region (view, (Region *)header);
 		}
 
-		g_free (text);
+		++view->priv->last_scan_line;
 	}
 
 	if (view->priv->last_region && view->priv->last_region->type == GITG_DIFF_ITER_TYPE_HUNK)
@@ -719,54 +739,65 @@ find_current_region (GitgDiffView *view, guint line)
 	return ret->visible ? ret : NULL;
 }
 
-static gboolean
-line_has_prefix (GitgDiffView *view, guint line, gchar const *prefix)
+static void
+hunk_reset_lines (Hunk *hunk)
 {
-	GtkTextIter iter;
+	g_array_set_size (hunk->lines, 0);
 
-	gtk_text_buffer_get_iter_at_line (view->priv->current_buffer, &iter, line);
+	hunk->num_old = 0;
+	hunk->num_new = 0;
+}
 
-	GtkTextIter end = iter;
+static LineCounters *
+hunk_get_line_counters (GitgDiffView *view,
+                        Hunk         *hunk,
+                        guint         line,
+                        LineCounters *tmp)
+{
+	guint idx = line - hunk->region.line - 1;
+	GtkTextIter iter;
 
-	if (!gtk_text_iter_forward_chars (&end, g_utf8_strlen (prefix, -1)))
+	if (idx < hunk->lines->len)
 	{
-		return FALSE;
+		return &g_array_index (hunk->lines, LineCounters, idx);
 	}
 
-	gchar *text = gtk_text_iter_get_text (&iter, &end);
-	gboolean ret = g_str_has_prefix (text, prefix);
-	g_free (text);
-
-	return ret;
-}
+	/* Continue counting from the last known line of the hunk */
+	gtk_text_buffer_get_iter_at_line (view->priv->current_buffer,
+	                                  &iter,
+	                                  hunk->region.line + 1 + hunk->lines->len);
 
-static gboolean
-draw_old (GitgDiffView *view, guint line)
-{
-	return !line_has_prefix (view, line, "+");
-}
+	while (hunk->lines->len <= idx)
+	{
+		GtkTextIter next = iter;
+		gunichar ch = gtk_text_iter_get_char (&iter);
+		LineCounters counters;
 
-static gboolean
-draw_new (GitgDiffView *view, guint line)
-{
-	return !line_has_prefix (view, line, "-");
-}
+		counters.old = ch != '+' ? (gint)(hunk->old + hunk->num_old) : -1;
+		counters.new = ch != '-' ? (gint)(hunk->new + hunk->num_new) : -1;
 
-static void
-get_initial_counters (GitgDiffView *view, Region *region, guint line, guint counters[2])
-{
-	guint i;
+		if (!gtk_text_iter_forward_line (&next))
+		{
+			/* The last line might still be appended to, don't store it */
+			*tmp = counters;
+			return tmp;
+		}
 
-	counters[0] = counters[1] = 0;
+		if (counters.old != -1)
+		{
+			++hunk->num_old;
+		}
 
-	for (i = region->line + 1; i < line; ++i)
-	{
-		if (draw_old (view, i))
-			++counters[0];
+		if (counters.new != -1)
+		{
+			++hunk->num_new;
+		}
 
-		if (draw_new (view, i))
-			++counters[1];
+		g_array_append_val (hunk->lines, counters);
+		iter = next;
 	}
+
+	return &g_array_index (hunk->lines, LineCounters, idx);
 }
 
 static void
@@ -806,14 +837,6 @@ line_renderer_data_func (GtkSourceGutter *gutter,
 	if (!*current || view->priv->lines_previous_line + 1 != line_number)
 	{
 		*current = find_current_region (view, line_number);
-
-		if (*current)
-		{
-			get_initial_counters (view,
-			                      *current,
-			                      line_number,
-			                      view->priv->lines_counters);
-		}
 	}
 
 	view->priv->lines_previous_line = line_number;
@@ -822,24 +845,22 @@ line_renderer_data_func (GtkSourceGutter *gutter,
 	    (*current)->type == GITG_DIFF_ITER_TYPE_HUNK &&
 	    line_number != (*current)->line)
 	{
-		Hunk *hunk = (Hunk *)*current;
+		LineCounters tmp;
+		LineCounters *counters;
 
-		if (draw_old (view, line_number))
-		{
-			line_old = hunk->old + view->priv->lines_counters[0]++;
-		}
+		counters = hunk_get_line_counters (view,
+		                                   (Hunk *)*current,
+		                                   line_number,
+		                                   &tmp);
 
-		if (draw_new (view, line_number))
-		{
-			line_new = hunk->new + view->priv->lines_counters[1]++;
-		}
+		line_old = counters->old;
+		line_new = counters->new;
 	}
 
 	g_object_set (cell, "line_old", line_old, "line_new", line_new, NULL);
 
 	if (*current && (*current)->next && line_number == (*current)->next->line - 1)
 	{
-		view->priv->lines_counters[0] = view->priv->lines_counters[1] = 0;
 		*current = (*current)->next->visible ? (*current)->next : NULL;
 	}
 
@@ -863,8 +884,6 @@ gitg_diff_view_expose (GtkWidget      *widget,
 	/* Prepare for new round of expose on the line renderer */
 	view->priv->lines_current_region = NULL;
 	view->priv->lines_previous_line = -1;
-	view->priv->lines_counters[0] = 0;
-	view->priv->lines_counters[1] = 0;
 
 	if (GTK_WIDGET_CLASS (gitg_diff_view_parent_class)->expose_event)
 	{
@@ -1212,39 +1231,20 @@ header_parse_index (GitgDiffView *view, Header *header)
 		if (!gtk_text_iter_forward_line (&iter))
 			return FALSE;
 
+		if (gtk_text_iter_get_char (&iter) != 'i')
+			continue;
+
 		GtkTextIter end = iter;
 		gtk_text_iter_forward_to_line_end (&end);
 
 		/* get line contents */
 		gchar *line = gtk_text_iter_get_text (&iter, &end);
-		gchar match[] = "index ";
 
-		if (g_str_has_prefix (line, match))
+		if (g_str_has_prefix (line, "index "))
 		{
-			gchar *start = line + strlen (match);
-			gchar *sep = strstr (start, "..");
-			gboolean ret;
-
-			if (sep)
-			{
-				gchar *last = strstr (sep, " ");
-				gchar *bet = strstr (start, ",");
-
-				if (!last)
-					last = line + strlen (line);
-
-				strncpy (header->index_from, start, (bet ? bet : sep) - start);
-				strncpy (header->index_to, sep + 2, last - (sep + 2));
-
-				header->index_from[ (bet ? bet : sep) - start] = '\0';
-				header->index_to[last - (sep + 2)] = '\0';
-
-				ret = TRUE;
-			}
-			else
-			{
-				ret = FALSE;
-			}
+			gboolean ret = gitg_utils_parse_index_line (line,
+			                                            header->index_from,
+			                                            header->index_to);
 
 			g_free (line);
 			return ret;
@@ -1661,6 +1661,9 @@ gitg_diff_view_clear_line (GitgDiffView *view,
 		offset_regions (region->next, -1);
 	}
 
+	/* Line numbers in the hunk have changed */
+	hunk_reset_lines ((Hunk *)region);
+
 	calculate_hunk_header_counters (view, region);
 
 	view->priv->ignore_changes = FALSE;
@@ -1685,3 +1688,97 @@ gitg_diff_view_set_label_func (GitgDiffView *view,
 	view->priv->label_func_user_data = user_data;
 	view->priv->label_func_destroy_notify = destroy_notify;
 }
+
+/* Append lines to the buffer, building the region index directly from the
+   lines instead of rescanning the buffer afterwards. When @add_newline is
+   TRUE a newline is inserted after each line, otherwise the lines are
+   expected to carry their own line endings. */
+void
+gitg_diff_view_append_lines (GitgDiffView       *view,
+                             gchar const *const *lines,
+                             gboolean            add_newline)
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter iter;
+	gboolean scan;
+	guint num;
+	guint i;
+	guint *starts = NULL;
+
+	g_return_if_fail (GITG_IS_DIFF_VIEW (view));
+	g_return_if_fail (lines != NULL);
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
+	gtk_text_buffer_get_end_iter (buffer, &iter);
+
+	/* The lines can only be indexed when they start at a line boundary */
+	scan = view->priv->diff_enabled &&
+	       buffer == view->priv->current_buffer &&
+	       gtk_text_iter_starts_line (&iter);
+
+	num = g_strv_length ((gchar **)lines);
+
+	if (scan)
+	{
+		guint line = gtk_text_iter_get_line (&iter);
+
+		/* Make sure regions before the new lines are known, so that new
+		   regions are added in order */
+		if (view->priv->last_scan_line < line)
+		{
+			ensure_scan (view, line - 1);
+		}
+
+		scan = view->priv->last_scan_line == line;
+	}
+
+	if (scan)
+	{
+		starts = g_new (guint, num);
+		view->priv->ignore_changes = TRUE;
+	}
+
+	for (i = 0; i < num; ++i)
+	{
+		if (scan)
+		{
+			starts[i] = gtk_text_iter_get_line (&iter);
+		}
+
+		gtk_text_buffer_insert (buffer, &iter, lines[i], -1);
+
+		if (add_newline)
+		{
+			gtk_text_buffer_insert (buffer, &iter, "\n", 1);
+		}
+	}
+
+	if (!scan)
+	{
+		return;
+	}
+
+	view->priv->ignore_changes = FALSE;
+
+	for (i = 0; i < num; ++i)
+	{
+		/* A trailing line without line ending is left for the normal scan,
+		   more text might still be appended to it */
+		if (!add_newline && !g_str_has_suffix (lines[i], "\n"))
+		{
+			break;
+		}
+
+		scan_line (view, starts[i], lines[i]);
+
+		view->priv->last_scan_line = i + 1 < num ? starts[i + 1]
+		                                         : (guint)gtk_text_iter_get_line (&iter);
+	}
+
+	g_free (starts);
+
+	if (view->priv->last_region && view->priv->last_region->type == GITG_DIFF_ITER_TYPE_HUNK)
+	{
+		ensure_max_line (view, (Hunk *)view->priv->last_region);
+	}
+}
@@ -105,6 +105,10 @@ void gitg_diff_iter_get_bounds (GitgDiffIter const *iter, GtkTextIter *start, Gt
 GitgDiffLineType gitg_diff_view_get_line_type (GitgDiffView *view, GtkTextIter const *iter);
 void gitg_diff_view_clear_line (GitgDiffView *view, GtkTextIter const *iter, GitgDiffLineType old_type, GitgDiffLineType new_type);
 
+void gitg_diff_view_append_lines (GitgDiffView       *view,
+                                  gchar const *const *lines,
+                                  gboolean            add_newline);
+
 void gitg_diff_view_set_label_func (GitgDiffView *view,
                                     GitgDiffViewLabelFunc func,
                                     gpointer user_data,
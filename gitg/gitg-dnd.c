@@ -888,7 +888,15 @@ gitg_drag_source_data_get_cb (GtkWidget        *widget,
 		return;
 	}
 
-	GitgRepository *repository = GITG_REPOSITORY (gtk_tree_view_get_model (GTK_TREE_VIEW (widget)));
+	GtkTreeModel *model = gtk_tree_view_get_model (GTK_TREE_VIEW (widget));
+
+	/* The history might be filtered on a search */
+	if (GTK_IS_TREE_MODEL_FILTER (model))
+	{
+		model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (model));
+	}
+
+	GitgRepository *repository = GITG_REPOSITORY (model);
 
 	if (has_direct_save (data, widget, context))
 	{
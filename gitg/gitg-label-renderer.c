@@ -44,6 +44,123 @@ get_label_width (PangoLayout *layout, GitgRef *ref)
 	return w + PADDING * 2;
 }
 
+#define LABEL_CACHE_KEY "GitgLabelRendererCache"
+#define LABEL_CACHE_SIZE 500
+
+/* Measured widths and prerendered labels of a widget, valid for a
+   single font and style */
+typedef struct
+{
+	PangoFontDescription *font;
+	PangoLayout *layout;
+
+	GHashTable *widths;
+	GHashTable *surfaces;
+} LabelCache;
+
+static void
+label_cache_clear (LabelCache *cache)
+{
+	if (cache->font)
+	{
+		pango_font_description_free (cache->font);
+		cache->font = NULL;
+	}
+
+	if (cache->layout)
+	{
+		g_object_unref (cache->layout);
+		cache->layout = NULL;
+	}
+
+	g_hash_table_remove_all (cache->widths);
+	g_hash_table_remove_all (cache->surfaces);
+}
+
+static void
+label_cache_free (LabelCache *cache)
+{
+	label_cache_clear (cache);
+
+	g_hash_table_destroy (cache->widths);
+	g_hash_table_destroy (cache->surfaces);
+
+	g_slice_free (LabelCache, cache);
+}
+
+static void
+on_label_cache_style_set (GtkWidget *widget, GtkStyle *prev, LabelCache *cache)
+{
+	/* Theme or font changed, everything has to be measured again */
+	label_cache_clear (cache);
+}
+
+static LabelCache *
+get_label_cache (GtkWidget *widget, PangoFontDescription *description)
+{
+	LabelCache *cache = g_object_get_data (G_OBJECT (widget), LABEL_CACHE_KEY);
+
+	if (!cache)
+	{
+		cache = g_slice_new0 (LabelCache);
+
+		cache->widths = g_hash_table_new_full (g_str_hash,
+		                                       g_str_equal,
+		                                       g_free,
+		                                       NULL);
+
+		cache->surfaces = g_hash_table_new_full (g_str_hash,
+		                                         g_str_equal,
+		                                         g_free,
+		                                         (GDestroyNotify)cairo_surface_destroy);
+
+		g_object_set_data_full (G_OBJECT (widget),
+		                        LABEL_CACHE_KEY,
+		                        cache,
+		                        (GDestroyNotify)label_cache_free);
+
+		g_signal_connect (widget,
+		                  "style-set",
+		                  G_CALLBACK (on_label_cache_style_set),
+		                  cache);
+	}
+
+	if (cache->font && !pango_font_description_equal (cache->font, description))
+	{
+		label_cache_clear (cache);
+	}
+
+	if (!cache->font)
+	{
+		cache->font = pango_font_description_copy (description);
+		cache->layout = pango_layout_new (gtk_widget_get_pango_context (widget));
+
+		pango_layout_set_font_description (cache->layout, cache->font);
+	}
+
+	return cache;
+}
+
+static gint
+get_cached_label_width (LabelCache *cache, GitgRef *ref)
+{
+	gpointer width;
+	gchar const *name = gitg_ref_get_shortname (ref);
+
+	if (g_hash_table_lookup_extended (cache->widths, name, NULL, &width))
+	{
+		return GPOINTER_TO_INT (width);
+	}
+
+	gint w = get_label_width (cache->layout, ref);
+
+	g_hash_table_insert (cache->widths,
+	                     g_strdup (name),
+	                     GINT_TO_POINTER (w));
+
+	return w;
+}
+
 gint
 gitg_label_renderer_width(GtkWidget *widget, PangoFontDescription *description, GSList *labels)
 {
@@ -53,18 +170,13 @@ gitg_label_renderer_width(GtkWidget *widget, PangoFontDescription *description,
 	if (labels == NULL)
 		return 0;
 
-	PangoContext *ctx = gtk_widget_get_pango_context(widget);
-	PangoLayout *layout = pango_layout_new(ctx);
-	pango_layout_set_font_description(layout, description);
+	LabelCache *cache = get_label_cache (widget, description);
 
 	for (item = labels; item; item = item->next)
 	{
-		width += get_label_width (layout, GITG_REF (item->data)) + MARGIN;
+		width += get_cached_label_width (cache, GITG_REF (item->data)) + MARGIN;
 	}
 
-	g_object_unref(layout);
-	//g_object_unref(ctx);
-
 	return width + MARGIN;
 }
 
@@ -183,30 +295,74 @@ render_label (cairo_t *context, PangoLayout *layout, GitgRef *ref, gint x, gint
 	return w;
 }
 
+static cairo_surface_t *
+get_label_surface (LabelCache *cache, GitgRef *ref, gint height)
+{
+	gchar *key = g_strdup_printf ("%d:%d:%d:%d:%s",
+	                              height,
+	                              gitg_ref_get_ref_type (ref),
+	                              gitg_ref_get_working (ref),
+	                              gitg_ref_get_state (ref),
+	                              gitg_ref_get_shortname (ref));
+
+	cairo_surface_t *surface = g_hash_table_lookup (cache->surfaces, key);
+
+	if (surface)
+	{
+		g_free (key);
+		return surface;
+	}
+
+	if (g_hash_table_size (cache->surfaces) >= LABEL_CACHE_SIZE)
+	{
+		g_hash_table_remove_all (cache->surfaces);
+	}
+
+	/* Leave room for the outline stroke on the right */
+	gint width = get_cached_label_width (cache, ref) + 1;
+
+	surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+	cairo_t *context = cairo_create (surface);
+
+	cairo_set_line_width (context, 1.0);
+	render_label (context, cache->layout, ref, 0, 0, height, TRUE);
+	cairo_destroy (context);
+
+	g_hash_table_insert (cache->surfaces, key, surface);
+	return surface;
+}
+
 void
 gitg_label_renderer_draw(GtkWidget *widget, PangoFontDescription *description, cairo_t *context, GSList *labels, GdkRectangle *area)
 {
 	GSList *item;
-	double pos = MARGIN + 0.5;
+	gint pos = MARGIN;
 
-	cairo_save(context);
-	cairo_set_line_width(context, 1.0);
+	if (!labels || area->height <= 0)
+	{
+		return;
+	}
 
-	PangoContext *ctx = gtk_widget_get_pango_context(widget);
-	PangoLayout *layout = pango_layout_new(ctx);
-	pango_layout_set_font_description(layout, description);
+	LabelCache *cache = get_label_cache (widget, description);
+
+	cairo_save(context);
 
 	for (item = labels; item; item = item->next)
 	{
-		gint w = render_label (context, layout, GITG_REF (item->data), pos, area->y, area->height, TRUE);
-		pos += w + PADDING * 2 + MARGIN;
+		GitgRef *ref = GITG_REF (item->data);
+
+		cairo_set_source_surface (context,
+		                          get_label_surface (cache, ref, area->height),
+		                          pos,
+		                          area->y);
+		cairo_paint (context);
+
+		pos += get_cached_label_width (cache, ref) + MARGIN;
 	}
 
-	g_object_unref(layout);
 	cairo_restore(context);
 }
 
-
 GitgRef *
 gitg_label_renderer_get_ref_at_pos (GtkWidget *widget, PangoFontDescription *font, GSList *labels, gint x, gint *hot_x)
 {
@@ -215,17 +371,14 @@ gitg_label_renderer_get_ref_at_pos (GtkWidget *widget, PangoFontDescription *fon
 		return NULL;
 	}
 
-	PangoContext *ctx = gtk_widget_get_pango_context(widget);
-	PangoLayout *layout = pango_layout_new(ctx);
-	pango_layout_set_font_description(layout, font);
-
 	gint start = MARGIN;
 	GitgRef *ret = NULL;
 	GSList *item;
+	LabelCache *cache = get_label_cache (widget, font);
 
 	for (item = labels; item; item = item->next)
 	{
-		gint width = get_label_width (layout, GITG_REF (item->data));
+		gint width = get_cached_label_width (cache, GITG_REF (item->data));
 
 		if (x >= start && x <= start + width)
 		{
@@ -242,7 +395,6 @@ gitg_label_renderer_get_ref_at_pos (GtkWidget *widget, PangoFontDescription *fon
 		start += width + MARGIN;
 	}
 
-	g_object_unref(layout);
 	return ret;
 }
 
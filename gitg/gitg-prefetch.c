@@ -0,0 +1,504 @@
+/*
+ * gitg-prefetch.c
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "gitg-prefetch.h"
+
+#include <libgitg/gitg-shell.h>
+#include <libgitg/gitg-commit-cache.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define PREFETCH_KEY "GitgPrefetch"
+
+/* The cursor has to rest this long (in ms) before neighbours are warmed */
+#define PREFETCH_DELAY 150
+
+/* Cursor moves closer together than this (in s) cancel running prefetches */
+#define PREFETCH_FAST_INTERVAL 0.1
+
+/* Rows warmed in the direction of movement, and behind the cursor */
+#define PREFETCH_AHEAD 3
+#define PREFETCH_BEHIND 1
+
+/* Diffs are only warmed for commits with at most this many changes */
+#define PREFETCH_MAX_DIFF_FILES 100
+#define PREFETCH_MAX_DIFF_LINES 2000
+
+typedef struct
+{
+	GitgCommitCacheKind kind;
+	gchar *sha;
+} Job;
+
+struct _GitgPrefetch
+{
+	GitgRepository *repository;
+	GitgCommitCache *cache;
+
+	GitgShell *shell;
+	Job *running;
+	GPtrArray *lines;
+
+	GQueue *jobs;
+	guint job_id;
+
+	GTimer *timer;
+	gint row;
+	gint direction;
+	guint timeout_id;
+};
+
+static gboolean run_next_job (GitgPrefetch *prefetch);
+
+static Job *
+job_new (GitgCommitCacheKind  kind,
+         gchar const         *sha)
+{
+	Job *job = g_slice_new (Job);
+
+	job->kind = kind;
+	job->sha = g_strdup (sha);
+
+	return job;
+}
+
+static void
+job_free (Job *job)
+{
+	if (job)
+	{
+		g_free (job->sha);
+		g_slice_free (Job, job);
+	}
+}
+
+static void
+clear_jobs (GitgPrefetch *prefetch)
+{
+	Job *job;
+
+	while ((job = g_queue_pop_head (prefetch->jobs)))
+	{
+		job_free (job);
+	}
+}
+
+static void
+free_lines (GitgPrefetch *prefetch)
+{
+	if (prefetch->lines)
+	{
+		g_ptr_array_foreach (prefetch->lines, (GFunc)g_free, NULL);
+		g_ptr_array_free (prefetch->lines, TRUE);
+		prefetch->lines = NULL;
+	}
+}
+
+static gboolean
+has_job (GitgPrefetch        *prefetch,
+         GitgCommitCacheKind  kind,
+         gchar const         *sha)
+{
+	GList *item;
+
+	if (prefetch->running &&
+	    prefetch->running->kind == kind &&
+	    strcmp (prefetch->running->sha, sha) == 0)
+	{
+		return TRUE;
+	}
+
+	for (item = prefetch->jobs->head; item; item = g_list_next (item))
+	{
+		Job *job = item->data;
+
+		if (job->kind == kind && strcmp (job->sha, sha) == 0)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gboolean
+diff_is_small (gchar **lines)
+{
+	guint files = 0;
+	guint changed = 0;
+
+	for (; *lines; ++lines)
+	{
+		gchar *ptr;
+
+		if (**lines == ':')
+		{
+			++files;
+		}
+		else if (**lines)
+		{
+			/* numstat line, binary files have - for both counts */
+			changed += strtoul (*lines, &ptr, 10);
+			changed += strtoul (ptr, NULL, 10);
+		}
+	}
+
+	return files <= PREFETCH_MAX_DIFF_FILES &&
+	       changed <= PREFETCH_MAX_DIFF_LINES;
+}
+
+static void
+on_shell_update (GitgShell     *shell,
+                 gchar        **lines,
+                 GitgPrefetch  *prefetch)
+{
+	if (!prefetch->lines)
+	{
+		return;
+	}
+
+	for (; *lines; ++lines)
+	{
+		g_ptr_array_add (prefetch->lines, g_strdup (*lines));
+	}
+
+	if (prefetch->lines->len > GITG_COMMIT_CACHE_MAX_LINES)
+	{
+		/* Too big to keep, the panel will load it when needed */
+		free_lines (prefetch);
+	}
+}
+
+static void
+on_shell_end (GitgShell    *shell,
+              GError       *error,
+              GitgPrefetch *prefetch)
+{
+	Job *job = prefetch->running;
+
+	prefetch->running = NULL;
+
+	if (!job)
+	{
+		return;
+	}
+
+	if (!gitg_io_get_cancelled (GITG_IO (shell)) &&
+	    gitg_io_get_exit_status (GITG_IO (shell)) == 0 &&
+	    prefetch->lines)
+	{
+		gitg_commit_cache_store (prefetch->cache,
+		                         job->kind,
+		                         job->sha,
+		                         NULL,
+		                         prefetch->lines);
+		prefetch->lines = NULL;
+
+		if (job->kind == GITG_COMMIT_CACHE_DIFF_FILES &&
+		    !gitg_commit_cache_contains (prefetch->cache,
+		                                 GITG_COMMIT_CACHE_DIFF,
+		                                 job->sha,
+		                                 NULL))
+		{
+			gchar **files = gitg_commit_cache_lookup (prefetch->cache,
+			                                          GITG_COMMIT_CACHE_DIFF_FILES,
+			                                          job->sha,
+			                                          NULL);
+
+			if (files && diff_is_small (files))
+			{
+				g_queue_push_head (prefetch->jobs,
+				                   job_new (GITG_COMMIT_CACHE_DIFF, job->sha));
+			}
+		}
+	}
+
+	free_lines (prefetch);
+	job_free (job);
+
+	if (!prefetch->job_id && !g_queue_is_empty (prefetch->jobs))
+	{
+		/* The shell can not be restarted from within its end handler */
+		prefetch->job_id = g_idle_add ((GSourceFunc)run_next_job, prefetch);
+	}
+}
+
+static void
+gitg_prefetch_free (GitgPrefetch *prefetch)
+{
+	gitg_prefetch_cancel (prefetch);
+
+	g_signal_handlers_disconnect_by_func (prefetch->shell,
+	                                      on_shell_update,
+	                                      prefetch);
+
+	g_signal_handlers_disconnect_by_func (prefetch->shell,
+	                                      on_shell_end,
+	                                      prefetch);
+
+	g_object_unref (prefetch->shell);
+
+	g_queue_free (prefetch->jobs);
+	g_timer_destroy (prefetch->timer);
+
+	g_slice_free (GitgPrefetch, prefetch);
+}
+
+GitgPrefetch *
+gitg_prefetch_get (GitgRepository *repository)
+{
+	GitgPrefetch *prefetch;
+
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), NULL);
+
+	prefetch = g_object_get_data (G_OBJECT (repository), PREFETCH_KEY);
+
+	if (prefetch)
+	{
+		return prefetch;
+	}
+
+	prefetch = g_slice_new0 (GitgPrefetch);
+
+	/* Not referenced, the prefetcher lives as long as the repository */
+	prefetch->repository = repository;
+	prefetch->cache = gitg_repository_get_commit_cache (repository);
+
+	prefetch->jobs = g_queue_new ();
+	prefetch->timer = g_timer_new ();
+	prefetch->row = -1;
+	prefetch->direction = 1;
+
+	prefetch->shell = gitg_shell_new (1000);
+
+	g_signal_connect (prefetch->shell,
+	                  "update",
+	                  G_CALLBACK (on_shell_update),
+	                  prefetch);
+
+	g_signal_connect (prefetch->shell,
+	                  "end",
+	                  G_CALLBACK (on_shell_end),
+	                  prefetch);
+
+	g_object_set_data_full (G_OBJECT (repository),
+	                        PREFETCH_KEY,
+	                        prefetch,
+	                        (GDestroyNotify)gitg_prefetch_free);
+
+	return prefetch;
+}
+
+static gboolean
+run_next_job (GitgPrefetch *prefetch)
+{
+	Job *job;
+
+	prefetch->job_id = 0;
+
+	if (prefetch->running)
+	{
+		return FALSE;
+	}
+
+	while ((job = g_queue_pop_head (prefetch->jobs)))
+	{
+		if (!gitg_commit_cache_contains (prefetch->cache,
+		                                 job->kind,
+		                                 job->sha,
+		                                 NULL))
+		{
+			break;
+		}
+
+		job_free (job);
+	}
+
+	if (!job)
+	{
+		return FALSE;
+	}
+
+	prefetch->running = job;
+	prefetch->lines = g_ptr_array_new ();
+
+	if (!gitg_shell_run (prefetch->shell,
+	                     gitg_commit_cache_command_new (prefetch->repository,
+	                                                    job->kind,
+	                                                    job->sha,
+	                                                    NULL),
+	                     NULL) &&
+	    prefetch->running == job)
+	{
+		/* Not ended through on_shell_end */
+		prefetch->running = NULL;
+		job_free (job);
+		free_lines (prefetch);
+	}
+
+	return FALSE;
+}
+
+static void
+queue_row (GitgPrefetch *prefetch,
+           gint          row)
+{
+	GtkTreeIter iter;
+	GitgRevision *revision = NULL;
+	gchar *sha;
+
+	if (row < 0 ||
+	    !gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (prefetch->repository),
+	                                    &iter,
+	                                    NULL,
+	                                    row))
+	{
+		return;
+	}
+
+	gtk_tree_model_get (GTK_TREE_MODEL (prefetch->repository),
+	                    &iter,
+	                    0, &revision,
+	                    -1);
+
+	if (!gitg_commit_cache_can_cache (revision))
+	{
+		if (revision)
+		{
+			gitg_revision_unref (revision);
+		}
+
+		return;
+	}
+
+	sha = gitg_revision_get_sha1 (revision);
+
+	if (!gitg_commit_cache_contains (prefetch->cache,
+	                                 GITG_COMMIT_CACHE_DETAILS,
+	                                 sha,
+	                                 NULL) &&
+	    !has_job (prefetch, GITG_COMMIT_CACHE_DETAILS, sha))
+	{
+		g_queue_push_tail (prefetch->jobs,
+		                   job_new (GITG_COMMIT_CACHE_DETAILS, sha));
+	}
+
+	if (!gitg_commit_cache_contains (prefetch->cache,
+	                                 GITG_COMMIT_CACHE_DIFF_FILES,
+	                                 sha,
+	                                 NULL) &&
+	    !has_job (prefetch, GITG_COMMIT_CACHE_DIFF_FILES, sha))
+	{
+		g_queue_push_tail (prefetch->jobs,
+		                   job_new (GITG_COMMIT_CACHE_DIFF_FILES, sha));
+	}
+
+	g_free (sha);
+	gitg_revision_unref (revision);
+}
+
+static gboolean
+on_cursor_rested (GitgPrefetch *prefetch)
+{
+	gint i;
+
+	prefetch->timeout_id = 0;
+
+	clear_jobs (prefetch);
+
+	for (i = 1; i <= PREFETCH_AHEAD; ++i)
+	{
+		queue_row (prefetch, prefetch->row + prefetch->direction * i);
+	}
+
+	for (i = 1; i <= PREFETCH_BEHIND; ++i)
+	{
+		queue_row (prefetch, prefetch->row - prefetch->direction * i);
+	}
+
+	if (prefetch->job_id)
+	{
+		g_source_remove (prefetch->job_id);
+	}
+
+	run_next_job (prefetch);
+	return FALSE;
+}
+
+void
+gitg_prefetch_cursor_moved (GitgPrefetch *prefetch,
+                            gint          row)
+{
+	gdouble elapsed;
+
+	g_return_if_fail (prefetch != NULL);
+
+	elapsed = g_timer_elapsed (prefetch->timer, NULL);
+	g_timer_start (prefetch->timer);
+
+	if (prefetch->row >= 0 && row != prefetch->row)
+	{
+		prefetch->direction = row > prefetch->row ? 1 : -1;
+	}
+
+	prefetch->row = row;
+
+	/* Neighbours queued for the previous row are no longer the best
+	   guess, they get queued again once the cursor rests */
+	clear_jobs (prefetch);
+
+	if (elapsed < PREFETCH_FAST_INTERVAL)
+	{
+		/* Moving quickly, rows being warmed will likely be skipped */
+		gitg_io_cancel (GITG_IO (prefetch->shell));
+	}
+
+	if (prefetch->timeout_id)
+	{
+		g_source_remove (prefetch->timeout_id);
+	}
+
+	prefetch->timeout_id = g_timeout_add (PREFETCH_DELAY,
+	                                      (GSourceFunc)on_cursor_rested,
+	                                      prefetch);
+}
+
+void
+gitg_prefetch_cancel (GitgPrefetch *prefetch)
+{
+	g_return_if_fail (prefetch != NULL);
+
+	if (prefetch->timeout_id)
+	{
+		g_source_remove (prefetch->timeout_id);
+		prefetch->timeout_id = 0;
+	}
+
+	if (prefetch->job_id)
+	{
+		g_source_remove (prefetch->job_id);
+		prefetch->job_id = 0;
+	}
+
+	clear_jobs (prefetch);
+	gitg_io_cancel (GITG_IO (prefetch->shell));
+}
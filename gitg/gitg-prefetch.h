@@ -0,0 +1,40 @@
+/*
+ * gitg-prefetch.h
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GITG_PREFETCH_H__
+#define __GITG_PREFETCH_H__
+
+#include <libgitg/gitg-repository.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GitgPrefetch GitgPrefetch;
+
+GitgPrefetch *gitg_prefetch_get          (GitgRepository *repository);
+
+void          gitg_prefetch_cursor_moved (GitgPrefetch   *prefetch,
+                                          gint            row);
+void          gitg_prefetch_cancel       (GitgPrefetch   *prefetch);
+
+G_END_DECLS
+
+#endif /* __GITG_PREFETCH_H__ */
@@ -4,11 +4,14 @@
 #include <gtksourceview/gtksourcelanguagemanager.h>
 #include <gtksourceview/gtksourcestyleschememanager.h>
 #include <string.h>
+#include <stdlib.h>
 #include <libgitg/gitg-repository.h>
 #include <libgitg/gitg-revision.h>
 #include <libgitg/gitg-shell.h>
 #include <libgitg/gitg-hash.h>
+#include <libgitg/gitg-commit-cache.h>
 #include "gitg-diff-view.h"
+#include "gitg-diff-spool.h"
 #include "gitg-utils.h"
 #include <glib/gi18n.h>
 
@@ -18,6 +21,17 @@
 
 #define GITG_REVISION_CHANGES_PANEL_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE((object), GITG_TYPE_REVISION_CHANGES_PANEL, GitgRevisionChangesPanelPrivate))
 
+/* Diffs larger than this are not put in the buffer completely, but are
+   spooled and only the selected files are shown */
+#define MAX_DIFF_LINES 20000
+
+/* Commits touching more files than this, or changing more lines than
+   MAX_DIFF_LINES, only load the diff of the selected files */
+#define MAX_DIFF_FILES 500
+
+/* Number of single file diffs kept around for lazily loaded commits */
+#define MAX_CACHED_DIFFS 20
+
 struct _GitgRevisionChangesPanelPrivate
 {
 	GtkWidget *panel_widget;
@@ -34,6 +48,29 @@ struct _GitgRevisionChangesPanelPrivate
 	GitgRevision *revision;
 	GSList *cached_headers;
 
+	GitgDiffSpool *spool;
+	guint diff_lines;
+	gboolean spooled;
+
+	gboolean lazy;
+	guint num_files;
+	guint num_changed_lines;
+
+	/* The diff and the file list are loaded at the same time */
+	gboolean loading_diff;
+	gboolean loading_files;
+
+	gchar *lazy_key;
+	GPtrArray *lazy_lines;
+
+	GHashTable *diff_cache;
+	GQueue *diff_cache_keys;
+
+	/* Output of the running shells, kept for the commit cache */
+	gchar *record_sha;
+	GPtrArray *record_files;
+	GPtrArray *record_diff;
+
 	gchar *selection;
 
 	GSettings *diff_settings;
@@ -60,9 +97,13 @@ typedef struct
 	gchar index_to[GITG_HASH_SHA_SIZE + 1];
 	DiffFileStatus status;
 	gchar *filename;
+	gchar *rename_to;
 
 	gboolean visible;
 	GitgDiffIter iter;
+
+	/* Index of the file in the spool, for spooled diffs */
+	gint spool_file;
 } DiffFile;
 
 static void gitg_revision_panel_iface_init (GitgRevisionPanelInterface *iface);
@@ -70,6 +111,12 @@ static void gitg_activatable_iface_init (GitgActivatableInterface *iface);
 
 static void on_header_added (GitgDiffView *view, GitgDiffIter *iter, GitgRevisionChangesPanel *self);
 static void on_diff_files_selection_changed (GtkTreeSelection *selection, GitgRevisionChangesPanel *self);
+static void free_lazy_diff (GitgRevisionChangesPanel *changes_panel);
+
+static void on_diff_update (GitgShell *shell, gchar **buffer, GitgRevisionChangesPanel *self);
+static void on_diff_files_update (GitgShell *shell, gchar **buffer, GitgRevisionChangesPanel *self);
+static void diff_loaded (GitgRevisionChangesPanel *self);
+static void diff_files_loaded (GitgRevisionChangesPanel *self);
 
 static GType diff_file_get_type (void) G_GNUC_CONST;
 
@@ -90,7 +137,8 @@ static DiffFile *
 diff_file_new (gchar const *from,
                gchar       *to,
                gchar const *status,
-               gchar const *filename)
+               gchar const *filename,
+               gchar const *rename_to)
 {
 	DiffFile *f = g_slice_new (DiffFile);
 
@@ -100,6 +148,7 @@ diff_file_new (gchar const *from,
 	f->index_from[GITG_HASH_SHA_SIZE] = '\0';
 	f->index_to[GITG_HASH_SHA_SIZE] = '\0';
 	f->visible = FALSE;
+	f->spool_file = -1;
 
 	DiffFileStatus st;
 
@@ -118,6 +167,7 @@ diff_file_new (gchar const *from,
 
 	f->status = st;
 	f->filename = g_strdup (filename);
+	f->rename_to = g_strdup (rename_to);
 	f->refcount = 1;
 
 	return f;
@@ -139,6 +189,7 @@ diff_file_unref (DiffFile *f)
 	}
 
 	g_free (f->filename);
+	g_free (f->rename_to);
 	g_slice_free (DiffFile, f);
 }
 
@@ -495,10 +546,79 @@ free_cached_headers (GitgRevisionChangesPanel *changes_panel)
 }
 
 
+static void
+free_record (GPtrArray **record)
+{
+	if (*record)
+	{
+		g_ptr_array_foreach (*record, (GFunc)g_free, NULL);
+		g_ptr_array_free (*record, TRUE);
+		*record = NULL;
+	}
+}
+
+static void
+free_records (GitgRevisionChangesPanel *changes_panel)
+{
+	free_record (&changes_panel->priv->record_files);
+	free_record (&changes_panel->priv->record_diff);
+
+	g_free (changes_panel->priv->record_sha);
+	changes_panel->priv->record_sha = NULL;
+}
+
+static void
+record_lines (GPtrArray **record,
+              gchar     **lines)
+{
+	if (!*record)
+	{
+		return;
+	}
+
+	for (; *lines; ++lines)
+	{
+		g_ptr_array_add (*record, g_strdup (*lines));
+	}
+
+	if ((*record)->len > GITG_COMMIT_CACHE_MAX_LINES)
+	{
+		free_record (record);
+	}
+}
+
+static void
+store_record (GitgRevisionChangesPanel  *changes_panel,
+              GitgShell                 *shell,
+              GitgCommitCacheKind        kind,
+              GPtrArray                **record)
+{
+	if (*record && gitg_io_get_exit_status (GITG_IO (shell)) == 0)
+	{
+		gitg_commit_cache_store (gitg_repository_get_commit_cache (changes_panel->priv->repository),
+		                         kind,
+		                         changes_panel->priv->record_sha,
+		                         NULL,
+		                         *record);
+
+		*record = NULL;
+	}
+
+	free_record (record);
+}
+
 static void
 gitg_revision_changes_panel_finalize (GObject *object)
 {
-	free_cached_headers (GITG_REVISION_CHANGES_PANEL (object));
+	GitgRevisionChangesPanel *changes_panel = GITG_REVISION_CHANGES_PANEL (object);
+
+	free_cached_headers (changes_panel);
+	free_lazy_diff (changes_panel);
+	free_records (changes_panel);
+	gitg_diff_spool_free (changes_panel->priv->spool);
+
+	g_hash_table_destroy (changes_panel->priv->diff_cache);
+	g_queue_free (changes_panel->priv->diff_cache_keys);
 
 	G_OBJECT_CLASS (gitg_revision_changes_panel_parent_class)->finalize (object);
 }
@@ -556,6 +676,164 @@ gitg_revision_changes_panel_class_init (GitgRevisionChangesPanelClass *klass)
 	g_type_class_add_private (object_class, sizeof(GitgRevisionChangesPanelPrivate));
 }
 
+static void
+run_diff (GitgRevisionChangesPanel *changes_panel,
+          GList                    *files)
+{
+	GitgCommand *command;
+	gchar sign = gitg_revision_get_sign (changes_panel->priv->revision);
+	gboolean allow_external;
+	gchar *hash = NULL;
+
+	allow_external = g_settings_get_boolean (changes_panel->priv->diff_settings,
+	                                         "external");
+
+	switch (sign)
+	{
+		case 't':
+		case 'u':
+			command = gitg_command_new (changes_panel->priv->repository,
+			                            "diff",
+			                            allow_external ? "--ext-diff" : "--no-ext-diff",
+			                            "-M",
+			                            "--pretty=format:",
+			                            "--encoding=UTF-8",
+			                            "--no-color",
+			                            sign == 't' ? "--cached" : NULL,
+			                            NULL);
+		break;
+		default:
+			hash = gitg_revision_get_sha1 (changes_panel->priv->revision);
+
+			if (!files && changes_panel->priv->record_sha)
+			{
+				gchar **lines;
+
+				lines = gitg_commit_cache_lookup (gitg_repository_get_commit_cache (changes_panel->priv->repository),
+				                                  GITG_COMMIT_CACHE_DIFF,
+				                                  hash,
+				                                  NULL);
+
+				if (lines)
+				{
+					/* Warmed by the prefetcher or an earlier visit */
+					on_diff_update (NULL, lines, changes_panel);
+					diff_loaded (changes_panel);
+
+					g_free (hash);
+					return;
+				}
+
+				changes_panel->priv->record_diff = g_ptr_array_new ();
+			}
+
+			command = gitg_commit_cache_command_new (changes_panel->priv->repository,
+			                                         GITG_COMMIT_CACHE_DIFF,
+			                                         hash,
+			                                         NULL);
+		break;
+	}
+
+	if (files)
+	{
+		gitg_command_add_arguments (command, "--", NULL);
+	}
+
+	for (; files; files = g_list_next (files))
+	{
+		DiffFile *f = files->data;
+
+		gitg_command_add_arguments (command,
+		                            f->filename,
+		                            f->rename_to,
+		                            NULL);
+	}
+
+	gitg_shell_run (changes_panel->priv->diff_shell, command, NULL);
+	g_free (hash);
+}
+
+static void
+run_diff_files (GitgRevisionChangesPanel *changes_panel)
+{
+	gchar sign = gitg_revision_get_sign (changes_panel->priv->revision);
+	gboolean allow_external;
+
+	allow_external = g_settings_get_boolean (changes_panel->priv->diff_settings,
+	                                         "external");
+
+	if (sign == 't' || sign == 'u')
+	{
+		gchar *head = gitg_repository_parse_head (changes_panel->priv->repository);
+		const gchar *cached = NULL;
+
+		if (sign == 't')
+			cached = "--cached";
+
+		gitg_shell_run (changes_panel->priv->diff_files_shell,
+		                gitg_command_new (changes_panel->priv->repository,
+		                                   "diff-index",
+		                                   allow_external ? "--ext-diff" : "--no-ext-diff",
+		                                   "--raw",
+		                                   "--numstat",
+		                                   "-M",
+		                                   "--abbrev=40",
+		                                   head,
+		                                   cached,
+		                                   NULL),
+		                NULL);
+		g_free (head);
+	}
+	else
+	{
+		gchar *sha = gitg_revision_get_sha1 (changes_panel->priv->revision);
+
+		if (changes_panel->priv->record_sha)
+		{
+			gchar **lines;
+
+			lines = gitg_commit_cache_lookup (gitg_repository_get_commit_cache (changes_panel->priv->repository),
+			                                  GITG_COMMIT_CACHE_DIFF_FILES,
+			                                  sha,
+			                                  NULL);
+
+			if (lines)
+			{
+				/* Warmed by the prefetcher or an earlier visit */
+				on_diff_files_update (NULL, lines, changes_panel);
+				diff_files_loaded (changes_panel);
+
+				g_free (sha);
+				return;
+			}
+
+			changes_panel->priv->record_files = g_ptr_array_new ();
+		}
+
+		gitg_shell_run (changes_panel->priv->diff_files_shell,
+		                gitg_commit_cache_command_new (changes_panel->priv->repository,
+		                                               GITG_COMMIT_CACHE_DIFF_FILES,
+		                                               sha,
+		                                               NULL),
+		                NULL);
+		g_free (sha);
+	}
+}
+
+static void
+free_lazy_diff (GitgRevisionChangesPanel *changes_panel)
+{
+	g_free (changes_panel->priv->lazy_key);
+	changes_panel->priv->lazy_key = NULL;
+
+	if (changes_panel->priv->lazy_lines)
+	{
+		g_ptr_array_foreach (changes_panel->priv->lazy_lines, (GFunc)g_free, NULL);
+		g_ptr_array_free (changes_panel->priv->lazy_lines, TRUE);
+		changes_panel->priv->lazy_lines = NULL;
+	}
+}
+
 static void
 reload_diff (GitgRevisionChangesPanel *changes_panel)
 {
@@ -566,6 +844,19 @@ reload_diff (GitgRevisionChangesPanel *changes_panel)
 	gitg_io_cancel (GITG_IO (changes_panel->priv->diff_files_shell));
 
 	free_cached_headers (changes_panel);
+	free_lazy_diff (changes_panel);
+	free_records (changes_panel);
+
+	gitg_diff_spool_free (changes_panel->priv->spool);
+	changes_panel->priv->spool = NULL;
+	changes_panel->priv->spooled = FALSE;
+	changes_panel->priv->diff_lines = 0;
+
+	changes_panel->priv->lazy = FALSE;
+	changes_panel->priv->num_files = 0;
+	changes_panel->priv->num_changed_lines = 0;
+	changes_panel->priv->loading_diff = FALSE;
+	changes_panel->priv->loading_files = FALSE;
 
 	// Clear the buffer
 	GtkTextBuffer *buffer;
@@ -589,58 +880,21 @@ reload_diff (GitgRevisionChangesPanel *changes_panel)
 		return;
 	}
 
-	gchar sign = gitg_revision_get_sign (changes_panel->priv->revision);
-	gboolean allow_external;
-
-	allow_external = g_settings_get_boolean (changes_panel->priv->diff_settings,
-	                                         "external");
-
-	switch (sign)
+	if (gitg_commit_cache_can_cache (changes_panel->priv->revision))
 	{
-		case 't':
-			gitg_shell_run (changes_panel->priv->diff_shell,
-			                gitg_command_new (changes_panel->priv->repository,
-			                                   "diff",
-			                                   allow_external ? "--ext-diff" : "--no-ext-diff",
-			                                   "--cached",
-			                                   "-M",
-			                                   "--pretty=format:",
-			                                   "--encoding=UTF-8",
-			                                   "--no-color",
-			                                   NULL),
-			                NULL);
-		break;
-		case 'u':
-			gitg_shell_run (changes_panel->priv->diff_shell,
-			                gitg_command_new (changes_panel->priv->repository,
-			                                   "diff",
-			                                   allow_external ? "--ext-diff" : "--no-ext-diff",
-			                                   "-M",
-			                                   "--pretty=format:",
-			                                   "--encoding=UTF-8",
-			                                   "--no-color",
-			                                   NULL),
-			                NULL);
-		break;
-		default:
-		{
-			gchar *hash = gitg_revision_get_sha1 (changes_panel->priv->revision);
-
-			gitg_shell_run (changes_panel->priv->diff_shell,
-			                gitg_command_new (changes_panel->priv->repository,
-			                                   "show",
-			                                   "-M",
-			                                   "--pretty=format:",
-			                                   "--encoding=UTF-8",
-			                                   "--no-color",
-			                                   hash,
-			                                   NULL),
-			                NULL);
-
-			g_free (hash);
-		}
-		break;
+		changes_panel->priv->record_sha =
+			gitg_revision_get_sha1 (changes_panel->priv->revision);
 	}
+
+	/* The whole diff is loaded along with the file list, and dropped
+	   again when the numstat in the file list shows that it is too big */
+	changes_panel->priv->loading_diff = TRUE;
+	changes_panel->priv->loading_files = TRUE;
+
+	changes_panel->priv->spool = gitg_diff_spool_new ();
+	run_diff (changes_panel, NULL);
+
+	run_diff_files (changes_panel);
 }
 
 static void
@@ -708,13 +962,8 @@ on_diff_files_begin_loading (GitgShell                *shell,
 }
 
 static void
-on_diff_files_end_loading (GitgShell                *shell,
-                           gboolean                  cancelled,
-                           GitgRevisionChangesPanel *self)
+apply_selection (GitgRevisionChangesPanel *self)
 {
-	gdk_window_set_cursor (gtk_widget_get_window (GTK_WIDGET(self->priv->diff_files)),
-	                       NULL);
-
 	if (self->priv->selection)
 	{
 		select_diff_file (self, self->priv->selection);
@@ -734,6 +983,136 @@ match_indices (DiffFile    *f,
 	        g_str_has_prefix (f->index_to, "0000000"));
 }
 
+static gint
+find_spool_file (GitgRevisionChangesPanel *view,
+                 DiffFile                 *f)
+{
+	guint num = gitg_diff_spool_get_n_files (view->priv->spool);
+	guint i;
+
+	for (i = 0; i < num; ++i)
+	{
+		gchar const *from;
+		gchar const *to;
+
+		if (gitg_diff_spool_get_file_index (view->priv->spool, i, &from, &to) &&
+		    match_indices (f, from, to))
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static gboolean
+foreach_show_file (GtkTreeModel             *model,
+                   GtkTreePath              *path,
+                   GtkTreeIter              *iter,
+                   GitgRevisionChangesPanel *self)
+{
+	DiffFile *f = NULL;
+	gtk_tree_model_get (model, iter, 0, &f, -1);
+
+	f->visible = TRUE;
+
+	if (self->priv->spooled)
+	{
+		f->spool_file = find_spool_file (self, f);
+	}
+
+	diff_file_unref (f);
+	return FALSE;
+}
+
+static void
+show_all_files (GitgRevisionChangesPanel *self)
+{
+	GtkTreeModel *filter;
+
+	/* Lazy and spooled diffs list all files, they are put in the buffer
+	   only when selected */
+	gtk_tree_model_foreach (GTK_TREE_MODEL (self->priv->list_store_diff_files),
+	                        (GtkTreeModelForeachFunc)foreach_show_file,
+	                        self);
+
+	filter = gtk_tree_view_get_model (self->priv->diff_files);
+	gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (filter));
+}
+
+static void
+on_diff_files_end_loading (GitgShell                *shell,
+                           gboolean                  cancelled,
+                           GitgRevisionChangesPanel *self)
+{
+	gdk_window_set_cursor (gtk_widget_get_window (GTK_WIDGET(self->priv->diff_files)),
+	                       NULL);
+
+	if (gitg_io_get_cancelled (GITG_IO (shell)))
+	{
+		free_record (&self->priv->record_files);
+		return;
+	}
+
+	store_record (self,
+	              shell,
+	              GITG_COMMIT_CACHE_DIFF_FILES,
+	              &self->priv->record_files);
+
+	diff_files_loaded (self);
+}
+
+static void
+show_loaded_diff (GitgRevisionChangesPanel *self)
+{
+	if (self->priv->spooled)
+	{
+		show_all_files (self);
+	}
+
+	apply_selection (self);
+}
+
+static void
+diff_files_loaded (GitgRevisionChangesPanel *self)
+{
+	self->priv->loading_files = FALSE;
+
+	if (self->priv->lazy)
+	{
+		show_all_files (self);
+		apply_selection (self);
+	}
+	else if (!self->priv->loading_diff)
+	{
+		show_loaded_diff (self);
+	}
+}
+
+/* Too much to show at once, only the diff of the files which get
+   selected is loaded */
+static void
+drop_whole_diff (GitgRevisionChangesPanel *self)
+{
+	GtkTextBuffer *buffer;
+
+	self->priv->lazy = TRUE;
+	self->priv->loading_diff = FALSE;
+
+	gitg_io_cancel (GITG_IO (self->priv->diff_shell));
+
+	free_cached_headers (self);
+	free_record (&self->priv->record_diff);
+
+	gitg_diff_spool_free (self->priv->spool);
+	self->priv->spool = NULL;
+	self->priv->spooled = FALSE;
+	self->priv->diff_lines = 0;
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->priv->diff));
+	gtk_text_buffer_set_text (buffer, "", 0);
+}
+
 static void
 visible_from_cached_headers (GitgRevisionChangesPanel *view,
                              DiffFile                 *f)
@@ -768,6 +1147,24 @@ add_diff_file (GitgRevisionChangesPanel *view,
 	/* see if it is in the cached headers */
 	visible_from_cached_headers (view, f);
 	gtk_list_store_set (view->priv->list_store_diff_files, &iter, 0, f, -1);
+
+	++view->priv->num_files;
+}
+
+static void
+add_numstat (GitgRevisionChangesPanel *view,
+             gchar const              *line)
+{
+	gchar **parts = g_strsplit (line, "\t", 3);
+
+	/* Binary files have - for both counts */
+	if (g_strv_length (parts) == 3)
+	{
+		view->priv->num_changed_lines += strtoul (parts[0], NULL, 10) +
+		                                 strtoul (parts[1], NULL, 10);
+	}
+
+	g_strfreev (parts);
 }
 
 static void
@@ -777,6 +1174,8 @@ on_diff_files_update (GitgShell                 *shell,
 {
 	gchar **line;
 
+	record_lines (&self->priv->record_files, buffer);
+
 	while (*(line = buffer++))
 	{
 		if (**line == '\0')
@@ -784,6 +1183,19 @@ on_diff_files_update (GitgShell                 *shell,
 			continue;
 		}
 
+		if (**line != ':')
+		{
+			add_numstat (self, *line);
+
+			if (!self->priv->lazy &&
+			    self->priv->num_changed_lines > MAX_DIFF_LINES)
+			{
+				drop_whole_diff (self);
+			}
+
+			continue;
+		}
+
 		// Count parents
 		gint parents = 0;
 		gchar *ptr = *line;
@@ -800,11 +1212,21 @@ on_diff_files_update (GitgShell                 *shell,
 		{
 			gchar **files = g_strsplit (parts[numparts - 1], "\t", -1);
 
-			DiffFile *f = diff_file_new (parts[parents + 1], parts[numparts - 2], files[0], files[1]);
+			DiffFile *f = diff_file_new (parts[parents + 1],
+			                             parts[numparts - 2],
+			                             files[0],
+			                             files[1],
+			                             files[1] ? files[2] : NULL);
 
 			add_diff_file (self, f);
 			diff_file_unref (f);
 
+			if (!self->priv->lazy &&
+			    self->priv->num_files > MAX_DIFF_FILES)
+			{
+				drop_whole_diff (self);
+			}
+
 			g_strfreev (files);
 		}
 
@@ -822,6 +1244,38 @@ on_diff_begin_loading (GitgShell                *shell,
 	gdk_cursor_unref (cursor);
 }
 
+static void
+cache_lazy_diff (GitgRevisionChangesPanel *self)
+{
+	GitgRevisionChangesPanelPrivate *priv = self->priv;
+	gchar **lines;
+
+	if (g_hash_table_lookup (priv->diff_cache, priv->lazy_key))
+	{
+		GList *item = g_queue_find_custom (priv->diff_cache_keys,
+		                                   priv->lazy_key,
+		                                   (GCompareFunc)g_strcmp0);
+
+		g_queue_delete_link (priv->diff_cache_keys, item);
+		g_hash_table_remove (priv->diff_cache, priv->lazy_key);
+	}
+
+	g_ptr_array_add (priv->lazy_lines, NULL);
+	lines = (gchar **)g_ptr_array_free (priv->lazy_lines, FALSE);
+
+	g_hash_table_insert (priv->diff_cache, priv->lazy_key, lines);
+	g_queue_push_head (priv->diff_cache_keys, priv->lazy_key);
+
+	priv->lazy_lines = NULL;
+	priv->lazy_key = NULL;
+
+	while (g_queue_get_length (priv->diff_cache_keys) > MAX_CACHED_DIFFS)
+	{
+		g_hash_table_remove (priv->diff_cache,
+		                     g_queue_pop_tail (priv->diff_cache_keys));
+	}
+}
+
 static void
 on_diff_end_loading (GitgShell                *shell,
                      gboolean                  cancelled,
@@ -830,53 +1284,53 @@ on_diff_end_loading (GitgShell                *shell,
 	gdk_window_set_cursor (gtk_widget_get_window (GTK_WIDGET(self->priv->diff)),
 	                       NULL);
 
-	if (cancelled)
+	if (gitg_io_get_cancelled (GITG_IO (shell)))
 	{
+		free_lazy_diff (self);
+		free_record (&self->priv->record_diff);
 		return;
 	}
 
-	gchar sign = gitg_revision_get_sign (self->priv->revision);
-	gboolean allow_external;
+	store_record (self,
+	              shell,
+	              GITG_COMMIT_CACHE_DIFF,
+	              &self->priv->record_diff);
 
-	allow_external = g_settings_get_boolean (self->priv->diff_settings,
-	                                         "external");
+	diff_loaded (self);
+}
 
-	if (sign == 't' || sign == 'u')
+static void
+diff_loaded (GitgRevisionChangesPanel *self)
+{
+	if (self->priv->lazy)
 	{
-		gchar *head = gitg_repository_parse_head (self->priv->repository);
-		const gchar *cached = NULL;
+		if (self->priv->lazy_key && self->priv->lazy_lines)
+		{
+			cache_lazy_diff (self);
+		}
 
-		if (sign == 't')
-			cached = "--cached";
+		free_lazy_diff (self);
+		return;
+	}
 
-		gitg_shell_run (self->priv->diff_files_shell,
-		                gitg_command_new (self->priv->repository,
-		                                   "diff-index",
-		                                   allow_external ? "--ext-diff" : "--no-ext-diff",
-		                                   "--raw",
-		                                   "-M",
-		                                   "--abbrev=40",
-		                                   head,
-		                                   cached,
-		                                   NULL),
-		                NULL);
-		g_free (head);
+	if (!self->priv->spooled)
+	{
+		/* Everything fit in the buffer, the spool is not needed */
+		gitg_diff_spool_free (self->priv->spool);
+		self->priv->spool = NULL;
 	}
-	else
+	else if (!gitg_diff_spool_finish (self->priv->spool))
 	{
-		gchar *sha = gitg_revision_get_sha1 (self->priv->revision);
-		gitg_shell_run (self->priv->diff_files_shell,
-		                gitg_command_new (self->priv->repository,
-		                                   "show",
-		                                   "--encoding=UTF-8",
-		                                   "--raw",
-		                                   "-M",
-		                                   "--pretty=format:",
-		                                   "--abbrev=40",
-		                                   sha,
-		                                   NULL),
-		                NULL);
-		g_free (sha);
+		/* Without the spool, there is nothing to show files from */
+		self->priv->spooled = FALSE;
+	}
+
+	self->priv->loading_diff = FALSE;
+
+	/* Spooled files are found by the indices in the file list */
+	if (!self->priv->loading_files)
+	{
+		show_loaded_diff (self);
 	}
 }
 
@@ -885,16 +1339,48 @@ on_diff_update (GitgShell                 *shell,
                 gchar                    **buffer,
                 GitgRevisionChangesPanel  *self)
 {
-	gchar *line;
-	GtkTextBuffer *buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW(self->priv->diff));
-	GtkTextIter iter;
+	if (self->priv->lazy)
+	{
+		gchar **ptr;
 
-	gtk_text_buffer_get_end_iter (buf, &iter);
+		gitg_diff_view_append_lines (GITG_DIFF_VIEW (self->priv->diff),
+		                             (gchar const * const *)buffer,
+		                             TRUE);
 
-	while ((line = *buffer++))
+		for (ptr = buffer; self->priv->lazy_lines && *ptr; ++ptr)
+		{
+			g_ptr_array_add (self->priv->lazy_lines,
+			                 g_strconcat (*ptr, "\n", NULL));
+		}
+
+		if (self->priv->lazy_lines &&
+		    self->priv->lazy_lines->len > MAX_DIFF_LINES)
+		{
+			/* Too big to keep around */
+			free_lazy_diff (self);
+		}
+
+		return;
+	}
+
+	record_lines (&self->priv->record_diff, buffer);
+	gitg_diff_spool_append (self->priv->spool, (gchar const * const *)buffer);
+
+	if (self->priv->spooled)
+	{
+		return;
+	}
+
+	gitg_diff_view_append_lines (GITG_DIFF_VIEW (self->priv->diff),
+	                             (gchar const * const *)buffer,
+	                             TRUE);
+
+	self->priv->diff_lines += g_strv_length (buffer);
+
+	if (self->priv->diff_lines > MAX_DIFF_LINES)
 	{
-		gtk_text_buffer_insert (buf, &iter, line, -1);
-		gtk_text_buffer_insert (buf, &iter, "\n", -1);
+		/* Stop filling the buffer, the rest is only kept in the spool */
+		self->priv->spooled = TRUE;
 	}
 }
 
@@ -904,6 +1390,12 @@ gitg_revision_changes_panel_init (GitgRevisionChangesPanel *self)
 	self->priv = GITG_REVISION_CHANGES_PANEL_GET_PRIVATE (self);
 
 	self->priv->diff_settings = g_settings_new ("org.gnome.gitg.preferences.diff");
+
+	self->priv->diff_cache = g_hash_table_new_full (g_str_hash,
+	                                                g_str_equal,
+	                                                g_free,
+	                                                (GDestroyNotify)g_strfreev);
+	self->priv->diff_cache_keys = g_queue_new ();
 	self->priv->diff_shell = gitg_shell_new (2000);
 
 	g_signal_connect (self->priv->diff_shell,
@@ -983,6 +1475,12 @@ on_header_added (GitgDiffView             *view,
 	GtkTreeIter it;
 	DiffFile *f;
 
+	if (self->priv->spooled || self->priv->lazy)
+	{
+		/* Headers come and go when the buffer is refilled */
+		return;
+	}
+
 	if (find_diff_file (self, iter, &it, &f))
 	{
 		if (!f->visible)
@@ -1037,10 +1535,200 @@ foreach_selection_changed (GtkTreeModel         *model,
 	return FALSE;
 }
 
+typedef struct
+{
+	GitgRevisionChangesPanel *panel;
+	gint numselected;
+	GtkTreeSelection *selection;
+	guint remaining;
+} ForeachSpooledData;
+
+static gboolean
+foreach_spooled_selected (GtkTreeModel       *model,
+                          GtkTreePath        *path,
+                          GtkTreeIter        *iter,
+                          ForeachSpooledData *data)
+{
+	DiffFile *f = NULL;
+	gchar **lines = NULL;
+
+	if (data->numselected != 0 &&
+	    !gtk_tree_selection_path_is_selected (data->selection, path))
+	{
+		return FALSE;
+	}
+
+	gtk_tree_model_get (model, iter, 0, &f, -1);
+
+	if (f->spool_file >= 0)
+	{
+		lines = gitg_diff_spool_get_file_lines (data->panel->priv->spool,
+		                                        f->spool_file,
+		                                        data->remaining);
+	}
+
+	if (lines)
+	{
+		gitg_diff_view_append_lines (GITG_DIFF_VIEW (data->panel->priv->diff),
+		                             (gchar const * const *)lines,
+		                             FALSE);
+
+		data->remaining -= g_strv_length (lines);
+		g_strfreev (lines);
+	}
+
+	diff_file_unref (f);
+	return data->remaining == 0;
+}
+
+static void
+show_spooled_selection (GitgRevisionChangesPanel *self,
+                        GtkTreeSelection         *selection)
+{
+	GtkTextBuffer *buffer;
+	ForeachSpooledData data = {
+		self,
+		gtk_tree_selection_count_selected_rows (selection),
+		selection,
+		MAX_DIFF_LINES
+	};
+
+	/* Only the selected files are read from the spool, the others are not
+	   loaded at all */
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->priv->diff));
+	gtk_text_buffer_set_text (buffer, "", 0);
+
+	gtk_tree_model_foreach (gtk_tree_view_get_model (self->priv->diff_files),
+	                        (GtkTreeModelForeachFunc)foreach_spooled_selected,
+	                        &data);
+}
+
+static gchar *
+lazy_diff_key (GitgRevisionChangesPanel *self,
+               DiffFile                 *f)
+{
+	gchar sign = gitg_revision_get_sign (self->priv->revision);
+
+	/* Staged and unstaged changes are not fixed, so they are not cached */
+	if (sign == 't' || sign == 'u')
+	{
+		return NULL;
+	}
+
+	gchar *sha = gitg_revision_get_sha1 (self->priv->revision);
+	gchar *ret = g_strconcat (sha, ":", f->filename, NULL);
+
+	g_free (sha);
+	return ret;
+}
+
+static gboolean
+show_cached_diff (GitgRevisionChangesPanel *self,
+                  gchar const              *key)
+{
+	GList *item;
+	gchar **lines;
+
+	lines = g_hash_table_lookup (self->priv->diff_cache, key);
+
+	if (!lines)
+	{
+		return FALSE;
+	}
+
+	/* Move to the front of the cache */
+	item = g_queue_find_custom (self->priv->diff_cache_keys,
+	                            key,
+	                            (GCompareFunc)g_strcmp0);
+
+	g_queue_unlink (self->priv->diff_cache_keys, item);
+	g_queue_push_head_link (self->priv->diff_cache_keys, item);
+
+	gitg_diff_view_append_lines (GITG_DIFF_VIEW (self->priv->diff),
+	                             (gchar const * const *)lines,
+	                             FALSE);
+
+	return TRUE;
+}
+
+static void
+show_lazy_selection (GitgRevisionChangesPanel *self,
+                     GtkTreeSelection         *selection)
+{
+	GtkTextBuffer *buffer;
+	GtkTreeModel *model;
+	GList *rows;
+	GList *item;
+	GList *files = NULL;
+
+	gitg_io_cancel (GITG_IO (self->priv->diff_shell));
+	free_lazy_diff (self);
+
+	buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->priv->diff));
+	gtk_text_buffer_set_text (buffer, "", 0);
+
+	rows = gtk_tree_selection_get_selected_rows (selection, &model);
+
+	for (item = rows; item; item = g_list_next (item))
+	{
+		GtkTreeIter iter;
+		DiffFile *f;
+
+		if (gtk_tree_model_get_iter (model, &iter, item->data))
+		{
+			gtk_tree_model_get (model, &iter, 0, &f, -1);
+			files = g_list_prepend (files, f);
+		}
+
+		gtk_tree_path_free (item->data);
+	}
+
+	g_list_free (rows);
+	files = g_list_reverse (files);
+
+	if (files && !files->next)
+	{
+		/* Single files are cached, so going back and forth between
+		   files does not run git every time */
+		gchar *key = lazy_diff_key (self, files->data);
+
+		if (key && show_cached_diff (self, key))
+		{
+			g_free (key);
+		}
+		else
+		{
+			self->priv->lazy_key = key;
+			self->priv->lazy_lines = key ? g_ptr_array_new () : NULL;
+
+			run_diff (self, files);
+		}
+	}
+	else if (files)
+	{
+		run_diff (self, files);
+	}
+
+	g_list_foreach (files, (GFunc)diff_file_unref, NULL);
+	g_list_free (files);
+}
+
 static void
 on_diff_files_selection_changed (GtkTreeSelection         *selection,
                                  GitgRevisionChangesPanel *self)
 {
+	if (self->priv->lazy)
+	{
+		show_lazy_selection (self, selection);
+		return;
+	}
+
+	if (self->priv->spooled)
+	{
+		show_spooled_selection (self, selection);
+		return;
+	}
+
 	ForeachSelectionData data = {
 		gtk_tree_selection_count_selected_rows (selection),
 		selection
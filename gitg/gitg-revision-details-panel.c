@@ -25,6 +25,7 @@
 #include "gitg-utils.h"
 #include "gitg-revision-panel.h"
 #include "gitg-stat-view.h"
+#include <libgitg/gitg-commit-cache.h>
 
 #include <glib/gi18n.h>
 #include <stdlib.h>
@@ -57,6 +58,10 @@ struct _GitgRevisionDetailsPanelPrivate
 	GitgShell *shell;
 	gboolean in_stat;
 
+	/* Output of the running shell, kept for the commit cache */
+	GPtrArray *record;
+	gchar *record_sha;
+
 	GSList *stats;
 	GitgWindow *window;
 };
@@ -183,6 +188,20 @@ gitg_revision_panel_iface_init (GitgRevisionPanelInterface *iface)
 	iface->get_panel = gitg_revision_panel_get_panel_impl;
 }
 
+static void
+free_record (GitgRevisionDetailsPanel *panel)
+{
+	if (panel->priv->record)
+	{
+		g_ptr_array_foreach (panel->priv->record, (GFunc)g_free, NULL);
+		g_ptr_array_free (panel->priv->record, TRUE);
+		panel->priv->record = NULL;
+	}
+
+	g_free (panel->priv->record_sha);
+	panel->priv->record_sha = NULL;
+}
+
 static void
 gitg_revision_details_panel_finalize (GObject *object)
 {
@@ -210,6 +229,8 @@ gitg_revision_details_panel_dispose (GObject *object)
 		panel->priv->shell = NULL;
 	}
 
+	free_record (panel);
+
 	G_OBJECT_CLASS (gitg_revision_details_panel_parent_class)->dispose (object);
 }
 static void
@@ -362,6 +383,17 @@ make_stats_table (GitgRevisionDetailsPanel *panel)
 	                                   anchor);
 }
 
+static void
+finish_details (GitgRevisionDetailsPanel *panel)
+{
+	panel->priv->stats = g_slist_reverse (panel->priv->stats);
+
+	make_stats_table (panel);
+
+	g_slist_free (panel->priv->stats);
+	panel->priv->stats = NULL;
+}
+
 static void
 on_shell_end (GitgShell                *shell,
               gboolean                  cancelled,
@@ -370,12 +402,21 @@ on_shell_end (GitgShell                *shell,
 	gdk_window_set_cursor (gtk_widget_get_window (GTK_WIDGET (panel->priv->text_view)),
 	                       NULL);
 
-	panel->priv->stats = g_slist_reverse (panel->priv->stats);
+	if (panel->priv->record &&
+	    !gitg_io_get_cancelled (GITG_IO (shell)) &&
+	    gitg_io_get_exit_status (GITG_IO (shell)) == 0)
+	{
+		gitg_commit_cache_store (gitg_repository_get_commit_cache (panel->priv->repository),
+		                         GITG_COMMIT_CACHE_DETAILS,
+		                         panel->priv->record_sha,
+		                         NULL,
+		                         panel->priv->record);
 
-	make_stats_table (panel);
+		panel->priv->record = NULL;
+	}
 
-	g_slist_free (panel->priv->stats);
-	panel->priv->stats = NULL;
+	free_record (panel);
+	finish_details (panel);
 }
 
 static void
@@ -447,6 +488,11 @@ on_shell_update (GitgShell                 *shell,
 		gchar const *line = *lines;
 		++lines;
 
+		if (panel->priv->record)
+		{
+			g_ptr_array_add (panel->priv->record, g_strdup (line));
+		}
+
 		if (panel->priv->in_stat)
 		{
 			add_stat (panel, line);
@@ -469,6 +515,12 @@ on_shell_update (GitgShell                 *shell,
 			}
 		}
 	}
+
+	if (panel->priv->record &&
+	    panel->priv->record->len > GITG_COMMIT_CACHE_MAX_LINES)
+	{
+		free_record (panel);
+	}
 }
 
 static void
@@ -657,16 +709,44 @@ update_details (GitgRevisionDetailsPanel *panel)
 
 	sha1 = gitg_revision_get_sha1 (panel->priv->revision);
 
+	if (gitg_commit_cache_can_cache (panel->priv->revision))
+	{
+		gchar **lines;
+
+		lines = gitg_commit_cache_lookup (gitg_repository_get_commit_cache (panel->priv->repository),
+		                                  GITG_COMMIT_CACHE_DETAILS,
+		                                  sha1,
+		                                  NULL);
+
+		if (lines)
+		{
+			/* Loaded before, no need to run git again */
+			panel->priv->in_stat = FALSE;
+
+			on_shell_update (NULL, lines, panel);
+			finish_details (panel);
+
+			g_free (sha1);
+			return;
+		}
+	}
+
 	gitg_shell_run (panel->priv->shell,
-	                gitg_command_new (panel->priv->repository,
-	                                   "show",
-	                                   "--numstat",
-	                                   "--pretty=format:%s%n%n%b%n\x01",
-	                                   sha1,
-	                                   NULL),
+	                gitg_commit_cache_command_new (panel->priv->repository,
+	                                               GITG_COMMIT_CACHE_DETAILS,
+	                                               sha1,
+	                                               NULL),
 	                NULL);
 
-	g_free (sha1);
+	if (gitg_commit_cache_can_cache (panel->priv->revision))
+	{
+		panel->priv->record = g_ptr_array_new ();
+		panel->priv->record_sha = sha1;
+	}
+	else
+	{
+		g_free (sha1);
+	}
 }
 
 static void
@@ -28,6 +28,8 @@
 #include <stdlib.h>
 #include <libgitg/gitg-revision.h>
 #include <libgitg/gitg-shell.h>
+#include <libgitg/gitg-commit-cache.h>
+#include <libgitg/gitg-hash.h>
 
 #include "gitg-revision-files-panel.h"
 #include "gitg-utils.h"
@@ -38,14 +40,41 @@
 
 #define GITG_REVISION_FILES_PANEL_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE((object), GITG_TYPE_REVISION_FILES_PANEL, GitgRevisionFilesPanelPrivate))
 
+/* Blobs are shown a page at a time, and not highlighted when large */
+#define BLOB_PAGE_SIZE (256 * 1024)
+#define BLOB_HIGHLIGHT_SIZE (512 * 1024)
+
 enum
 {
 	ICON_COLUMN,
 	NAME_COLUMN,
 	CONTENT_TYPE_COLUMN,
+	ID_COLUMN,
+	SIZE_COLUMN,
 	N_COLUMNS
 };
 
+/* An entry of ls-tree -l output, pointing into the parsed line */
+typedef struct
+{
+	gchar *name;
+	gchar *id;
+	gint64 size;
+	gboolean isdir;
+} TreeEntry;
+
+/* Node of the recursively loaded tree, directories are also indexed by
+   their full path in trie_dirs */
+typedef struct _TrieNode TrieNode;
+
+struct _TrieNode
+{
+	gchar *name;
+	gchar id[GITG_HASH_SHA_SIZE + 1];
+	gint64 size;
+	GPtrArray *children;
+};
+
 typedef struct _GitgRevisionFilesView GitgRevisionFilesView;
 typedef struct _GitgRevisionFilesViewClass GitgRevisionFilesViewClass;
 typedef struct _GitgRevisionFilesViewPrivate GitgRevisionFilesViewPrivate;
@@ -65,7 +94,30 @@ struct _GitgRevisionFilesViewPrivate
 	GitgShell *loader;
 	GtkTreePath *load_path;
 
-	gboolean skipped_blank_line;
+	/* Listing being loaded, kept for the commit cache */
+	GPtrArray *record;
+	gchar *record_sha;
+	gchar *record_path;
+
+	GSettings *settings;
+
+	/* Pixbufs by content type, looked up for every node */
+	GHashTable *icons;
+
+	/* Blob shown in the contents view, read by a single cat-file which
+	   is paused after every page until the view is scrolled close to
+	   the end. blob_page is the number of the page being read. */
+	gchar *blob_id;
+	gint64 blob_size;
+	gint64 blob_page_read;
+	guint blob_page;
+	gboolean blob_paused;
+	gboolean blob_sniffed;
+
+	/* Whole tree of the revision, when loading recursively */
+	TrieNode *trie_root;
+	GHashTable *trie_dirs;
+	gboolean loading_trie;
 };
 
 struct _GitgRevisionFilesView
@@ -93,6 +145,10 @@ static void gitg_revision_panel_iface_init (GitgRevisionPanelInterface *iface);
 
 static void load_node (GitgRevisionFilesView *view, GtkTreeIter *parent);
 static gchar *node_identity (GitgRevisionFilesView *view, GtkTreeIter *iter);
+static void free_record (GitgRevisionFilesView *view);
+static void free_trie (GitgRevisionFilesView *view);
+static void load_trie (GitgRevisionFilesView *view);
+static void free_blob (GitgRevisionFilesView *view);
 
 G_DEFINE_TYPE_EXTENDED (GitgRevisionFilesPanel,
                         gitg_revision_files_panel,
@@ -130,13 +186,27 @@ gitg_revision_files_view_finalize (GObject *object)
 	gitg_io_cancel (GITG_IO (self->priv->loader));
 	g_object_unref (self->priv->loader);
 
+	free_record (self);
+	free_trie (self);
+	free_blob (self);
+
+	g_hash_table_destroy (self->priv->icons);
+
 	G_OBJECT_CLASS (gitg_revision_files_view_parent_class)->finalize (object);
 }
 
 static void
 load_tree (GitgRevisionFilesView *files_view)
 {
-	load_node (files_view, NULL);
+	if (g_settings_get_boolean (files_view->priv->settings,
+	                            "load-tree-recursively"))
+	{
+		load_trie (files_view);
+	}
+	else
+	{
+		load_node (files_view, NULL);
+	}
 }
 
 static void
@@ -152,6 +222,7 @@ set_revision (GitgRevisionFilesView *files_view,
 
 	gitg_io_cancel (GITG_IO (files_view->priv->loader));
 	gtk_tree_store_clear (files_view->priv->store);
+	free_trie (files_view);
 
 	if (files_view->priv->repository)
 	{
@@ -190,7 +261,15 @@ set_revision (GitgRevisionFilesView *files_view,
 static void
 gitg_revision_files_view_dispose (GObject *object)
 {
-	set_revision (GITG_REVISION_FILES_VIEW (object), NULL, NULL);
+	GitgRevisionFilesView *self = GITG_REVISION_FILES_VIEW (object);
+
+	set_revision (self, NULL, NULL);
+
+	if (self->priv->settings)
+	{
+		g_object_unref (self->priv->settings);
+		self->priv->settings = NULL;
+	}
 
 	G_OBJECT_CLASS (gitg_revision_files_view_parent_class)->dispose (object);
 }
@@ -259,6 +338,64 @@ show_binary_information (GitgRevisionFilesView *tree)
 	gtk_source_buffer_set_language (GTK_SOURCE_BUFFER(buffer), NULL);
 }
 
+static void
+load_blob (GitgRevisionFilesView *tree)
+{
+	gitg_shell_run (tree->priv->content_shell,
+	                gitg_command_new (tree->priv->repository,
+	                                  "cat-file",
+	                                  "blob",
+	                                  tree->priv->blob_id,
+	                                  NULL),
+	                NULL);
+}
+
+static void
+load_blob_page (GitgRevisionFilesView *tree)
+{
+	++tree->priv->blob_page;
+
+	tree->priv->blob_page_read = 0;
+	tree->priv->blob_paused = FALSE;
+
+	gitg_shell_set_paused (tree->priv->content_shell, FALSE);
+}
+
+static void
+on_contents_scrolled (GtkAdjustment         *adjustment,
+                      GitgRevisionFilesView *tree)
+{
+	gdouble value;
+	gdouble page_size;
+
+	if (!tree->priv->blob_paused)
+	{
+		return;
+	}
+
+	value = gtk_adjustment_get_value (adjustment);
+	page_size = gtk_adjustment_get_page_size (adjustment);
+
+	/* Load the next page when getting close to the end */
+	if (value + page_size * 2 >= gtk_adjustment_get_upper (adjustment))
+	{
+		load_blob_page (tree);
+	}
+}
+
+static void
+free_blob (GitgRevisionFilesView *tree)
+{
+	g_free (tree->priv->blob_id);
+	tree->priv->blob_id = NULL;
+
+	tree->priv->blob_size = 0;
+	tree->priv->blob_page_read = 0;
+	tree->priv->blob_page = 0;
+	tree->priv->blob_paused = FALSE;
+	tree->priv->blob_sniffed = FALSE;
+}
+
 static void
 on_selection_changed (GtkTreeSelection     *selection,
                       GitgRevisionFilesView *tree)
@@ -271,6 +408,7 @@ on_selection_changed (GtkTreeSelection     *selection,
 	GtkTreeIter iter;
 
 	gitg_io_cancel (GITG_IO (tree->priv->content_shell));
+	free_blob (tree);
 
 	gtk_text_buffer_set_text (buffer, "", -1);
 
@@ -297,6 +435,9 @@ on_selection_changed (GtkTreeSelection     *selection,
 
 	gchar *name;
 	gchar *content_type;
+	gchar *id;
+	gint64 size;
+
 	gtk_tree_model_get_iter (model, &iter, path);
 	gtk_tree_path_free (path);
 	gtk_tree_model_get (model,
@@ -305,36 +446,43 @@ on_selection_changed (GtkTreeSelection     *selection,
 	                    &name,
 	                    CONTENT_TYPE_COLUMN,
 	                    &content_type,
+	                    ID_COLUMN,
+	                    &id,
+	                    SIZE_COLUMN,
+	                    &size,
 	                    -1);
 
-	if (!content_type)
+	if (!content_type || !id)
 	{
+		g_free (name);
+		g_free (content_type);
+		g_free (id);
+
 		return;
 	}
 
-	if (!gitg_utils_can_display_content_type (content_type))
+	/* The size is listed by ls-tree -l, there is none for submodules */
+	if (size < 0 || !gitg_utils_can_display_content_type (content_type))
 	{
 		show_binary_information (tree);
+		g_free (id);
 	}
 	else
 	{
-		GtkSourceLanguage *language;
+		GtkSourceLanguage *language = NULL;
+
+		if (size <= BLOB_HIGHLIGHT_SIZE)
+		{
+			language = gitg_utils_get_language (name, content_type);
+		}
 
-		language = gitg_utils_get_language (name, content_type);
 		gtk_source_buffer_set_language (GTK_SOURCE_BUFFER(buffer),
 		                                language);
 
-		gchar *id = node_identity (tree, &iter);
-
-		gitg_shell_run (tree->priv->content_shell,
-		                gitg_command_new (tree->priv->repository,
-		                                   "show",
-		                                   "--encoding=UTF-8",
-		                                   id,
-		                                   NULL),
-		                NULL);
+		tree->priv->blob_id = id;
+		tree->priv->blob_size = size;
 
-		g_free (id);
+		load_blob (tree);
 	}
 
 	g_free (name);
@@ -530,6 +678,17 @@ gitg_revision_files_view_parser_finished (GtkBuildable *buildable,
 	                          GTK_TEXT_BUFFER(gtk_source_buffer_new (NULL)));
 
 	gitg_utils_set_monospace_font (GTK_WIDGET(files_view->priv->contents));
+
+	GtkScrolledWindow *scrolled;
+
+	scrolled = GTK_SCROLLED_WINDOW (gtk_builder_get_object (builder,
+	                                "scrolled_window_files_contents"));
+
+	g_signal_connect (gtk_scrolled_window_get_vadjustment (scrolled),
+	                  "value-changed",
+	                  G_CALLBACK (on_contents_scrolled),
+	                  files_view);
+
 	gtk_tree_view_set_model (files_view->priv->tree_view,
 	                         GTK_TREE_MODEL(files_view->priv->store));
 
@@ -677,20 +836,90 @@ gitg_revision_files_panel_class_init (GitgRevisionFilesPanelClass *klass)
 	g_type_class_add_private (object_class, sizeof (GitgRevisionFilesPanelPrivate));
 }
 
-static gchar *
+static gchar const *
 get_content_type (gchar    *name,
                   gboolean  dir)
 {
 	if (dir)
 	{
-		return g_strdup ("inode/directory");
+		return g_intern_static_string ("inode/directory");
 	}
 	else
 	{
-		return g_content_type_guess (name, NULL, 0, NULL);
+		return gitg_utils_get_content_type_for_name (name);
 	}
 }
 
+static void
+unref_pixbuf (GdkPixbuf *pixbuf)
+{
+	if (pixbuf)
+	{
+		g_object_unref (pixbuf);
+	}
+}
+
+static GdkPixbuf *
+content_type_icon (GitgRevisionFilesView *tree,
+                   gchar const           *content_type,
+                   gchar const           *fallback)
+{
+	GdkPixbuf *pixbuf = NULL;
+	GIcon *icon;
+
+	/* Content types are interned, so are the keys */
+	if (g_hash_table_lookup_extended (tree->priv->icons,
+	                                  content_type,
+	                                  NULL,
+	                                  (gpointer *)&pixbuf))
+	{
+		return pixbuf;
+	}
+
+	icon = g_content_type_get_icon (content_type);
+
+	if (icon && G_IS_THEMED_ICON(icon))
+	{
+		g_themed_icon_append_name (G_THEMED_ICON(icon), fallback);
+
+		GtkIconTheme *theme = gtk_icon_theme_get_default ();
+
+		gchar **names;
+		g_object_get (icon, "names", &names, NULL);
+
+		GtkIconInfo *info;
+
+		info = gtk_icon_theme_choose_icon (theme,
+		                                   (gchar const **)names,
+		                                   16,
+		                                   0);
+
+		if (info)
+		{
+			GError *error = NULL;
+			pixbuf = gtk_icon_info_load_icon (info, &error);
+
+			if (!pixbuf)
+			{
+				g_warning ("Error loading icon: %s", error->message);
+				g_error_free (error);
+			}
+
+			gtk_icon_info_free (info);
+		}
+
+		g_strfreev (names);
+	}
+
+	if (icon)
+	{
+		g_object_unref (icon);
+	}
+
+	g_hash_table_insert (tree->priv->icons, (gpointer)content_type, pixbuf);
+	return pixbuf;
+}
+
 static void
 remove_dummy (GitgRevisionFilesView *tree)
 {
@@ -729,9 +958,51 @@ remove_dummy (GitgRevisionFilesView *tree)
 	} while (gtk_tree_model_iter_next (model, &child));
 }
 
+static gboolean
+parse_tree_entry (gchar     *line,
+                  TreeEntry *entry)
+{
+	/* <mode> SP <type> SP <object> SP <size> TAB <name> */
+	gchar *tab = strchr (line, '\t');
+	gchar *type;
+	gchar *size;
+
+	if (!tab)
+	{
+		return FALSE;
+	}
+
+	*tab = '\0';
+	entry->name = tab + 1;
+
+	type = strchr (line, ' ');
+
+	if (!type || !(entry->id = strchr (++type, ' ')))
+	{
+		return FALSE;
+	}
+
+	entry->isdir = strncmp (type, "tree ", 5) == 0;
+	size = strchr (++entry->id, ' ');
+
+	if (size)
+	{
+		*size++ = '\0';
+
+		/* The size is padded, trees and submodules have - instead */
+		while (*size == ' ')
+		{
+			++size;
+		}
+	}
+
+	entry->size = size && g_ascii_isdigit (*size) ? g_ascii_strtoll (size, NULL, 10) : -1;
+	return TRUE;
+}
+
 static void
 append_node (GitgRevisionFilesView *tree,
-             gchar                *line)
+             TreeEntry            *entry)
 {
 	GtkTreeIter parent;
 	GtkTreeIter iter;
@@ -748,16 +1019,18 @@ append_node (GitgRevisionFilesView *tree,
 		gtk_tree_store_append (tree->priv->store, &iter, NULL);
 	}
 
-	int len = strlen (line);
-	gboolean isdir = FALSE;
+	gchar *line = entry->name;
+	gboolean isdir = entry->isdir;
 
-	if (line[len - 1] == '/')
-	{
-		isdir = TRUE;
-		line[len - 1] = '\0';
-	}
+	gtk_tree_store_set (tree->priv->store,
+	                    &iter,
+	                    ID_COLUMN,
+	                    entry->id,
+	                    SIZE_COLUMN,
+	                    entry->size,
+	                    -1);
 
-	GIcon *icon;
+	gchar const *content_type = get_content_type (line, isdir);
 
 	if (isdir)
 	{
@@ -768,92 +1041,158 @@ append_node (GitgRevisionFilesView *tree,
 		                    NAME_COLUMN,
 		                    _ ("(Empty)"),
 		                    -1);
+	}
 
-		gchar *content_type = get_content_type (line, TRUE);
-		gtk_tree_store_set (tree->priv->store,
-		                    &iter,
-		                    CONTENT_TYPE_COLUMN,
-		                    content_type,
-		                    -1);
-		icon = g_content_type_get_icon (content_type);
-		g_free (content_type);
+	gtk_tree_store_set (tree->priv->store,
+	                    &iter,
+	                    CONTENT_TYPE_COLUMN,
+	                    content_type,
+	                    ICON_COLUMN,
+	                    content_type_icon (tree,
+	                                       content_type,
+	                                       isdir ? "folder" : "text-x-generic"),
+	                    -1);
 
-		if (icon && G_IS_THEMED_ICON(icon))
-		{
-			g_themed_icon_append_name (G_THEMED_ICON(icon), "folder");
-		}
+	gtk_tree_store_set (tree->priv->store,
+	                    &iter,
+	                    NAME_COLUMN,
+	                    line,
+	                    -1);
+	remove_dummy (tree);
+}
+
+static TrieNode *
+trie_node_new (gchar const *name,
+               gboolean     isdir)
+{
+	TrieNode *node = g_slice_new0 (TrieNode);
+
+	node->name = g_strdup (name);
+	node->size = -1;
+
+	if (isdir)
+	{
+		node->children = g_ptr_array_new ();
 	}
-	else
+
+	return node;
+}
+
+static void
+trie_node_free (TrieNode *node)
+{
+	if (node->children)
 	{
-		gchar *content_type = get_content_type (line, FALSE);
-		icon = g_content_type_get_icon (content_type);
-		gtk_tree_store_set (tree->priv->store,
-		                    &iter,
-		                    CONTENT_TYPE_COLUMN,
-		                    content_type,
-		                    -1);
-		g_free (content_type);
+		g_ptr_array_foreach (node->children, (GFunc)trie_node_free, NULL);
+		g_ptr_array_free (node->children, TRUE);
+	}
 
-		if (icon && G_IS_THEMED_ICON(icon))
-		{
-			g_themed_icon_append_name (G_THEMED_ICON(icon),
-			                           "text-x-generic");
-		}
+	g_free (node->name);
+	g_slice_free (TrieNode, node);
+}
+
+static void
+free_trie (GitgRevisionFilesView *tree)
+{
+	if (tree->priv->trie_root)
+	{
+		trie_node_free (tree->priv->trie_root);
+		tree->priv->trie_root = NULL;
 	}
 
-	if (G_IS_THEMED_ICON(icon))
+	if (tree->priv->trie_dirs)
 	{
-		GtkIconTheme *theme = gtk_icon_theme_get_default ();
+		g_hash_table_destroy (tree->priv->trie_dirs);
+		tree->priv->trie_dirs = NULL;
+	}
 
-		gchar **names;
-		g_object_get (icon, "names", &names, NULL);
+	tree->priv->loading_trie = FALSE;
+}
 
-		GtkIconInfo *info;
+static void
+add_trie_entry (GitgRevisionFilesView *tree,
+                gchar                *line)
+{
+	TreeEntry entry;
+	TrieNode *parent;
+	TrieNode *node;
+	gchar *sep;
+	gchar *name;
 
-		info = gtk_icon_theme_choose_icon (theme,
-		                                   (gchar const **)names,
-		                                   16,
-		                                   0);
+	if (!parse_tree_entry (line, &entry))
+	{
+		return;
+	}
 
-		if (info)
-		{
-			GError *error = NULL;
-			GdkPixbuf *pixbuf = gtk_icon_info_load_icon (info, &error);
+	/* ls-tree -r -t lists directories before their contents */
+	sep = strrchr (entry.name, '/');
 
-			if (!pixbuf)
-			{
-				g_warning ("Error loading icon: %s", error->message);
-				g_error_free (error);
-			}
+	if (sep)
+	{
+		*sep = '\0';
+		parent = g_hash_table_lookup (tree->priv->trie_dirs, entry.name);
+		*sep = '/';
 
-			gtk_tree_store_set (tree->priv->store,
-			                    &iter,
-			                    ICON_COLUMN,
-			                    pixbuf,
-			                    -1);
+		name = sep + 1;
+	}
+	else
+	{
+		parent = tree->priv->trie_root;
+		name = entry.name;
+	}
 
-			if (pixbuf)
-			{
-				g_object_unref (pixbuf);
-			}
+	if (!parent)
+	{
+		return;
+	}
 
-			gtk_icon_info_free (info);
-		}
+	node = trie_node_new (name, entry.isdir);
+	node->size = entry.size;
+	g_strlcpy (node->id, entry.id, sizeof (node->id));
 
-		g_strfreev (names);
+	g_ptr_array_add (parent->children, node);
+
+	if (entry.isdir)
+	{
+		g_hash_table_insert (tree->priv->trie_dirs,
+		                     g_strdup (entry.name),
+		                     node);
 	}
+}
 
-	if (icon)
+static void
+fill_from_trie (GitgRevisionFilesView *tree,
+                gchar const          *path)
+{
+	TrieNode *dir;
+	guint i;
+
+	if (path)
 	{
-		g_object_unref (icon);
+		dir = g_hash_table_lookup (tree->priv->trie_dirs, path);
+	}
+	else
+	{
+		dir = tree->priv->trie_root;
 	}
 
-	gtk_tree_store_set (tree->priv->store,
-	                    &iter,
-	                    NAME_COLUMN,
-	                    line,
-	                    -1);
-	remove_dummy (tree);
+	if (!dir)
+	{
+		return;
+	}
+
+	for (i = 0; i < dir->children->len; ++i)
+	{
+		TrieNode *node = g_ptr_array_index (dir->children, i);
+		TreeEntry entry;
+
+		entry.name = node->name;
+		entry.id = node->id;
+		entry.size = node->size;
+		entry.isdir = node->children != NULL;
+
+		append_node (tree, &entry);
+	}
 }
 
 static void
@@ -863,20 +1202,78 @@ on_update (GitgShell              *shell,
 {
 	gchar *line;
 
+	if (tree->priv->record)
+	{
+		gchar **ptr;
+
+		for (ptr = buffer; *ptr; ++ptr)
+		{
+			g_ptr_array_add (tree->priv->record, g_strdup (*ptr));
+		}
+
+		if (tree->priv->record->len > GITG_COMMIT_CACHE_MAX_LINES)
+		{
+			free_record (tree);
+		}
+	}
+
+	if (tree->priv->loading_trie)
+	{
+		while ((line = *buffer++))
+		{
+			add_trie_entry (tree, line);
+		}
+
+		return;
+	}
+
 	while ((line = *buffer++))
 	{
-		if (!tree->priv->skipped_blank_line)
+		TreeEntry entry;
+
+		if (parse_tree_entry (line, &entry))
 		{
-			if (*line == '\0')
-			{
-				tree->priv->skipped_blank_line = TRUE;
-			}
+			append_node (tree, &entry);
+		}
+	}
+}
 
-			continue;
+static void
+on_loader_end (GitgShell             *shell,
+               GError                *error,
+               GitgRevisionFilesView *tree)
+{
+	if (tree->priv->loading_trie)
+	{
+		tree->priv->loading_trie = FALSE;
+
+		if (gitg_io_get_cancelled (GITG_IO (shell)) ||
+		    gitg_io_get_exit_status (GITG_IO (shell)) != 0)
+		{
+			free_trie (tree);
+		}
+		else
+		{
+			fill_from_trie (tree, NULL);
 		}
 
-		append_node (tree, line);
+		return;
+	}
+
+	if (tree->priv->record &&
+	    !gitg_io_get_cancelled (GITG_IO (shell)) &&
+	    gitg_io_get_exit_status (GITG_IO (shell)) == 0)
+	{
+		gitg_commit_cache_store (gitg_repository_get_commit_cache (tree->priv->repository),
+		                         GITG_COMMIT_CACHE_TREE,
+		                         tree->priv->record_sha,
+		                         tree->priv->record_path,
+		                         tree->priv->record);
+
+		tree->priv->record = NULL;
 	}
+
+	free_record (tree);
 }
 
 static gint
@@ -926,25 +1323,51 @@ on_contents_update (GitgShell              *shell,
 	gchar *line;
 	GtkTextBuffer *buf;
 	GtkTextIter iter;
+	gboolean binary = FALSE;
 
 	buf = gtk_text_view_get_buffer (GTK_TEXT_VIEW(tree->priv->contents));
 
 	gtk_text_buffer_get_end_iter (buf, &iter);
 
-	while ((line = *buffer++))
+	/* Like git, a NUL in the first page means the blob is binary */
+	if (tree->priv->blob_page == 0 && gitg_shell_get_seen_nul (shell))
+	{
+		binary = TRUE;
+	}
+
+	while (!binary && (line = *buffer++))
 	{
-		gtk_text_buffer_insert (buf, &iter, line, -1);
-		gtk_text_buffer_insert (buf, &iter, "\n", -1);
+		gchar const *end;
+		gsize len = strlen (line);
+
+		tree->priv->blob_page_read += len;
+
+		if (g_utf8_validate (line, len, &end))
+		{
+			gtk_text_buffer_insert (buf, &iter, line, len);
+		}
+		else
+		{
+			gtk_text_buffer_insert (buf, &iter, line, end - line);
+
+			if (line[len - 1] == '\n')
+			{
+				gtk_text_buffer_insert (buf, &iter, "\n", 1);
+			}
+		}
 	}
 
-	if (gtk_source_buffer_get_language (GTK_SOURCE_BUFFER(buf)) == NULL)
+	/* The name did not tell us enough, look at the first block */
+	if (!tree->priv->blob_sniffed &&
+	    !binary &&
+	    tree->priv->blob_size <= BLOB_HIGHLIGHT_SIZE &&
+	    gtk_source_buffer_get_language (GTK_SOURCE_BUFFER(buf)) == NULL)
 	{
 		gchar *content_type = gitg_utils_guess_content_type (buf);
 
 		if (content_type && !gitg_utils_can_display_content_type (content_type))
 		{
-			gitg_io_cancel (GITG_IO (shell));
-			show_binary_information (tree);
+			binary = TRUE;
 		}
 		else
 		{
@@ -957,6 +1380,22 @@ on_contents_update (GitgShell              *shell,
 
 		g_free (content_type);
 	}
+
+	tree->priv->blob_sniffed = TRUE;
+
+	if (binary)
+	{
+		gitg_io_cancel (GITG_IO (shell));
+		free_blob (tree);
+
+		show_binary_information (tree);
+	}
+	else if (tree->priv->blob_page_read >= BLOB_PAGE_SIZE)
+	{
+		/* Let cat-file wait until the page is scrolled through */
+		tree->priv->blob_paused = TRUE;
+		gitg_shell_set_paused (shell, TRUE);
+	}
 }
 
 static void
@@ -966,7 +1405,16 @@ gitg_revision_files_view_init (GitgRevisionFilesView *self)
 	self->priv->store = gtk_tree_store_new (N_COLUMNS,
 	                                        GDK_TYPE_PIXBUF,
 	                                        G_TYPE_STRING,
-	                                        G_TYPE_STRING);
+	                                        G_TYPE_STRING,
+	                                        G_TYPE_STRING,
+	                                        G_TYPE_INT64);
+
+	self->priv->settings = g_settings_new ("org.gnome.gitg.preferences.view.files");
+
+	self->priv->icons = g_hash_table_new_full (g_direct_hash,
+	                                           g_direct_equal,
+	                                           NULL,
+	                                           (GDestroyNotify)unref_pixbuf);
 
 	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (self->priv->store),
 	                                 1,
@@ -979,12 +1427,19 @@ gitg_revision_files_view_init (GitgRevisionFilesView *self)
 	                                      GTK_SORT_ASCENDING);
 
 	self->priv->loader = gitg_shell_new (1000);
+	gitg_shell_set_nul_separated (self->priv->loader, TRUE);
 	g_signal_connect (self->priv->loader,
 	                  "update",
 	                  G_CALLBACK (on_update),
 	                  self);
 
+	g_signal_connect (self->priv->loader,
+	                  "end",
+	                  G_CALLBACK (on_loader_end),
+	                  self);
+
 	self->priv->content_shell = gitg_shell_new (5000);
+	gitg_shell_set_preserve_line_endings (self->priv->content_shell, TRUE);
 	g_signal_connect (self->priv->content_shell,
 	                  "update",
 	                  G_CALLBACK (on_contents_update),
@@ -1013,6 +1468,23 @@ node_identity (GitgRevisionFilesView *tree,
 	return path;
 }
 
+static void
+free_record (GitgRevisionFilesView *tree)
+{
+	if (tree->priv->record)
+	{
+		g_ptr_array_foreach (tree->priv->record, (GFunc)g_free, NULL);
+		g_ptr_array_free (tree->priv->record, TRUE);
+		tree->priv->record = NULL;
+	}
+
+	g_free (tree->priv->record_sha);
+	tree->priv->record_sha = NULL;
+
+	g_free (tree->priv->record_path);
+	tree->priv->record_path = NULL;
+}
+
 static void
 load_node (GitgRevisionFilesView *tree,
            GtkTreeIter          *parent)
@@ -1027,7 +1499,9 @@ load_node (GitgRevisionFilesView *tree,
 		gtk_tree_path_free (tree->priv->load_path);
 	}
 
-	gchar *id = node_identity (tree, parent);
+	gchar *sha = gitg_revision_get_sha1 (tree->priv->revision);
+	gchar *path = node_path (GTK_TREE_MODEL (tree->priv->store), parent);
+	GitgCommitCache *cache = gitg_repository_get_commit_cache (tree->priv->repository);
 
 	if (parent)
 	{
@@ -1040,13 +1514,93 @@ load_node (GitgRevisionFilesView *tree,
 		tree->priv->load_path = NULL;
 	}
 
-	tree->priv->skipped_blank_line = FALSE;
+	if (tree->priv->trie_root)
+	{
+		/* Everything is known already, no need to ask git */
+		fill_from_trie (tree, path);
+
+		g_free (sha);
+		g_free (path);
+		return;
+	}
+
+	if (gitg_commit_cache_can_cache (tree->priv->revision))
+	{
+		gchar **lines = gitg_commit_cache_lookup (cache,
+		                                          GITG_COMMIT_CACHE_TREE,
+		                                          sha,
+		                                          path);
+
+		if (lines)
+		{
+			/* Parsing modifies the lines it is given */
+			gchar **copy = g_strdupv (lines);
+
+			on_update (NULL, copy, tree);
+
+			g_strfreev (copy);
+			g_free (sha);
+			g_free (path);
+			return;
+		}
+	}
+
+	gitg_shell_run (tree->priv->loader,
+	                gitg_commit_cache_command_new (tree->priv->repository,
+	                                               GITG_COMMIT_CACHE_TREE,
+	                                               sha,
+	                                               path),
+	                NULL);
+
+	if (gitg_commit_cache_can_cache (tree->priv->revision))
+	{
+		tree->priv->record = g_ptr_array_new ();
+		tree->priv->record_sha = sha;
+		tree->priv->record_path = path;
+	}
+	else
+	{
+		g_free (sha);
+		g_free (path);
+	}
+}
+
+static void
+load_trie (GitgRevisionFilesView *tree)
+{
+	gchar *sha;
+
+	gitg_io_cancel (GITG_IO (tree->priv->loader));
+	free_trie (tree);
+
+	if (tree->priv->load_path)
+	{
+		gtk_tree_path_free (tree->priv->load_path);
+		tree->priv->load_path = NULL;
+	}
+
+	tree->priv->trie_root = trie_node_new (NULL, TRUE);
+	tree->priv->trie_dirs = g_hash_table_new_full (g_str_hash,
+	                                               g_str_equal,
+	                                               g_free,
+	                                               NULL);
+
+	tree->priv->loading_trie = TRUE;
+
+	/* One pass over the whole tree, directories are expanded from the
+	   trie afterwards */
+	sha = gitg_revision_get_sha1 (tree->priv->revision);
+
 	gitg_shell_run (tree->priv->loader,
 	                gitg_command_new (tree->priv->repository,
-	                                   "show",
-	                                   "--encoding=UTF-8",
-	                                   id,
-	                                   NULL),
+	                                  "ls-tree",
+	                                  "-z",
+	                                  "-l",
+	                                  "-r",
+	                                  "-t",
+	                                  sha,
+	                                  NULL),
 	                NULL);
-	g_free (id);
+
+	g_free (sha);
 }
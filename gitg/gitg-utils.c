@@ -29,18 +29,112 @@
 
 #include "gseal-gtk-compat.h"
 
+/* Like git, data is considered binary when there is a NUL in the first
+   8000 bytes */
+#define BINARY_CHECK_SIZE 8000
+#define BINARY_CONTENT_TYPE "application/x-binary"
+
+static GHashTable *content_types = NULL;
+
+static gchar const *
+guess_content_type (gchar const *name, gboolean *uncertain)
+{
+	gchar *guess = g_content_type_guess(name, NULL, 0, uncertain);
+	gchar const *ret = g_intern_string(guess);
+
+	g_free(guess);
+	return ret;
+}
+
+gchar const *
+gitg_utils_get_content_type_for_name(gchar const *name)
+{
+	gchar const *base;
+	gchar const *ext;
+	gchar const *content_type;
+	gboolean uncertain = FALSE;
+
+	if (!content_types)
+	{
+		content_types = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	}
+
+	base = strrchr(name, '/');
+	base = base ? base + 1 : name;
+
+	/* Types are remembered per basename, since the whole name decides
+	   the type of CMakeLists.txt, foo.tar.gz, ... */
+	content_type = g_hash_table_lookup(content_types, base);
+
+	if (content_type)
+	{
+		return content_type;
+	}
+
+	content_type = guess_content_type(base, &uncertain);
+	ext = strrchr(base, '.');
+
+	/* Fall back to the type of the extension when the name itself did
+	   not match, extension keys start with a '*' like their glob */
+	if (uncertain && ext && ext != base)
+	{
+		gchar *key = g_strconcat("*", ext, NULL);
+		gchar const *by_ext = g_hash_table_lookup(content_types, key);
+
+		if (!by_ext)
+		{
+			by_ext = guess_content_type(key, NULL);
+			g_hash_table_insert(content_types, key, (gpointer)by_ext);
+		}
+		else
+		{
+			g_free(key);
+		}
+
+		content_type = by_ext;
+	}
+
+	g_hash_table_insert(content_types, g_strdup(base), (gpointer)content_type);
+	return content_type;
+}
+
+gboolean
+gitg_utils_is_binary_data(gchar const *data, gsize size)
+{
+	return memchr(data, '\0', MIN(size, BINARY_CHECK_SIZE)) != NULL;
+}
+
 gchar *
 gitg_utils_get_content_type(GFile *file)
 {
-	GFileInfo *info = g_file_query_info(file, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE, G_FILE_QUERY_INFO_NONE, NULL, NULL);
+	gchar *name = g_file_get_basename(file);
+	gchar const *content_type;
 
-	if (!info || !g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE))
+	if (!name)
 		return NULL;
 
-	gchar *content_type = g_strdup(g_file_info_get_content_type(info));
-	g_object_unref(info);
+	content_type = gitg_utils_get_content_type_for_name(name);
+	g_free(name);
 
-	return content_type;
+	if (!gitg_utils_can_display_content_type(content_type))
+		return g_strdup(content_type);
+
+	/* Only look at the contents of what would be shown as text */
+	GFileInputStream *stream = g_file_read(file, NULL, NULL);
+
+	if (!stream)
+		return NULL;
+
+	gchar buffer[BINARY_CHECK_SIZE];
+	gsize read = 0;
+
+	g_input_stream_read_all(G_INPUT_STREAM(stream), buffer, sizeof(buffer), &read, NULL, NULL);
+	g_object_unref(stream);
+
+	if (gitg_utils_is_binary_data(buffer, read))
+		content_type = BINARY_CONTENT_TYPE;
+
+	return g_strdup(content_type);
 }
 
 gboolean
@@ -346,6 +440,55 @@ gitg_utils_rewrite_hunk_counters (gchar const *header,
 	return ret;
 }
 
+/* Parses the blob ids of an "index from..to mode" line of a diff header
+   into index_from and index_to, which hold GITG_HASH_SHA_SIZE + 1 bytes */
+gboolean
+gitg_utils_parse_index_line (gchar const *line,
+                             gchar       *index_from,
+                             gchar       *index_to)
+{
+	gchar const match[] = "index ";
+
+	if (!g_str_has_prefix (line, match))
+	{
+		return FALSE;
+	}
+
+	gchar const *start = line + strlen (match);
+	gchar const *sep = strstr (start, "..");
+
+	if (!sep)
+	{
+		return FALSE;
+	}
+
+	gchar const *last = strpbrk (sep, " \r\n");
+	gchar const *bet = strstr (start, ",");
+	gsize from_len;
+	gsize to_len;
+
+	if (!last)
+	{
+		last = line + strlen (line);
+	}
+
+	if (bet && bet > sep)
+	{
+		bet = NULL;
+	}
+
+	from_len = MIN ((bet ? bet : sep) - start, GITG_HASH_SHA_SIZE);
+	to_len = MIN (last - (sep + 2), GITG_HASH_SHA_SIZE);
+
+	strncpy (index_from, start, from_len);
+	strncpy (index_to, sep + 2, to_len);
+
+	index_from[from_len] = '\0';
+	index_to[to_len] = '\0';
+
+	return TRUE;
+}
+
 GtkCellRenderer *
 gitg_utils_find_cell_at_pos (GtkTreeView *tree_view, GtkTreeViewColumn *column, GtkTreePath *path, gint x)
 {
@@ -32,6 +32,8 @@
 #include <libgitg/gitg-revision.h>
 
 gchar *gitg_utils_get_content_type(GFile *file);
+gchar const *gitg_utils_get_content_type_for_name(gchar const *name);
+gboolean gitg_utils_is_binary_data(gchar const *data, gsize size);
 gboolean gitg_utils_can_display_content_type(gchar const *content_type);
 gchar *gitg_utils_guess_content_type(GtkTextBuffer *buffer);
 
@@ -51,6 +53,7 @@ void gitg_utils_menu_position_under_widget(GtkMenu *menu, gint *x, gint *y,	gboo
 void gitg_utils_menu_position_under_tree_view(GtkMenu *menu, gint *x, gint *y, gboolean *push_in, gpointer user_data);
 
 gchar *gitg_utils_rewrite_hunk_counters (gchar const *hunk, guint old_count, guint new_count);
+gboolean gitg_utils_parse_index_line (gchar const *line, gchar *index_from, gchar *index_to);
 
 GtkCellRenderer *gitg_utils_find_cell_at_pos (GtkTreeView *tree_view, GtkTreeViewColumn *column, GtkTreePath *path, gint x);
 
@@ -43,6 +43,7 @@
 #include "gitg-revision-details-panel.h"
 #include "gitg-revision-changes-panel.h"
 #include "gitg-revision-files-panel.h"
+#include "gitg-prefetch.h"
 #include "gitg-activatable.h"
 #include "gitg-uri.h"
 
@@ -52,6 +53,9 @@
 #define DYNAMIC_ACTION_DATA_REMOTE_KEY "GitgDynamicActionDataRemoteKey"
 #define DYNAMIC_ACTION_DATA_BRANCH_KEY "GitgDynamicActionDataBranchKey"
 
+/* Number of rows measured to size the author and date columns */
+#define COLUMN_SAMPLE_ROWS 50
+
 #define GITG_WINDOW_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE((object), GITG_TYPE_WINDOW, GitgWindowPrivate))
 
 enum
@@ -62,6 +66,14 @@ enum
 	COLUMN_BRANCHES_SELECTION
 };
 
+typedef enum
+{
+	SEARCH_LOG_NONE,
+	SEARCH_LOG_MESSAGE,
+	SEARCH_LOG_PICKAXE,
+	SEARCH_LOG_REGEX
+} SearchLogMode;
+
 struct _GitgWindowPrivate
 {
 	GitgRepository *repository;
@@ -74,6 +86,7 @@ struct _GitgWindowPrivate
 	GtkStatusbar *statusbar;
 	GitgCommitView *commit_view;
 	GtkWidget *search_popup;
+	GtkWidget *search_entry;
 	GtkComboBox *combo_branches;
 
 	GtkUIManager *menus_ui_manager;
@@ -90,6 +103,11 @@ struct _GitgWindowPrivate
 
 	GitgCellRendererPath *renderer_path;
 
+	/* Columns sized from sampled rows once per repository */
+	GtkTreeViewColumn *column_author;
+	GtkTreeViewColumn *column_date;
+	gboolean columns_sized;
+
 	GTimer *load_timer;
 	GdkCursor *hand;
 
@@ -104,6 +122,25 @@ struct _GitgWindowPrivate
 	GList *branch_actions;
 	GitgHash select_on_load;
 
+	/* History is loaded in pages, keep paging until select_on_load is
+	   found when page_to_select is set */
+	gboolean loading_page;
+	gboolean page_to_select;
+
+	/* Rows matching the search entry, and the filter showing only those */
+	gchar *search_key;
+	gint search_column;
+	GArray *search_matches;
+	GtkTreeModel *search_filter;
+	guint search_filter_id;
+
+	/* Revisions found by git log for message or content searches */
+	SearchLogMode search_log_mode;
+	GitgShell *search_log;
+	GHashTable *search_highlight;
+	guint search_log_id;
+	gboolean search_log_selected;
+
 	GSList *revision_panels;
 	GSList *activatables;
 
@@ -122,11 +159,21 @@ static gboolean on_tree_view_button_release (GtkTreeView *treeview,
                                              GitgWindow *window);
 
 static void gitg_window_buildable_iface_init (GtkBuildableIface *iface);
+static void clear_search_matches (GitgWindow *window);
+static void cancel_search_log (GitgWindow *window);
+static void on_search_log_update (GitgShell *shell, gchar **lines, GitgWindow *window);
+static void on_search_log_end (GitgShell *shell, GError *error, GitgWindow *window);
+static void load_more_history (GitgWindow *window);
+static void on_history_scrolled (GtkAdjustment *adjustment, GitgWindow *window);
 
 void on_subject_activate (GtkAction *action, GitgWindow *window);
 void on_author_activate (GtkAction *action, GitgWindow *window);
 void on_date_activate (GtkAction *action, GitgWindow *window);
 void on_hash_activate (GtkAction *action, GitgWindow *window);
+void on_message_activate (GtkAction *action, GitgWindow *window);
+void on_pickaxe_activate (GtkAction *action, GitgWindow *window);
+void on_regex_activate (GtkAction *action, GitgWindow *window);
+void on_search_filter_toggled (GtkToggleAction *action, GitgWindow *window);
 void on_file_quit (GtkAction *action, GitgWindow *window);
 void on_file_open (GtkAction *action, GitgWindow *window);
 void on_edit_cut (GtkAction *action, GitgWindow *window);
@@ -159,8 +206,8 @@ static GtkBuildableIface parent_iface;
 static GtkWindowClass *parent_class = NULL;
 
 static void
-on_branch_action_shell_end (GitgShell *shell,
-                            gboolean    cancelled,
+on_branch_action_shell_end (GitgShell  *shell,
+                            GError     *error,
                             GitgWindow *window)
 {
 	window->priv->branch_actions = g_list_remove (window->priv->branch_actions, shell);
@@ -194,6 +241,9 @@ gitg_window_finalize (GObject *object)
 	g_timer_destroy (self->priv->load_timer);
 	gdk_cursor_unref (self->priv->hand);
 
+	g_free (self->priv->search_key);
+	g_hash_table_destroy (self->priv->search_highlight);
+
 	GList *copy = g_list_copy (self->priv->branch_actions);
 	GList *item;
 
@@ -236,6 +286,35 @@ gitg_window_dispose (GObject *object)
 		self->priv->hidden_settings = NULL;
 	}
 
+	if (self->priv->search_filter_id)
+	{
+		g_source_remove (self->priv->search_filter_id);
+		self->priv->search_filter_id = 0;
+	}
+
+	if (self->priv->search_filter)
+	{
+		g_object_unref (self->priv->search_filter);
+		self->priv->search_filter = NULL;
+	}
+
+	clear_search_matches (self);
+	cancel_search_log (self);
+
+	if (self->priv->search_log)
+	{
+		g_signal_handlers_disconnect_by_func (self->priv->search_log,
+		                                      G_CALLBACK (on_search_log_update),
+		                                      self);
+
+		g_signal_handlers_disconnect_by_func (self->priv->search_log,
+		                                      G_CALLBACK (on_search_log_end),
+		                                      self);
+
+		g_object_unref (self->priv->search_log);
+		self->priv->search_log = NULL;
+	}
+
 	G_OBJECT_CLASS (gitg_window_parent_class)->dispose (object);
 }
 
@@ -349,6 +428,18 @@ on_selection_changed (GtkTreeSelection *selection,
 
 	if (revision)
 	{
+		/* Warm the rows around the cursor for when it moves on, rows
+		   of the search filter do not map onto the repository */
+		if (model == GTK_TREE_MODEL (window->priv->repository))
+		{
+			GtkTreePath *path = gtk_tree_model_get_path (model, &iter);
+
+			gitg_prefetch_cursor_moved (gitg_prefetch_get (window->priv->repository),
+			                            gtk_tree_path_get_indices (path)[0]);
+
+			gtk_tree_path_free (path);
+		}
+
 		if (gitg_repository_get_loaded (window->priv->repository))
 		{
 			memcpy (window->priv->select_on_load,
@@ -382,60 +473,641 @@ on_search_icon_release (GtkEntry             *entry,
 	                gtk_get_current_event_time ());
 }
 
+static GitgSearchFields
+search_column_fields (gint column)
+{
+	switch (column)
+	{
+		case 1:
+			return GITG_SEARCH_SUBJECT;
+		case 2:
+			return GITG_SEARCH_AUTHOR | GITG_SEARCH_AUTHOR_EMAIL;
+		default:
+			return 0;
+	}
+}
+
+static void
+clear_search_matches (GitgWindow *window)
+{
+	if (window->priv->search_matches)
+	{
+		g_array_free (window->priv->search_matches, TRUE);
+		window->priv->search_matches = NULL;
+	}
+
+	g_free (window->priv->search_key);
+	window->priv->search_key = NULL;
+}
+
+static GArray *
+ensure_search_matches (GitgWindow  *window,
+                       gchar const *key,
+                       gint         column)
+{
+	/* Any change to the rows of the repository clears the matches */
+	if (window->priv->search_matches &&
+	    window->priv->search_column == column &&
+	    g_strcmp0 (window->priv->search_key, key) == 0)
+	{
+		return window->priv->search_matches;
+	}
+
+	clear_search_matches (window);
+
+	window->priv->search_matches = gitg_repository_search (window->priv->repository,
+	                                                       key,
+	                                                       search_column_fields (column));
+
+	window->priv->search_key = g_strdup (key);
+	window->priv->search_column = column;
+
+	return window->priv->search_matches;
+}
+
+static gboolean
+search_matches_row (GitgWindow   *window,
+                    GtkTreeModel *model,
+                    GtkTreeIter  *iter)
+{
+	GtkTreeIter child;
+	GtkTreePath *path;
+	guint row;
+
+	if (!window->priv->search_matches)
+	{
+		return FALSE;
+	}
+
+	if (GTK_IS_TREE_MODEL_FILTER (model))
+	{
+		gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (model),
+		                                                  &child,
+		                                                  iter);
+
+		model = gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (model));
+		iter = &child;
+	}
+
+	path = gtk_tree_model_get_path (model, iter);
+	row = gtk_tree_path_get_indices (path)[0];
+	gtk_tree_path_free (path);
+
+	return gitg_repository_search_contains (window->priv->search_matches,
+	                                        row);
+}
+
+static gboolean
+search_log_matches_row (GitgWindow   *window,
+                        GtkTreeModel *model,
+                        GtkTreeIter  *iter)
+{
+	GitgRevision *revision;
+	gboolean ret;
+
+	if (g_hash_table_size (window->priv->search_highlight) == 0)
+	{
+		return FALSE;
+	}
+
+	gtk_tree_model_get (model, iter, 0, &revision, -1);
+
+	ret = g_hash_table_lookup (window->priv->search_highlight,
+	                           gitg_revision_get_hash (revision)) != NULL;
+
+	gitg_revision_unref (revision);
+	return ret;
+}
+
+static gboolean
+search_filter_visible (GtkTreeModel *model,
+                       GtkTreeIter  *iter,
+                       GitgWindow   *window)
+{
+	if (window->priv->search_log_mode != SEARCH_LOG_NONE)
+	{
+		return search_log_matches_row (window, model, iter);
+	}
+
+	return search_matches_row (window, model, iter);
+}
+
+static gboolean
+get_selected_hash (GitgWindow *window,
+                   GitgHash    hash)
+{
+	GtkTreeSelection *selection;
+	GtkTreeModel *model;
+	GList *rows;
+	GtkTreeIter iter;
+	GitgRevision *revision;
+
+	selection = gtk_tree_view_get_selection (window->priv->tree_view);
+	rows = gtk_tree_selection_get_selected_rows (selection, &model);
+
+	if (!rows)
+	{
+		return FALSE;
+	}
+
+	gtk_tree_model_get_iter (model, &iter, (GtkTreePath *)rows->data);
+	gtk_tree_model_get (model, &iter, 0, &revision, -1);
+
+	memcpy (hash, gitg_revision_get_hash (revision), GITG_HASH_BINARY_SIZE);
+	gitg_revision_unref (revision);
+
+	g_list_foreach (rows, (GFunc)gtk_tree_path_free, NULL);
+	g_list_free (rows);
+
+	return TRUE;
+}
+
+static gboolean goto_iter (GitgWindow *window, GtkTreeIter *repository_iter);
+static gboolean goto_hash (GitgWindow *window, gchar const *hash);
+
+static void
+set_history_model (GitgWindow   *window,
+                   GtkTreeModel *model)
+{
+	GitgHash hash;
+	gboolean selected;
+
+	/* Keep the selected revision selected when switching models */
+	selected = get_selected_hash (window, hash);
+
+	gtk_tree_view_set_model (window->priv->tree_view, model);
+
+	if (selected)
+	{
+		goto_hash (window, hash);
+	}
+}
+
+static void
+remove_search_filter (GitgWindow *window)
+{
+	if (!window->priv->search_filter)
+	{
+		return;
+	}
+
+	set_history_model (window, GTK_TREE_MODEL (window->priv->repository));
+
+	g_object_unref (window->priv->search_filter);
+	window->priv->search_filter = NULL;
+}
+
+static void
+update_search_filter (GitgWindow *window)
+{
+	GtkToggleAction *action;
+	gchar const *key;
+	gint column;
+
+	action = GTK_TOGGLE_ACTION (gtk_ui_manager_get_action (window->priv->menus_ui_manager,
+	                                                       "/ui/search_popup/filter"));
+
+	key = gtk_entry_get_text (GTK_ENTRY (window->priv->search_entry));
+	column = gtk_tree_view_get_search_column (window->priv->tree_view);
+
+	if (!window->priv->repository ||
+	    !gtk_toggle_action_get_active (action) ||
+	    !*key ||
+	    (window->priv->search_log_mode == SEARCH_LOG_NONE &&
+	     !search_column_fields (column)))
+	{
+		remove_search_filter (window);
+		return;
+	}
+
+	if (window->priv->search_log_mode == SEARCH_LOG_NONE)
+	{
+		ensure_search_matches (window, key, column);
+	}
+
+	if (!window->priv->search_filter)
+	{
+		window->priv->search_filter =
+			gtk_tree_model_filter_new (GTK_TREE_MODEL (window->priv->repository),
+			                           NULL);
+
+		gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (window->priv->search_filter),
+		                                        (GtkTreeModelFilterVisibleFunc)search_filter_visible,
+		                                        window,
+		                                        NULL);
+
+		set_history_model (window, window->priv->search_filter);
+	}
+	else
+	{
+		gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (window->priv->search_filter));
+	}
+}
+
+static gboolean
+update_search_filter_timeout (GitgWindow *window)
+{
+	window->priv->search_filter_id = 0;
+	update_search_filter (window);
+
+	return FALSE;
+}
+
+static void
+queue_update_search_filter (GitgWindow *window)
+{
+	if (window->priv->search_filter_id)
+	{
+		g_source_remove (window->priv->search_filter_id);
+	}
+
+	window->priv->search_filter_id =
+		g_timeout_add (200,
+		               (GSourceFunc)update_search_filter_timeout,
+		               window);
+}
+
+void
+on_search_filter_toggled (GtkToggleAction *action,
+                          GitgWindow      *window)
+{
+	update_search_filter (window);
+}
+
+static void
+on_search_log_update (GitgShell   *shell,
+                      gchar      **lines,
+                      GitgWindow  *window)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL (window->priv->repository);
+	gboolean added = FALSE;
+
+	for (; *lines; ++lines)
+	{
+		GitgHash hash;
+		GtkTreeIter iter;
+		GtkTreePath *path;
+
+		if (strlen (*lines) != GITG_HASH_SHA_SIZE)
+		{
+			continue;
+		}
+
+		gitg_hash_sha1_to_hash (*lines, hash);
+
+		/* Revisions in later pages get highlighted once they are loaded */
+		g_hash_table_insert (window->priv->search_highlight,
+		                     g_memdup (hash, GITG_HASH_BINARY_SIZE),
+		                     GINT_TO_POINTER (1));
+
+		if (!gitg_repository_find_by_hash (window->priv->repository, hash, &iter))
+		{
+			if (!window->priv->search_log_selected)
+			{
+				/* Page in history until the first match shows up */
+				window->priv->search_log_selected = TRUE;
+				memcpy (window->priv->select_on_load, hash, GITG_HASH_BINARY_SIZE);
+				window->priv->page_to_select = TRUE;
+
+				load_more_history (window);
+			}
+
+			continue;
+		}
+
+		path = gtk_tree_model_get_path (model, &iter);
+		gtk_tree_model_row_changed (model, path, &iter);
+		gtk_tree_path_free (path);
+
+		added = TRUE;
+
+		if (!window->priv->search_log_selected)
+		{
+			window->priv->search_log_selected = TRUE;
+			goto_hash (window, hash);
+		}
+	}
+
+	if (added && window->priv->search_filter)
+	{
+		queue_update_search_filter (window);
+	}
+}
+
+static void
+on_search_log_end (GitgShell  *shell,
+                   GError     *error,
+                   GitgWindow *window)
+{
+	gchar *msg;
+	guint num;
+
+	if (error || gitg_io_get_cancelled (GITG_IO (shell)))
+	{
+		return;
+	}
+
+	num = g_hash_table_size (window->priv->search_highlight);
+
+	msg = g_strdup_printf (ngettext ("Found %u matching revision",
+	                                 "Found %u matching revisions",
+	                                 num),
+	                       num);
+
+	gtk_statusbar_push (window->priv->statusbar, 0, msg);
+	g_free (msg);
+}
+
+static void
+clear_search_highlight (GitgWindow *window)
+{
+	if (g_hash_table_size (window->priv->search_highlight) == 0)
+	{
+		return;
+	}
+
+	g_hash_table_remove_all (window->priv->search_highlight);
+	gtk_widget_queue_draw (GTK_WIDGET (window->priv->tree_view));
+
+	if (window->priv->search_filter)
+	{
+		queue_update_search_filter (window);
+	}
+}
+
+static void
+cancel_search_log (GitgWindow *window)
+{
+	if (window->priv->search_log_id)
+	{
+		g_source_remove (window->priv->search_log_id);
+		window->priv->search_log_id = 0;
+	}
+
+	if (window->priv->search_log)
+	{
+		gitg_io_cancel (GITG_IO (window->priv->search_log));
+	}
+
+	clear_search_highlight (window);
+}
+
+static void
+start_search_log (GitgWindow *window)
+{
+	gchar const *key;
+	gchar const **selection;
+	gchar *option;
+	GitgCommand *command;
+
+	cancel_search_log (window);
+
+	key = gtk_entry_get_text (GTK_ENTRY (window->priv->search_entry));
+
+	if (!window->priv->repository || !*key)
+	{
+		return;
+	}
+
+	if (!window->priv->search_log)
+	{
+		window->priv->search_log = gitg_shell_new (1000);
+
+		g_signal_connect (window->priv->search_log,
+		                  "update",
+		                  G_CALLBACK (on_search_log_update),
+		                  window);
+
+		g_signal_connect (window->priv->search_log,
+		                  "end",
+		                  G_CALLBACK (on_search_log_end),
+		                  window);
+	}
+
+	switch (window->priv->search_log_mode)
+	{
+		case SEARCH_LOG_MESSAGE:
+			option = g_strconcat ("--grep=", key, NULL);
+		break;
+		case SEARCH_LOG_PICKAXE:
+			option = g_strconcat ("-S", key, NULL);
+		break;
+		case SEARCH_LOG_REGEX:
+			option = g_strconcat ("-G", key, NULL);
+		break;
+		default:
+			return;
+	}
+
+	command = gitg_command_new (window->priv->repository,
+	                            "log",
+	                            "--format=%H",
+	                            option,
+	                            NULL);
+
+	if (window->priv->search_log_mode == SEARCH_LOG_MESSAGE)
+	{
+		gitg_command_add_arguments (command,
+		                            "--regexp-ignore-case",
+		                            "--fixed-strings",
+		                            NULL);
+	}
+
+	/* Only look in the range of revisions that is loaded */
+	selection = gitg_repository_get_current_selection (window->priv->repository);
+
+	if (selection && *selection)
+	{
+		for (; *selection; ++selection)
+		{
+			gitg_command_add_arguments (command, *selection, NULL);
+		}
+	}
+	else
+	{
+		gitg_command_add_arguments (command, "HEAD", NULL);
+	}
+
+	window->priv->search_log_selected = FALSE;
+	gitg_shell_run (window->priv->search_log, command, NULL);
+
+	g_free (option);
+}
+
+static gboolean
+start_search_log_timeout (GitgWindow *window)
+{
+	window->priv->search_log_id = 0;
+	start_search_log (window);
+
+	return FALSE;
+}
+
+static gboolean
+search_unique_hash (GitgWindow  *window,
+                    gchar const *key)
+{
+	GtkTreeIter iter;
+
+	if (window->priv->search_log_mode != SEARCH_LOG_NONE ||
+	    !window->priv->repository ||
+	    gtk_tree_view_get_search_column (window->priv->tree_view) != 4 ||
+	    !gitg_repository_find_by_prefix (window->priv->repository,
+	                                     key,
+	                                     &iter,
+	                                     NULL))
+	{
+		return FALSE;
+	}
+
+	gtk_tree_selection_unselect_all (gtk_tree_view_get_selection (window->priv->tree_view));
+	goto_iter (window, &iter);
+
+	return TRUE;
+}
+
+static void
+on_search_entry_changed (GtkEntry   *entry,
+                         GitgWindow *window)
+{
+	/* A unique hash prefix is found in the hash index, ambiguous ones
+	   are left to the search of the tree view, which scans the rows */
+	if (search_unique_hash (window, gtk_entry_get_text (entry)))
+	{
+		g_signal_stop_emission_by_name (entry, "changed");
+	}
+
+	if (window->priv->search_log_mode != SEARCH_LOG_NONE)
+	{
+		/* Restart the search when typing has paused */
+		cancel_search_log (window);
+
+		window->priv->search_log_id =
+			g_timeout_add (300,
+			               (GSourceFunc)start_search_log_timeout,
+			               window);
+	}
+
+	queue_update_search_filter (window);
+}
+
 static void
-search_column_activate (GtkAction   *action,
-                        gint         column,
-                        GtkTreeView *tree_view)
+search_column_activate (GtkAction  *action,
+                        gint        column,
+                        GitgWindow *window)
 {
 	if (!gtk_toggle_action_get_active (GTK_TOGGLE_ACTION(action)))
 	{
 		return;
 	}
 
-	gtk_tree_view_set_search_column (tree_view, column);
+	if (window->priv->search_log_mode != SEARCH_LOG_NONE)
+	{
+		window->priv->search_log_mode = SEARCH_LOG_NONE;
+		cancel_search_log (window);
+	}
+
+	gtk_tree_view_set_search_column (window->priv->tree_view, column);
+	update_search_filter (window);
+}
+
+static void
+search_log_activate (GtkAction     *action,
+                     SearchLogMode  mode,
+                     GitgWindow    *window)
+{
+	if (!gtk_toggle_action_get_active (GTK_TOGGLE_ACTION(action)))
+	{
+		return;
+	}
+
+	window->priv->search_log_mode = mode;
+
+	/* Found revisions are highlighted in the subject column */
+	gtk_tree_view_set_search_column (window->priv->tree_view, 1);
+
+	start_search_log (window);
+	update_search_filter (window);
+}
+
+void
+on_message_activate (GtkAction  *action,
+                     GitgWindow *window)
+{
+	search_log_activate (action, SEARCH_LOG_MESSAGE, window);
+}
+
+void
+on_pickaxe_activate (GtkAction  *action,
+                     GitgWindow *window)
+{
+	search_log_activate (action, SEARCH_LOG_PICKAXE, window);
+}
+
+void
+on_regex_activate (GtkAction  *action,
+                   GitgWindow *window)
+{
+	search_log_activate (action, SEARCH_LOG_REGEX, window);
 }
 
 void
 on_subject_activate (GtkAction  *action,
                      GitgWindow *window)
 {
-	search_column_activate (action, 1, window->priv->tree_view);
+	search_column_activate (action, 1, window);
 }
 
 void
 on_author_activate (GtkAction  *action,
                     GitgWindow *window)
 {
-	search_column_activate (action, 2, window->priv->tree_view);
+	search_column_activate (action, 2, window);
 }
 
 void
 on_date_activate (GtkAction  *action,
                   GitgWindow *window)
 {
-	search_column_activate (action, 3, window->priv->tree_view);
+	search_column_activate (action, 3, window);
 }
 
 void
 on_hash_activate (GtkAction  *action,
                   GitgWindow *window)
 {
-	search_column_activate (action, 4, window->priv->tree_view);
+	search_column_activate (action, 4, window);
 }
 
 static gboolean
-search_hash_equal_func (GtkTreeModel *model,
-                        gchar const  *key,
-                        GtkTreeIter  *iter)
+search_hash_equal_func (GitgRepository *repository,
+                        GtkTreeModel   *model,
+                        gchar const    *key,
+                        GtkTreeIter    *iter)
 {
 	GitgRevision *rv;
-	gtk_tree_model_get (model, iter, 0, &rv, -1);
+	GitgHash prefix;
+	gint length;
+	gboolean ambiguous;
+
+	/* The hash index tells whether any revision matches at all, which
+	   saves looking at every row when nothing does */
+	if (!gitg_repository_find_by_prefix (repository,
+	                                     key,
+	                                     NULL,
+	                                     &ambiguous) && !ambiguous)
+	{
+		return TRUE;
+	}
 
-	gchar *sha = gitg_revision_get_sha1 (rv);
+	length = gitg_hash_parse_prefix (key, prefix);
+
+	gtk_tree_model_get (model, iter, 0, &rv, -1);
 
-	gboolean ret = !g_str_has_prefix (sha, key);
+	gboolean ret = !gitg_hash_has_prefix (gitg_revision_get_hash (rv),
+	                                      prefix,
+	                                      length);
 
-	g_free (sha);
 	gitg_revision_unref (rv);
 
 	return ret;
@@ -448,9 +1120,26 @@ search_equal_func (GtkTreeModel *model,
                    GtkTreeIter  *iter,
                    gpointer      userdata)
 {
+	GitgWindow *window = GITG_WINDOW (userdata);
+
+	if (window->priv->search_log_mode != SEARCH_LOG_NONE)
+	{
+		return !search_log_matches_row (window, model, iter);
+	}
+
 	if (column == 4)
 	{
-		return search_hash_equal_func (model, key, iter);
+		return search_hash_equal_func (window->priv->repository,
+		                               model,
+		                               key,
+		                               iter);
+	}
+
+	if (search_column_fields (column))
+	{
+		/* Looked up in the search index once per key */
+		ensure_search_matches (window, key, column);
+		return !search_matches_row (window, model, iter);
 	}
 
 	gchar *cmp;
@@ -494,7 +1183,16 @@ build_search_entry (GitgWindow *window,
 	                               GTK_ENTRY_ICON_PRIMARY,
 	                               GTK_STOCK_FIND);
 
+	/* Connected before the tree view, which then does not search rows
+	   for a unique hash prefix */
+	g_signal_connect (entry,
+	                  "changed",
+	                  G_CALLBACK (on_search_entry_changed),
+	                  window);
+
 	gtk_tree_view_set_search_entry (window->priv->tree_view, GTK_ENTRY(entry));
+	window->priv->search_entry = entry;
+
 	gtk_widget_show (entry);
 	gtk_box_pack_end (GTK_BOX(box), entry, FALSE, FALSE, 0);
 
@@ -525,22 +1223,36 @@ build_search_entry (GitgWindow *window,
 }
 
 static gboolean
-goto_hash (GitgWindow  *window,
-           gchar const *hash)
+goto_iter (GitgWindow  *window,
+           GtkTreeIter *repository_iter)
 {
-	GtkTreeIter iter;
+	GtkTreeModel *model;
+	GtkTreeIter iter = *repository_iter;
 
-	if (!gitg_repository_find_by_hash (window->priv->repository, hash, &iter))
+	model = gtk_tree_view_get_model (window->priv->tree_view);
+
+	if (window->priv->search_filter && model == window->priv->search_filter)
 	{
-		return FALSE;
+		GtkTreeIter child = iter;
+
+		/* Not shown while filtering on the search */
+		if (!search_filter_visible (GTK_TREE_MODEL (window->priv->repository),
+		                            &child,
+		                            window))
+		{
+			return FALSE;
+		}
+
+		gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (model),
+		                                                  &iter,
+		                                                  &child);
 	}
 
 	gtk_tree_selection_select_iter (gtk_tree_view_get_selection (window->priv->tree_view),
 	                                &iter);
 	GtkTreePath *path;
 
-	path = gtk_tree_model_get_path (GTK_TREE_MODEL(window->priv->repository),
-	                                &iter);
+	path = gtk_tree_model_get_path (model, &iter);
 
 	gtk_tree_view_scroll_to_cell (window->priv->tree_view,
 	                              path,
@@ -553,6 +1265,20 @@ goto_hash (GitgWindow  *window,
 	return TRUE;
 }
 
+static gboolean
+goto_hash (GitgWindow  *window,
+           gchar const *hash)
+{
+	GtkTreeIter iter;
+
+	if (!gitg_repository_find_by_hash (window->priv->repository, hash, &iter))
+	{
+		return FALSE;
+	}
+
+	return goto_iter (window, &iter);
+}
+
 static void
 on_renderer_path (GtkTreeViewColumn    *column,
                   GitgCellRendererPath *renderer,
@@ -587,6 +1313,13 @@ on_renderer_path (GtkTreeViewColumn    *column,
 		break;
 	}
 
+	g_object_set (renderer,
+	              "weight",
+	              g_hash_table_lookup (window->priv->search_highlight,
+	                                   gitg_revision_get_hash (rv)) ? PANGO_WEIGHT_BOLD
+	                                                                : PANGO_WEIGHT_NORMAL,
+	              NULL);
+
 	if (lbl != NULL)
 	{
 		g_object_set (renderer, "style", PANGO_STYLE_ITALIC, NULL);
@@ -597,7 +1330,7 @@ on_renderer_path (GtkTreeViewColumn    *column,
 	else
 	{
 		g_object_set (renderer, "style", PANGO_STYLE_NORMAL, NULL);
-		labels = gitg_repository_get_refs_for_hash (GITG_REPOSITORY(model),
+		labels = gitg_repository_get_refs_for_hash (window->priv->repository,
 		                                            gitg_revision_get_hash (rv));
 	}
 
@@ -810,9 +1543,10 @@ on_refs_dnd (GitgRef    *source,
 	{
 		if (dest_type == GITG_REF_TYPE_BRANCH)
 		{
-			ret = gitg_branch_actions_apply_stash (window,
-			                                       source,
-			                                       dest);
+			ret = gitg_window_add_branch_action (window,
+			                                     gitg_branch_actions_apply_stash (window,
+			                                                                      source,
+			                                                                      dest));
 		}
 	}
 	else if (dest_type == GITG_REF_TYPE_BRANCH)
@@ -878,6 +1612,101 @@ on_revision_dnd (GitgRevision *source,
 	                                      gitg_branch_actions_cherry_pick (window, source, dest));
 }
 
+static void
+set_fixed_row_height (GitgWindow *window)
+{
+	GList *columns = gtk_tree_view_get_columns (window->priv->tree_view);
+	GList *item;
+
+	/* Every row is a single line of text, so the row height follows from
+	   the font and fixed height mode never has to measure rows */
+	for (item = columns; item; item = g_list_next (item))
+	{
+		GList *cells = gtk_cell_layout_get_cells (GTK_CELL_LAYOUT (item->data));
+		GList *cell;
+
+		for (cell = cells; cell; cell = g_list_next (cell))
+		{
+			if (GTK_IS_CELL_RENDERER_TEXT (cell->data))
+			{
+				gtk_cell_renderer_text_set_fixed_height_from_font (cell->data, 1);
+			}
+		}
+
+		g_list_free (cells);
+	}
+
+	g_list_free (columns);
+}
+
+static void
+on_tree_view_style_set (GtkWidget  *widget,
+                        GtkStyle   *prev,
+                        GitgWindow *window)
+{
+	set_fixed_row_height (window);
+}
+
+static void
+size_column_from_samples (GitgWindow        *window,
+                          GtkTreeViewColumn *column)
+{
+	GtkTreeModel *model = GTK_TREE_MODEL (window->priv->repository);
+	gint num = gtk_tree_model_iter_n_children (model, NULL);
+	gint step = MAX (1, num / COLUMN_SAMPLE_ROWS);
+	gint width = 0;
+	gint i;
+
+	for (i = 0; i < num; i += step)
+	{
+		GtkTreeIter iter;
+		gint w;
+
+		if (!gtk_tree_model_iter_nth_child (model, &iter, NULL, i))
+		{
+			break;
+		}
+
+		gtk_tree_view_column_cell_set_cell_data (column, model, &iter, FALSE, FALSE);
+		gtk_tree_view_column_cell_get_size (column, NULL, NULL, NULL, &w, NULL);
+
+		width = MAX (width, w);
+	}
+
+	if (width > 0)
+	{
+		gint separator;
+
+		gtk_widget_style_get (GTK_WIDGET (window->priv->tree_view),
+		                      "horizontal-separator", &separator,
+		                      NULL);
+
+		gtk_tree_view_column_set_fixed_width (column, width + separator);
+	}
+}
+
+static void
+size_columns (GitgWindow *window,
+              gboolean    force)
+{
+	if (window->priv->columns_sized || !window->priv->repository)
+	{
+		return;
+	}
+
+	if (!force &&
+	    gtk_tree_model_iter_n_children (GTK_TREE_MODEL (window->priv->repository),
+	                                    NULL) < COLUMN_SAMPLE_ROWS)
+	{
+		return;
+	}
+
+	size_column_from_samples (window, window->priv->column_author);
+	size_column_from_samples (window, window->priv->column_date);
+
+	window->priv->columns_sized = TRUE;
+}
+
 static void
 init_tree_view (GitgWindow *window,
                 GtkBuilder *builder)
@@ -896,6 +1725,25 @@ init_tree_view (GitgWindow *window,
 	                                         window,
 	                                         NULL);
 
+	window->priv->column_author = GTK_TREE_VIEW_COLUMN (gtk_builder_get_object (builder,
+	                                                                            "rv_column2"));
+
+	window->priv->column_date = GTK_TREE_VIEW_COLUMN (gtk_builder_get_object (builder,
+	                                                                          "rv_column3"));
+
+	gtk_tree_view_set_fixed_height_mode (window->priv->tree_view, TRUE);
+	set_fixed_row_height (window);
+
+	g_signal_connect (window->priv->tree_view,
+	                  "style-set",
+	                  G_CALLBACK (on_tree_view_style_set),
+	                  window);
+
+	g_signal_connect (gtk_tree_view_get_vadjustment (window->priv->tree_view),
+	                  "value-changed",
+	                  G_CALLBACK (on_history_scrolled),
+	                  window);
+
 	gitg_dnd_enable (window->priv->tree_view,
 	                 (GitgDndCallback)on_refs_dnd,
 	                 (GitgDndRevisionCallback)on_revision_dnd,
@@ -1210,27 +2058,105 @@ gitg_window_init (GitgWindow *self)
 	self->priv->view_settings = g_settings_new ("org.gnome.gitg.preferences.view.main");
 	self->priv->history_settings = g_settings_new ("org.gnome.gitg.preferences.view.history");
 	self->priv->hidden_settings = g_settings_new ("org.gnome.gitg.preferences.hidden");
+
+	self->priv->search_highlight = g_hash_table_new_full (gitg_hash_hash,
+	                                                      gitg_hash_hash_equal,
+	                                                      g_free,
+	                                                      NULL);
+}
+
+static void
+load_more_history (GitgWindow *window)
+{
+	if (window->priv->loading_page ||
+	    !gitg_repository_load_more (window->priv->repository))
+	{
+		return;
+	}
+
+	window->priv->loading_page = TRUE;
+	gtk_statusbar_push (window->priv->statusbar, 0, _ ("Loading more revisions..."));
+}
+
+static void
+check_load_more (GitgWindow *window)
+{
+	GtkAdjustment *adj;
+
+	if (!window->priv->repository ||
+	    !gitg_repository_get_has_more (window->priv->repository))
+	{
+		return;
+	}
+
+	adj = gtk_tree_view_get_vadjustment (window->priv->tree_view);
+
+	/* Fetch the next page once less than a screen of history is left */
+	if (gtk_adjustment_get_value (adj) + 2 * gtk_adjustment_get_page_size (adj) >=
+	    gtk_adjustment_get_upper (adj))
+	{
+		load_more_history (window);
+	}
+}
+
+static void
+on_history_scrolled (GtkAdjustment *adjustment,
+                     GitgWindow    *window)
+{
+	check_load_more (window);
 }
 
 static void
 on_repository_loaded (GitgRepository *repository,
                       GitgWindow     *window)
 {
-	gchar *msg = g_strdup_printf (_ ("Loaded %d revisions in %.2fs"),
-	                             gtk_tree_model_iter_n_children (GTK_TREE_MODEL(window->priv->repository), NULL),
-	                             g_timer_elapsed (window->priv->load_timer, NULL));
+	gboolean page = window->priv->loading_page;
+	gchar *msg;
+
+	window->priv->loading_page = FALSE;
+
+	if (page)
+	{
+		msg = g_strdup_printf (_ ("Loaded %d revisions"),
+		                       gtk_tree_model_iter_n_children (GTK_TREE_MODEL(window->priv->repository), NULL));
+	}
+	else
+	{
+		msg = g_strdup_printf (_ ("Loaded %d revisions in %.2fs"),
+		                       gtk_tree_model_iter_n_children (GTK_TREE_MODEL(window->priv->repository), NULL),
+		                       g_timer_elapsed (window->priv->load_timer, NULL));
+	}
 
 	gtk_statusbar_push (window->priv->statusbar, 0, msg);
 
 	g_free (msg);
 	gdk_window_set_cursor (gtk_widget_get_window (GTK_WIDGET (window->priv->tree_view)), NULL);
 
+	size_columns (window, TRUE);
+
 	GitgHash hash = {0,};
 
-	if (memcmp (window->priv->select_on_load, hash, GITG_HASH_BINARY_SIZE) != 0)
+	/* Pages loaded while scrolling should not move the selection */
+	if ((!page || window->priv->page_to_select) &&
+	    memcmp (window->priv->select_on_load, hash, GITG_HASH_BINARY_SIZE) != 0)
 	{
-		goto_hash (window, window->priv->select_on_load);
+		if (goto_hash (window, window->priv->select_on_load))
+		{
+			window->priv->page_to_select = FALSE;
+		}
+		else if (window->priv->page_to_select &&
+		         gitg_repository_get_has_more (repository))
+		{
+			load_more_history (window);
+			return;
+		}
+		else
+		{
+			window->priv->page_to_select = FALSE;
+		}
 	}
+
+	check_load_more (window);
 }
 
 static void
@@ -1243,6 +2169,14 @@ on_update (GitgShell   *loader,
 
 	gtk_statusbar_push (window->priv->statusbar, 0, msg);
 	g_free (msg);
+
+	size_columns (window, FALSE);
+
+	if (window->priv->search_filter)
+	{
+		/* Show new matching revisions as they come in */
+		queue_update_search_filter (window);
+	}
 }
 
 void
@@ -1389,30 +2323,21 @@ create_repository (GitgWindow  *window,
 	return window->priv->repository != NULL;
 }
 
-static int
-sort_by_ref_type (GitgRef *a,
-                  GitgRef *b)
+static GSList *
+move_master_first (GSList *refs)
 {
-	if (gitg_ref_get_ref_type (a) == gitg_ref_get_ref_type (b))
+	GSList *item;
+
+	for (item = refs; item; item = g_slist_next (item))
 	{
-		if (g_ascii_strcasecmp (gitg_ref_get_shortname (a), "master") == 0)
-		{
-			return -1;
-		}
-		else if (g_ascii_strcasecmp (gitg_ref_get_shortname (b), "master") == 0)
-		{
-			return 1;
-		}
-		else
+		if (g_ascii_strcasecmp (gitg_ref_get_shortname (item->data), "master") == 0)
 		{
-			return g_ascii_strcasecmp (gitg_ref_get_shortname (a),
-			                           gitg_ref_get_shortname (b));
+			refs = g_slist_remove_link (refs, item);
+			return g_slist_concat (item, refs);
 		}
 	}
-	else
-	{
-		return gitg_ref_get_ref_type (a) - gitg_ref_get_ref_type (b);
-	}
+
+	return refs;
 }
 
 static void
@@ -1471,9 +2396,11 @@ fill_branches_combo (GitgWindow *window)
 		return;
 	}
 
-	GSList *refs = gitg_repository_get_refs (window->priv->repository);
-
-	refs = g_slist_sort (refs, (GCompareFunc)sort_by_ref_type);
+	/* The repository keeps its refs sorted by type and name */
+	GSList *refs = g_slist_concat (move_master_first (gitg_repository_get_refs_by_type (window->priv->repository,
+	                                                                                    GITG_REF_TYPE_BRANCH)),
+	                               gitg_repository_get_refs_by_type (window->priv->repository,
+	                                                                 GITG_REF_TYPE_REMOTE));
 	GSList *item;
 
 	GitgRefType prevtype = GITG_REF_TYPE_NONE;
@@ -1701,6 +2628,11 @@ on_repository_load (GitgRepository *repository,
 
 	gtk_statusbar_push (window->priv->statusbar, 0, _ ("Begin loading repository"));
 
+	window->priv->loading_page = FALSE;
+
+	clear_search_matches (window);
+	cancel_search_log (window);
+
 	g_timer_reset (window->priv->load_timer);
 	g_timer_start (window->priv->load_timer);
 
@@ -1763,7 +2695,19 @@ gitg_window_select (GitgWindow  *window,
 		return FALSE;
 	}
 
-	return goto_hash (window, window->priv->select_on_load);
+	if (goto_hash (window, window->priv->select_on_load))
+	{
+		return TRUE;
+	}
+
+	/* The revision may be further down in history than loaded so far */
+	if (gitg_repository_get_has_more (window->priv->repository))
+	{
+		window->priv->page_to_select = TRUE;
+		load_more_history (window);
+	}
+
+	return FALSE;
 }
 
 static gboolean
@@ -1778,6 +2722,16 @@ load_repository (GitgWindow   *window,
 	{
 		gtk_tree_view_set_model (window->priv->tree_view, NULL);
 
+		if (window->priv->search_filter)
+		{
+			g_object_unref (window->priv->search_filter);
+			window->priv->search_filter = NULL;
+		}
+
+		clear_search_matches (window);
+		cancel_search_log (window);
+		gitg_prefetch_cancel (gitg_prefetch_get (window->priv->repository));
+
 		g_signal_handlers_disconnect_by_func (window->priv->repository,
 		                                      G_CALLBACK (on_repository_load),
 		                                      window);
@@ -1786,12 +2740,19 @@ load_repository (GitgWindow   *window,
 		                                      G_CALLBACK (on_repository_loaded),
 		                                      window);
 
+		g_signal_handlers_disconnect_by_func (window->priv->repository,
+		                                      G_CALLBACK (clear_search_matches),
+		                                      window);
+
 		g_object_unref (window->priv->repository);
 		window->priv->repository = NULL;
 
 		gitg_repository_dialog_close ();
 
 		memset (window->priv->select_on_load, 0, GITG_HASH_BINARY_SIZE);
+		window->priv->columns_sized = FALSE;
+		window->priv->loading_page = FALSE;
+		window->priv->page_to_select = FALSE;
 	}
 
 	if ((git_dir || work_tree) &&
@@ -1817,6 +2778,22 @@ load_repository (GitgWindow   *window,
 		                  G_CALLBACK (on_repository_loaded),
 		                  window);
 
+		/* Rows of search matches shift with inserted or removed rows */
+		g_signal_connect_swapped (window->priv->repository,
+		                          "row-inserted",
+		                          G_CALLBACK (clear_search_matches),
+		                          window);
+
+		g_signal_connect_swapped (window->priv->repository,
+		                          "row-deleted",
+		                          G_CALLBACK (clear_search_matches),
+		                          window);
+
+		g_signal_connect_swapped (window->priv->repository,
+		                          "rows-reordered",
+		                          G_CALLBACK (clear_search_matches),
+		                          window);
+
 		clear_branches_combo (window);
 
 		gitg_repository_load (window->priv->repository, argc, argv, NULL);
@@ -2291,7 +3268,7 @@ find_lane_boundary (GitgWindow   *window,
                     gint          cell_x,
                     gchar const **hash)
 {
-	GtkTreeModel *model = GTK_TREE_MODEL(window->priv->repository);
+	GtkTreeModel *model = gtk_tree_view_get_model (window->priv->tree_view);
 	GtkTreeIter iter;
 	guint width;
 	GitgRevision *revision;
@@ -2472,7 +3449,10 @@ on_stash_activated (GtkAction  *action,
 	GitgRef *dest = g_object_get_data (G_OBJECT (action),
 	                                   DYNAMIC_ACTION_DATA_KEY);
 
-	gitg_branch_actions_apply_stash (window, window->priv->popup_refs[0], dest);
+	gitg_window_add_branch_action (window,
+	                               gitg_branch_actions_apply_stash (window,
+	                                                                window->priv->popup_refs[0],
+	                                                                dest));
 }
 
 static void
@@ -2522,25 +3502,13 @@ repository_has_ref (GitgWindow  *window,
                     gchar const *remote,
                     gchar const *branch)
 {
-	GSList *refs = gitg_repository_get_refs (window->priv->repository);
-	gchar *combined = g_strconcat (remote, "/", branch, NULL);
-
-	while (refs)
-	{
-		GitgRef *r = (GitgRef *)refs->data;
-
-		if (gitg_ref_get_ref_type (r) == GITG_REF_TYPE_REMOTE &&
-		    strcmp (gitg_ref_get_shortname (r), combined) == 0)
-		{
-			g_free (combined);
-			return TRUE;
-		}
+	gchar *name = g_strconcat ("refs/remotes/", remote, "/", branch, NULL);
+	gboolean ret;
 
-		refs = g_slist_next (refs);
-	}
+	ret = gitg_repository_lookup_ref (window->priv->repository, name) != NULL;
 
-	g_free (combined);
-	return FALSE;
+	g_free (name);
+	return ret;
 }
 
 static void
@@ -2645,7 +3613,8 @@ update_merge_rebase (GitgWindow *window,
 		                                    0);
 	}
 
-	GSList *refs = gitg_repository_get_refs (window->priv->repository);
+	GSList *refs = gitg_repository_get_refs_by_type (window->priv->repository,
+	                                                 GITG_REF_TYPE_BRANCH);
 	GSList *item;
 
 	for (item = refs; item; item = g_slist_next (item))
@@ -2808,31 +3777,12 @@ static gboolean
 has_local_ref (GitgWindow  *window,
                gchar const *name)
 {
-	GSList *refs = gitg_repository_get_refs (window->priv->repository);
-	GSList *item;
-	gboolean ret = FALSE;
-
-	for (item = refs; item; item = g_slist_next (item))
-	{
-		GitgRef *ref = GITG_REF (item->data);
-
-		if (gitg_ref_get_ref_type (ref) != GITG_REF_TYPE_BRANCH)
-		{
-			continue;
-		}
-
-		gchar const *nm = gitg_ref_get_shortname (ref);
-
-		if (g_strcmp0 (name, nm) == 0)
-		{
-			ret = TRUE;
-			break;
-		}
-	}
+	gchar *refname = g_strconcat ("refs/heads/", name, NULL);
+	gboolean ret;
 
-	g_slist_foreach (refs, (GFunc)gitg_ref_free, NULL);
-	g_slist_free (refs);
+	ret = gitg_repository_lookup_ref (window->priv->repository, refname) != NULL;
 
+	g_free (refname);
 	return ret;
 }
 
@@ -3034,7 +3984,8 @@ update_cherry_pick (GitgWindow *window)
 		                                    0);
 	}
 
-	GSList *refs = gitg_repository_get_refs (window->priv->repository);
+	GSList *refs = gitg_repository_get_refs_by_type (window->priv->repository,
+	                                                 GITG_REF_TYPE_BRANCH);
 	GSList *item;
 
 	for (item = refs; item; item = g_slist_next (item))
@@ -3115,7 +4066,7 @@ popup_revision (GitgWindow     *window,
 		GitgRevision *rev;
 		gchar sign;
 
-		model = GTK_TREE_MODEL (window->priv->repository);
+		model = gtk_tree_view_get_model (window->priv->tree_view);
 		gtk_tree_model_get_iter (model, &iter, rows->data);
 
 		gtk_tree_model_get (model, &iter, 0, &rev, -1);
@@ -3185,24 +4136,27 @@ void
 on_checkout_branch_action_activate (GtkAction  *action,
                                     GitgWindow *window)
 {
-	if (gitg_branch_actions_checkout (window, window->priv->popup_refs[0]))
-	{
-		update_window_title (window);
-	}
+	gitg_window_add_branch_action (window,
+	                               gitg_branch_actions_checkout (window,
+	                                                             window->priv->popup_refs[0]));
 }
 
 void
 on_remove_branch_action_activate (GtkAction  *action,
                                   GitgWindow *window)
 {
-	gitg_branch_actions_remove (window, window->priv->popup_refs[0]);
+	gitg_window_add_branch_action (window,
+	                               gitg_branch_actions_remove (window,
+	                                                           window->priv->popup_refs[0]));
 }
 
 void
 on_rename_branch_action_activate (GtkAction  *action,
                                   GitgWindow *window)
 {
-	gitg_branch_actions_rename (window, window->priv->popup_refs[0]);
+	gitg_window_add_branch_action (window,
+	                               gitg_branch_actions_rename (window,
+	                                                           window->priv->popup_refs[0]));
 }
 
 void
@@ -3241,6 +4195,9 @@ typedef struct
 	GtkBuilder *builder;
 	GitgWindow *window;
 	GitgRevision *revision;
+
+	GtkWidget *dialog;
+	GitgShell *shell;
 } TagInfo;
 
 static void
@@ -3252,6 +4209,48 @@ free_tag_info (TagInfo *info)
 	g_slice_free (TagInfo, info);
 }
 
+static void
+on_tag_info_shell_end (GitgShell *shell,
+                       GError    *error,
+                       TagInfo   *info)
+{
+	info->shell = NULL;
+
+	/* The window is going away */
+	if (gitg_io_get_cancelled (GITG_IO (shell)))
+	{
+		return;
+	}
+
+	if (!error && gitg_io_get_exit_status (GITG_IO (shell)) == 0)
+	{
+		gtk_widget_destroy (info->dialog);
+		free_tag_info (info);
+	}
+	else
+	{
+		gtk_widget_set_sensitive (info->dialog, TRUE);
+	}
+}
+
+/* Keeps the dialog open until the action finished, so that it can be
+   corrected when it failed */
+static void
+watch_tag_info_action (TagInfo   *info,
+                       GitgShell *shell)
+{
+	if (!shell)
+	{
+		return;
+	}
+
+	info->shell = shell;
+	gtk_widget_set_sensitive (info->dialog, FALSE);
+
+	g_signal_connect (shell, "end", G_CALLBACK (on_tag_info_shell_end), info);
+	gitg_window_add_branch_action (info->window, shell);
+}
+
 static void
 on_new_branch_dialog_response (GtkWidget *dialog,
                         gint       response,
@@ -3259,6 +4258,11 @@ on_new_branch_dialog_response (GtkWidget *dialog,
 {
 	gboolean destroy = TRUE;
 
+	if (info->shell)
+	{
+		return;
+	}
+
 	if (response == GTK_RESPONSE_ACCEPT)
 	{
 		gchar const *name = gtk_entry_get_text (GTK_ENTRY (gtk_builder_get_object (info->builder, "entry_name")));
@@ -3267,12 +4271,13 @@ on_new_branch_dialog_response (GtkWidget *dialog,
 		{
 			gchar *sha1 = gitg_revision_get_sha1 (info->revision);
 
-			if (!gitg_branch_actions_create (info->window, sha1, name))
-			{
-				destroy = FALSE;
-			}
+			watch_tag_info_action (info,
+			                       gitg_branch_actions_create (info->window,
+			                                                   sha1,
+			                                                   name));
 
 			g_free (sha1);
+			destroy = FALSE;
 		}
 		else
 		{
@@ -3307,6 +4312,11 @@ on_tag_dialog_response (GtkWidget *dialog,
 {
 	gboolean destroy = TRUE;
 
+	if (info->shell)
+	{
+		return;
+	}
+
 	if (response == GTK_RESPONSE_ACCEPT)
 	{
 		gchar const *name = gtk_entry_get_text (GTK_ENTRY (gtk_builder_get_object (info->builder, "entry_name")));
@@ -3349,16 +4359,15 @@ on_tag_dialog_response (GtkWidget *dialog,
 		else
 		{
 			gchar *sha1 = gitg_revision_get_sha1 (info->revision);
-			if (!gitg_branch_actions_tag (info->window,
-			                              sha1,
-			                              name,
-			                              message,
-			                              sign))
-			{
-				destroy = FALSE;
-			}
+			watch_tag_info_action (info,
+			                       gitg_branch_actions_tag (info->window,
+			                                                sha1,
+			                                                name,
+			                                                message,
+			                                                sign));
 
 			g_free (sha1);
+			destroy = FALSE;
 
 			g_settings_set_boolean (info->window->priv->hidden_settings,
 			                        "sign-tag", sign);
@@ -3534,11 +4543,12 @@ on_revision_new_branch_activate (GtkAction  *action,
 		gtk_tree_model_get_iter (model, &iter, (GtkTreePath *)rows->data);
 		gtk_tree_model_get (model, &iter, 0, &rev, -1);
 
-		TagInfo *info = g_slice_new (TagInfo);
+		TagInfo *info = g_slice_new0 (TagInfo);
 
 		info->revision = gitg_revision_ref (rev);
 		info->window = window;
 		info->builder = builder;
+		info->dialog = widget;
 
 		g_signal_connect (widget,
 		                  "response",
@@ -3586,11 +4596,12 @@ on_revision_tag_activate (GtkAction  *action,
 		gtk_tree_model_get_iter (model, &iter, (GtkTreePath *)rows->data);
 		gtk_tree_model_get (model, &iter, 0, &rev, -1);
 
-		TagInfo *info = g_slice_new (TagInfo);
+		TagInfo *info = g_slice_new0 (TagInfo);
 
 		info->revision = gitg_revision_ref (rev);
 		info->window = window;
 		info->builder = builder;
+		info->dialog = widget;
 
 		g_signal_connect (widget,
 		                  "response",
@@ -32,6 +32,7 @@ struct _GitgCommandPrivate
 	gchar **arguments;
 	gchar **environment;
 	GFile *working_directory;
+	gboolean merge_error;
 };
 
 G_DEFINE_TYPE (GitgCommand, gitg_command, G_TYPE_INITIALLY_UNOWNED)
@@ -42,7 +43,8 @@ enum
 	PROP_REPOSITORY,
 	PROP_ARGUMENTS,
 	PROP_ENVIRONMENT,
-	PROP_WORKING_DIRECTORY
+	PROP_WORKING_DIRECTORY,
+	PROP_MERGE_ERROR
 };
 
 static void
@@ -99,6 +101,10 @@ gitg_command_set_property (GObject      *object,
 			gitg_command_set_working_directory (self,
 			                                    g_value_get_object (value));
 			break;
+		case PROP_MERGE_ERROR:
+			gitg_command_set_merge_error (self,
+			                              g_value_get_boolean (value));
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -127,6 +133,9 @@ gitg_command_get_property (GObject    *object,
 		case PROP_WORKING_DIRECTORY:
 			g_value_take_object (value, gitg_command_get_working_directory (self));
 			break;
+		case PROP_MERGE_ERROR:
+			g_value_set_boolean (value, self->priv->merge_error);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -177,6 +186,14 @@ gitg_command_class_init (GitgCommandClass *klass)
 	                                                      "Working directory",
 	                                                      G_TYPE_FILE,
 	                                                      G_PARAM_READWRITE));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_MERGE_ERROR,
+	                                 g_param_spec_boolean ("merge-error",
+	                                                       "Merge Error",
+	                                                       "Merge standard error into the output",
+	                                                       FALSE,
+	                                                       G_PARAM_READWRITE));
 }
 
 static void
@@ -511,3 +528,21 @@ gitg_command_get_working_directory (GitgCommand *command)
 
 	return NULL;
 }
+
+void
+gitg_command_set_merge_error (GitgCommand *command,
+                              gboolean     merge_error)
+{
+	g_return_if_fail (GITG_IS_COMMAND (command));
+
+	command->priv->merge_error = merge_error;
+	g_object_notify (G_OBJECT (command), "merge-error");
+}
+
+gboolean
+gitg_command_get_merge_error (GitgCommand *command)
+{
+	g_return_val_if_fail (GITG_IS_COMMAND (command), FALSE);
+
+	return command->priv->merge_error;
+}
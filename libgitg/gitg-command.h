@@ -93,6 +93,10 @@ void                 gitg_command_add_environmentv      (GitgCommand         *co
 
 gchar const * const *gitg_command_get_environment       (GitgCommand         *command);
 
+void                 gitg_command_set_merge_error       (GitgCommand         *command,
+                                                         gboolean             merge_error);
+gboolean             gitg_command_get_merge_error       (GitgCommand         *command);
+
 G_END_DECLS
 
 #endif /* __GITG_COMMAND_H__ */
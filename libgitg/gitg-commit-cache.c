@@ -0,0 +1,275 @@
+/*
+ * gitg-commit-cache.c
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "gitg-commit-cache.h"
+
+#include <string.h>
+
+/* Number of outputs and total amount of memory kept around */
+#define COMMIT_CACHE_SIZE 256
+#define COMMIT_CACHE_BYTES (16 * 1024 * 1024)
+
+typedef struct
+{
+	gchar **lines;
+	gsize size;
+	GList *link;
+} CacheEntry;
+
+struct _GitgCommitCache
+{
+	GHashTable *entries;
+
+	/* Keys of the entries, most recently used at the head */
+	GQueue *lru;
+	gsize size;
+};
+
+static gchar *
+cache_key (GitgCommitCacheKind  kind,
+           gchar const         *sha,
+           gchar const         *path)
+{
+	return g_strdup_printf ("%d:%s:%s", kind, sha, path ? path : "");
+}
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+	g_strfreev (entry->lines);
+	g_slice_free (CacheEntry, entry);
+}
+
+static void
+free_lines (GPtrArray *lines)
+{
+	g_ptr_array_foreach (lines, (GFunc)g_free, NULL);
+	g_ptr_array_free (lines, TRUE);
+}
+
+GitgCommitCache *
+gitg_commit_cache_new (void)
+{
+	GitgCommitCache *cache = g_slice_new0 (GitgCommitCache);
+
+	cache->entries = g_hash_table_new_full (g_str_hash,
+	                                        g_str_equal,
+	                                        g_free,
+	                                        (GDestroyNotify)cache_entry_free);
+
+	cache->lru = g_queue_new ();
+
+	return cache;
+}
+
+void
+gitg_commit_cache_free (GitgCommitCache *cache)
+{
+	if (!cache)
+	{
+		return;
+	}
+
+	g_hash_table_destroy (cache->entries);
+	g_queue_free (cache->lru);
+
+	g_slice_free (GitgCommitCache, cache);
+}
+
+gboolean
+gitg_commit_cache_can_cache (GitgRevision *revision)
+{
+	gchar sign;
+
+	if (!revision)
+	{
+		return FALSE;
+	}
+
+	/* The staged and unstaged rows change with the working tree */
+	sign = gitg_revision_get_sign (revision);
+	return sign != 't' && sign != 'u';
+}
+
+GitgCommand *
+gitg_commit_cache_command_new (GitgRepository      *repository,
+                               GitgCommitCacheKind  kind,
+                               gchar const         *sha,
+                               gchar const         *path)
+{
+	GitgCommand *command = NULL;
+	gchar *id;
+
+	switch (kind)
+	{
+		case GITG_COMMIT_CACHE_DETAILS:
+			command = gitg_command_new (repository,
+			                            "show",
+			                            "--numstat",
+			                            "--pretty=format:%s%n%n%b%n\x01",
+			                            sha,
+			                            NULL);
+		break;
+		case GITG_COMMIT_CACHE_DIFF_FILES:
+			command = gitg_command_new (repository,
+			                            "show",
+			                            "--encoding=UTF-8",
+			                            "--raw",
+			                            "--numstat",
+			                            "-M",
+			                            "--pretty=format:",
+			                            "--abbrev=40",
+			                            sha,
+			                            NULL);
+		break;
+		case GITG_COMMIT_CACHE_DIFF:
+			command = gitg_command_new (repository,
+			                            "show",
+			                            "-M",
+			                            "--pretty=format:",
+			                            "--encoding=UTF-8",
+			                            "--no-color",
+			                            sha,
+			                            NULL);
+		break;
+		case GITG_COMMIT_CACHE_TREE:
+			/* Needs a NUL separated shell */
+			id = g_strconcat (sha, ":", path, NULL);
+			command = gitg_command_new (repository,
+			                            "ls-tree",
+			                            "-z",
+			                            "-l",
+			                            id,
+			                            NULL);
+			g_free (id);
+		break;
+		default:
+			g_return_val_if_reached (NULL);
+	}
+
+	return command;
+}
+
+gchar **
+gitg_commit_cache_lookup (GitgCommitCache     *cache,
+                          GitgCommitCacheKind  kind,
+                          gchar const         *sha,
+                          gchar const         *path)
+{
+	CacheEntry *entry;
+	gchar *key;
+
+	g_return_val_if_fail (cache != NULL, NULL);
+
+	key = cache_key (kind, sha, path);
+	entry = g_hash_table_lookup (cache->entries, key);
+	g_free (key);
+
+	if (!entry)
+	{
+		return NULL;
+	}
+
+	g_queue_unlink (cache->lru, entry->link);
+	g_queue_push_head_link (cache->lru, entry->link);
+
+	return entry->lines;
+}
+
+gboolean
+gitg_commit_cache_contains (GitgCommitCache     *cache,
+                            GitgCommitCacheKind  kind,
+                            gchar const         *sha,
+                            gchar const         *path)
+{
+	gchar *key;
+	gboolean ret;
+
+	g_return_val_if_fail (cache != NULL, FALSE);
+
+	/* Unlike lookup, this does not count as a use of the entry */
+	key = cache_key (kind, sha, path);
+	ret = g_hash_table_lookup (cache->entries, key) != NULL;
+	g_free (key);
+
+	return ret;
+}
+
+void
+gitg_commit_cache_store (GitgCommitCache     *cache,
+                         GitgCommitCacheKind  kind,
+                         gchar const         *sha,
+                         gchar const         *path,
+                         GPtrArray           *lines)
+{
+	CacheEntry *entry;
+	gchar *key;
+	guint i;
+
+	g_return_if_fail (cache != NULL);
+
+	if (lines->len > GITG_COMMIT_CACHE_MAX_LINES)
+	{
+		free_lines (lines);
+		return;
+	}
+
+	key = cache_key (kind, sha, path);
+	entry = g_hash_table_lookup (cache->entries, key);
+
+	if (entry)
+	{
+		cache->size -= entry->size;
+
+		g_queue_delete_link (cache->lru, entry->link);
+		g_hash_table_remove (cache->entries, key);
+	}
+
+	entry = g_slice_new (CacheEntry);
+	entry->size = sizeof (CacheEntry) + (lines->len + 1) * sizeof (gchar *);
+
+	for (i = 0; i < lines->len; ++i)
+	{
+		entry->size += strlen (g_ptr_array_index (lines, i)) + 1;
+	}
+
+	g_ptr_array_add (lines, NULL);
+	entry->lines = (gchar **)g_ptr_array_free (lines, FALSE);
+
+	g_queue_push_head (cache->lru, key);
+	entry->link = cache->lru->head;
+
+	g_hash_table_insert (cache->entries, key, entry);
+	cache->size += entry->size;
+
+	while (g_queue_get_length (cache->lru) > COMMIT_CACHE_SIZE ||
+	       (cache->size > COMMIT_CACHE_BYTES &&
+	        g_queue_get_length (cache->lru) > 1))
+	{
+		gchar *old = g_queue_pop_tail (cache->lru);
+
+		entry = g_hash_table_lookup (cache->entries, old);
+		cache->size -= entry->size;
+
+		g_hash_table_remove (cache->entries, old);
+	}
+}
@@ -0,0 +1,75 @@
+/*
+ * gitg-commit-cache.h
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GITG_COMMIT_CACHE_H__
+#define __GITG_COMMIT_CACHE_H__
+
+#include <libgitg/gitg-repository.h>
+#include <libgitg/gitg-revision.h>
+#include <libgitg/gitg-command.h>
+
+G_BEGIN_DECLS
+
+/* Outputs longer than this are not kept, the panels spool or load them
+   lazily anyway */
+#define GITG_COMMIT_CACHE_MAX_LINES 5000
+
+typedef enum
+{
+	GITG_COMMIT_CACHE_DETAILS,	/* message body and numstat */
+	GITG_COMMIT_CACHE_DIFF_FILES,	/* raw diff-tree and numstat */
+	GITG_COMMIT_CACHE_DIFF,
+	GITG_COMMIT_CACHE_TREE,		/* ls-tree -z -l of a directory in the tree */
+	GITG_COMMIT_CACHE_NUM
+} GitgCommitCacheKind;
+
+typedef struct _GitgCommitCache GitgCommitCache;
+
+GitgCommitCache *gitg_commit_cache_new         (void);
+void             gitg_commit_cache_free        (GitgCommitCache     *cache);
+
+gboolean         gitg_commit_cache_can_cache   (GitgRevision        *revision);
+
+GitgCommand     *gitg_commit_cache_command_new (GitgRepository      *repository,
+                                                GitgCommitCacheKind  kind,
+                                                gchar const         *sha,
+                                                gchar const         *path);
+
+gchar          **gitg_commit_cache_lookup      (GitgCommitCache     *cache,
+                                                GitgCommitCacheKind  kind,
+                                                gchar const         *sha,
+                                                gchar const         *path);
+
+gboolean         gitg_commit_cache_contains    (GitgCommitCache     *cache,
+                                                GitgCommitCacheKind  kind,
+                                                gchar const         *sha,
+                                                gchar const         *path);
+
+void             gitg_commit_cache_store       (GitgCommitCache     *cache,
+                                                GitgCommitCacheKind  kind,
+                                                gchar const         *sha,
+                                                gchar const         *path,
+                                                GPtrArray           *lines);
+
+G_END_DECLS
+
+#endif /* __GITG_COMMIT_CACHE_H__ */
@@ -24,6 +24,7 @@
 #include "gitg-shell.h"
 #include "gitg-changed-file.h"
 #include "gitg-config.h"
+#include "gitg-enum-types.h"
 
 #include <string.h>
 
@@ -43,9 +44,23 @@ enum
 {
 	INSERTED,
 	REMOVED,
+	COMMIT_PROGRESS,
+	COMMITTED,
 	LAST_SIGNAL
 };
 
+typedef struct
+{
+	gchar *comment;
+	gchar *subject;
+	gchar *output;
+	gchar *sha;
+	gchar *revision;
+
+	gboolean amend;
+	GitgCommitStage stage;
+} CommitData;
+
 struct _GitgCommitPrivate
 {
 	GitgRepository *repository;
@@ -55,6 +70,9 @@ struct _GitgCommitPrivate
 	guint end_id;
 
 	GHashTable *files;
+
+	GitgShell *commit_shell;
+	CommitData *commit_data;
 };
 
 static guint commit_signals[LAST_SIGNAL] = { 0 };
@@ -62,6 +80,8 @@ static guint commit_signals[LAST_SIGNAL] = { 0 };
 G_DEFINE_TYPE (GitgCommit, gitg_commit, G_TYPE_OBJECT)
 
 static void on_changed_file_changed (GitgChangedFile *file, GitgCommit *commit);
+static void on_commit_shell_update (GitgShell *shell, gchar **buffer, GitgCommit *commit);
+static void on_commit_shell_end (GitgShell *shell, GError *error, GitgCommit *commit);
 
 GQuark
 gitg_commit_error_quark ()
@@ -94,6 +114,18 @@ shell_cancel (GitgCommit *commit)
 	gitg_io_cancel (GITG_IO (commit->priv->shell));
 }
 
+static void
+commit_data_free (CommitData *data)
+{
+	g_free (data->comment);
+	g_free (data->subject);
+	g_free (data->output);
+	g_free (data->sha);
+	g_free (data->revision);
+
+	g_slice_free (CommitData, data);
+}
+
 static void
 gitg_commit_finalize (GObject *object)
 {
@@ -102,6 +134,15 @@ gitg_commit_finalize (GObject *object)
 	shell_cancel (commit);
 	g_object_unref (commit->priv->shell);
 
+	if (commit->priv->commit_data)
+	{
+		commit_data_free (commit->priv->commit_data);
+		commit->priv->commit_data = NULL;
+	}
+
+	gitg_io_cancel (GITG_IO (commit->priv->commit_shell));
+	g_object_unref (commit->priv->commit_shell);
+
 	g_hash_table_destroy (commit->priv->files);
 
 	G_OBJECT_CLASS (gitg_commit_parent_class)->finalize (object);
@@ -218,6 +259,32 @@ gitg_commit_class_init (GitgCommitClass *klass)
 		              1,
 		              GITG_TYPE_CHANGED_FILE);
 
+	commit_signals[COMMIT_PROGRESS] =
+		g_signal_new ("commit-progress",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_LAST,
+		              G_STRUCT_OFFSET (GitgCommitClass,
+		              commit_progress),
+		              NULL,
+		              NULL,
+		              g_cclosure_marshal_VOID__ENUM,
+		              G_TYPE_NONE,
+		              1,
+		              GITG_TYPE_COMMIT_STAGE);
+
+	commit_signals[COMMITTED] =
+		g_signal_new ("committed",
+		              G_OBJECT_CLASS_TYPE (object_class),
+		              G_SIGNAL_RUN_LAST,
+		              G_STRUCT_OFFSET (GitgCommitClass,
+		              committed),
+		              NULL,
+		              NULL,
+		              g_cclosure_marshal_VOID__BOXED,
+		              G_TYPE_NONE,
+		              1,
+		              G_TYPE_ERROR);
+
 	g_type_class_add_private (object_class, sizeof (GitgCommitPrivate));
 }
 
@@ -231,6 +298,18 @@ gitg_commit_init (GitgCommit *self)
 	                                           (GEqualFunc)g_file_equal,
 	                                           (GDestroyNotify)g_object_unref,
 	                                           (GDestroyNotify)g_object_unref);
+
+	self->priv->commit_shell = gitg_shell_new (1000);
+
+	g_signal_connect (self->priv->commit_shell,
+	                  "update",
+	                  G_CALLBACK (on_commit_shell_update),
+	                  self);
+
+	g_signal_connect (self->priv->commit_shell,
+	                  "end",
+	                  G_CALLBACK (on_commit_shell_end),
+	                  self);
 }
 
 GitgCommit *
@@ -1044,41 +1123,47 @@ convert_commit_encoding (GitgCommit  *commit,
 	return ret;
 }
 
-static gboolean
-commit_tree (GitgCommit   *commit,
-             gchar const  *tree,
-             gchar const  *comment,
-             gboolean      signoff,
-             gboolean      amend,
-             gchar       **ref,
-             GError      **error)
+static gchar *
+build_full_comment (GitgCommit   *commit,
+                    gchar const  *comment,
+                    gboolean      signoff,
+                    GError      **error)
 {
-	gchar *fullcomment;
+	gchar *line;
+	gchar *ret;
 
-	if (signoff)
+	if (!signoff)
 	{
-		gchar *line = get_signed_off_line (commit);
+		return g_strdup (comment);
+	}
 
-		if (!line)
-		{
-			if (error)
-			{
-				g_set_error (error,
-				             GITG_COMMIT_ERROR,
-				             GITG_COMMIT_ERROR_SIGNOFF,
-				             "Could not retrieve user name or email for signoff message");
-			}
+	line = get_signed_off_line (commit);
 
-			return FALSE;
+	if (!line)
+	{
+		if (error)
+		{
+			g_set_error (error,
+			             GITG_COMMIT_ERROR,
+			             GITG_COMMIT_ERROR_SIGNOFF,
+			             "Could not retrieve user name or email for signoff message");
 		}
 
-		fullcomment = g_strconcat (comment, "\n\n", line, NULL);
-	}
-	else
-	{
-		fullcomment = g_strdup (comment);
+		return NULL;
 	}
 
+	ret = g_strconcat (comment, "\n\n", line, NULL);
+	g_free (line);
+
+	return ret;
+}
+
+static GitgCommand *
+build_commit_tree_command (GitgCommit  *commit,
+                           gchar const *tree,
+                           gboolean     amend)
+{
+	GitgCommand *command;
 	gchar *head;
 
 	if (amend)
@@ -1092,21 +1177,45 @@ commit_tree (GitgCommit   *commit,
 		                                  "HEAD");
 	}
 
-	GitgCommand *command;
-	gchar **buffer;
-
 	command = gitg_command_new (commit->priv->repository,
-	                             "commit-tree",
-	                             tree,
-	                             head ? "-p" : NULL,
-	                             head,
-	                             NULL);
+	                            "commit-tree",
+	                            tree,
+	                            head ? "-p" : NULL,
+	                            head,
+	                            NULL);
 
 	if (amend)
 	{
 		set_amend_environment (commit, command);
 	}
 
+	g_free (head);
+	return command;
+}
+
+static gboolean
+commit_tree (GitgCommit   *commit,
+             gchar const  *tree,
+             gchar const  *comment,
+             gboolean      signoff,
+             gboolean      amend,
+             gchar       **ref,
+             GError      **error)
+{
+	gchar *fullcomment;
+
+	fullcomment = build_full_comment (commit, comment, signoff, error);
+
+	if (!fullcomment)
+	{
+		return FALSE;
+	}
+
+	GitgCommand *command;
+	gchar **buffer;
+
+	command = build_commit_tree_command (commit, tree, amend);
+
 	gchar *converted = convert_commit_encoding (commit, fullcomment);
 
 	buffer = gitg_shell_run_sync_with_input_and_output (command,
@@ -1114,7 +1223,6 @@ commit_tree (GitgCommit   *commit,
 	                                                    converted,
 	                                                    error);
 
-	g_free (head);
 	g_free (fullcomment);
 	g_free (converted);
 	g_object_unref (command);
@@ -1131,25 +1239,66 @@ commit_tree (GitgCommit   *commit,
 	return TRUE;
 }
 
+static GitgCommand *
+build_update_ref_command (GitgCommit  *commit,
+                          gchar const *ref,
+                          gchar const *subject)
+{
+	GitgCommand *command;
+	gchar *converted = convert_commit_encoding (commit, subject);
+
+	command = gitg_command_new (commit->priv->repository,
+	                            "update-ref",
+	                            "-m",
+	                            converted,
+	                            "HEAD",
+	                            ref,
+	                            NULL);
+
+	g_free (converted);
+	return command;
+}
+
 static gboolean
 update_ref (GitgCommit   *commit,
             gchar const  *ref,
             gchar const  *subject,
             GError      **error)
 {
-	gchar *converted = convert_commit_encoding (commit, subject);
+	return gitg_shell_run_sync (build_update_ref_command (commit, ref, subject),
+	                            error);
+}
 
-	gboolean ret = gitg_shell_run_sync (gitg_command_new (commit->priv->repository,
-	                                                       "update-ref",
-	                                                       "-m",
-	                                                       converted,
-	                                                       "HEAD",
-	                                                       ref,
-	                                                       NULL),
-	                                    error);
-	g_free (converted);
+static void
+write_commit_editmsg (GitgCommit  *commit,
+                      gchar const *comment)
+{
+	GFile *git_dir = gitg_repository_get_git_dir (commit->priv->repository);
+	GFile *child = g_file_get_child (git_dir, "COMMIT_EDITMSG");
+	gchar *path = g_file_get_path (child);
 
-	return ret;
+	g_object_unref (git_dir);
+	g_object_unref (child);
+
+	g_file_set_contents (path, comment, -1, NULL);
+	g_free (path);
+}
+
+static void
+update_history (GitgCommit  *commit,
+                gchar const *revision)
+{
+	/* Try to insert the new commit into the already loaded history
+	   instead of reloading the complete log */
+	if (revision &&
+	    gitg_repository_update_head (commit->priv->repository, revision))
+	{
+		gitg_commit_refresh (commit);
+	}
+	else
+	{
+		gitg_repository_reload (commit->priv->repository);
+	}
 }
 
 gboolean
@@ -1168,15 +1317,7 @@ gitg_commit_commit (GitgCommit   *commit,
 		return FALSE;
 	}
 
-	GFile *git_dir = gitg_repository_get_git_dir (commit->priv->repository);
-	GFile *child = g_file_get_child (git_dir, "COMMIT_EDITMSG");
-	gchar *path = g_file_get_path (child);
-
-	g_object_unref (git_dir);
-	g_object_unref (child);
-
-	g_file_set_contents (path, comment, -1, NULL);\
-	g_free (path);
+	write_commit_editmsg (commit, comment);
 
 	gchar *ref;
 	gboolean ret = commit_tree (commit, tree, comment, signoff, amend, &ref, error);
@@ -1191,15 +1332,293 @@ gitg_commit_commit (GitgCommit   *commit,
 	ret = update_ref (commit, ref, subject, error);
 	g_free (subject);
 
-	if (!ret)
+	if (ret)
 	{
+		GitgCommand *command = NULL;
+		gchar **revision = NULL;
+
+		if (!amend)
+		{
+			command = gitg_repository_update_head_command (commit->priv->repository,
+			                                               ref);
+		}
+
+		if (command)
+		{
+			revision = gitg_shell_run_sync_with_output (command, FALSE, NULL);
+		}
+
+		update_history (commit, revision ? *revision : NULL);
+		g_strfreev (revision);
+	}
+
+	g_free (ref);
+	return ret;
+}
+
+static void
+commit_async_progress (GitgCommit      *commit,
+                       GitgCommitStage  stage)
+{
+	commit->priv->commit_data->stage = stage;
+	g_signal_emit (commit, commit_signals[COMMIT_PROGRESS], 0, stage);
+}
+
+static void
+commit_async_done (GitgCommit *commit,
+                   GError     *error)
+{
+	CommitData *data = commit->priv->commit_data;
+
+	if (!error)
+	{
+		if (data->stage != GITG_COMMIT_STAGE_UPDATE_HISTORY)
+		{
+			commit_async_progress (commit, GITG_COMMIT_STAGE_UPDATE_HISTORY);
+		}
+
+		update_history (commit, data->revision);
+	}
+
+	commit->priv->commit_data = NULL;
+	g_signal_emit (commit, commit_signals[COMMITTED], 0, error);
+
+	commit_data_free (data);
+}
+
+static void
+commit_async_failed (GitgCommit  *commit,
+                     gchar const *message)
+{
+	GError *error;
+
+	error = g_error_new_literal (GITG_COMMIT_ERROR,
+	                             GITG_COMMIT_ERROR_FAILED,
+	                             message);
+
+	commit_async_done (commit, error);
+	g_error_free (error);
+}
+
+static void
+commit_async_run (GitgCommit  *commit,
+                  GitgCommand *command,
+                  gchar const *input)
+{
+	GitgShell *shell = commit->priv->commit_shell;
+	GInputStream *stream = NULL;
+
+	if (input)
+	{
+		stream = g_memory_input_stream_new_from_data (g_strdup (input),
+		                                              -1,
+		                                              (GDestroyNotify)g_free);
+	}
+
+	/* The shell is shared by all steps, clear the input of the previous
+	   step when there is none */
+	gitg_io_set_input (GITG_IO (shell), stream);
+
+	if (stream)
+	{
+		g_object_unref (stream);
+	}
+
+	/* When spawning fails, the shell normally already ended with the
+	   error, which is handled in on_commit_shell_end */
+	if (!gitg_shell_run (shell, command, NULL) && commit->priv->commit_data)
+	{
+		if (commit->priv->commit_data->stage == GITG_COMMIT_STAGE_UPDATE_HISTORY)
+		{
+			commit_async_done (commit, NULL);
+		}
+		else
+		{
+			commit_async_failed (commit, "Could not run git");
+		}
+	}
+}
+
+static void
+commit_async_next (GitgCommit *commit,
+                   gchar      *output)
+{
+	CommitData *data = commit->priv->commit_data;
+	GitgCommand *command = NULL;
+	gchar *input = NULL;
+
+	switch (data->stage)
+	{
+		case GITG_COMMIT_STAGE_WRITE_TREE:
+			if (!output || strlen (output) != GITG_HASH_SHA_SIZE)
+			{
+				commit_async_failed (commit, "Could not write the index to a tree");
+				return;
+			}
+
+			commit_async_progress (commit, GITG_COMMIT_STAGE_COMMIT_TREE);
+
+			command = build_commit_tree_command (commit, output, data->amend);
+			input = convert_commit_encoding (commit, data->comment);
+		break;
+		case GITG_COMMIT_STAGE_COMMIT_TREE:
+			if (!output || strlen (output) != GITG_HASH_SHA_SIZE)
+			{
+				commit_async_failed (commit, "Could not create the commit object");
+				return;
+			}
+
+			data->sha = g_strdup (output);
+			commit_async_progress (commit, GITG_COMMIT_STAGE_UPDATE_REF);
+
+			command = build_update_ref_command (commit, data->sha, data->subject);
+		break;
+		case GITG_COMMIT_STAGE_UPDATE_REF:
+			/* Describe the new commit for the history, amends always
+			   need a reload anyway */
+			if (!data->amend)
+			{
+				command = gitg_repository_update_head_command (commit->priv->repository,
+				                                               data->sha);
+			}
+
+			if (!command)
+			{
+				commit_async_done (commit, NULL);
+				return;
+			}
+
+			commit_async_progress (commit, GITG_COMMIT_STAGE_UPDATE_HISTORY);
+		break;
+		case GITG_COMMIT_STAGE_UPDATE_HISTORY:
+			data->revision = output ? g_strdup (output) : NULL;
+			commit_async_done (commit, NULL);
+			return;
+		default:
+			g_assert_not_reached ();
+		break;
+	}
+
+	commit_async_run (commit, command, input);
+	g_free (input);
+}
+
+static void
+on_commit_shell_update (GitgShell   *shell,
+                        gchar      **buffer,
+                        GitgCommit  *commit)
+{
+	CommitData *data = commit->priv->commit_data;
+
+	/* All the commands in the commit chain output a single line */
+	if (data && !data->output && buffer && *buffer)
+	{
+		data->output = g_strdup (*buffer);
+	}
+}
+
+static void
+on_commit_shell_end (GitgShell  *shell,
+                     GError     *error,
+                     GitgCommit *commit)
+{
+	CommitData *data = commit->priv->commit_data;
+	gchar *output;
+
+	if (!data)
+	{
+		return;
+	}
+
+	output = data->output;
+	data->output = NULL;
+
+	if (data->stage == GITG_COMMIT_STAGE_UPDATE_HISTORY &&
+	    (error ||
+	     gitg_io_get_cancelled (GITG_IO (shell)) ||
+	     gitg_io_get_exit_status (GITG_IO (shell)) != 0))
+	{
+		/* The commit itself is done, the history is simply reloaded */
+		commit_async_done (commit, NULL);
+	}
+	else if (error)
+	{
+		commit_async_done (commit, error);
+	}
+	else if (gitg_io_get_cancelled (GITG_IO (shell)))
+	{
+		commit_async_failed (commit, "The commit was cancelled");
+	}
+	else if (gitg_io_get_exit_status (GITG_IO (shell)) != 0)
+	{
+		commit_async_failed (commit, "Git exited with an error while committing");
+	}
+	else
+	{
+		commit_async_next (commit, output);
+	}
+
+	g_free (output);
+}
+
+gboolean
+gitg_commit_commit_async (GitgCommit   *commit,
+                          gchar const  *comment,
+                          gboolean      signoff,
+                          gboolean      amend,
+                          GError      **error)
+{
+	CommitData *data;
+	gchar *fullcomment;
+
+	g_return_val_if_fail (GITG_IS_COMMIT (commit), FALSE);
+	g_return_val_if_fail (comment != NULL, FALSE);
+
+	if (commit->priv->commit_data)
+	{
+		g_set_error (error,
+		             GITG_COMMIT_ERROR,
+		             GITG_COMMIT_ERROR_BUSY,
+		             "A commit is already in progress");
+
 		return FALSE;
 	}
 
-	gitg_repository_reload (commit->priv->repository);
+	fullcomment = build_full_comment (commit, comment, signoff, error);
+
+	if (!fullcomment)
+	{
+		return FALSE;
+	}
+
+	write_commit_editmsg (commit, comment);
+
+	data = g_slice_new0 (CommitData);
+
+	data->comment = fullcomment;
+	data->subject = comment_parse_subject (comment);
+	data->amend = amend;
+
+	commit->priv->commit_data = data;
+	commit_async_progress (commit, GITG_COMMIT_STAGE_WRITE_TREE);
+
+	commit_async_run (commit,
+	                  gitg_command_new (commit->priv->repository,
+	                                    "write-tree",
+	                                    NULL),
+	                  NULL);
+
 	return TRUE;
 }
 
+gboolean
+gitg_commit_get_committing (GitgCommit *commit)
+{
+	g_return_val_if_fail (GITG_IS_COMMIT (commit), FALSE);
+
+	return commit->priv->commit_data != NULL;
+}
+
 static void
 remove_file (GitgCommit      *commit,
              GitgChangedFile *file)
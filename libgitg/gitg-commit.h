@@ -47,9 +47,20 @@ typedef enum
 {
 	GITG_COMMIT_ERROR_NONE = 0,
 	GITG_COMMIT_ERROR_SIGNOFF,
-	GITG_COMMIT_ERROR_MERGE
+	GITG_COMMIT_ERROR_MERGE,
+	GITG_COMMIT_ERROR_BUSY,
+	GITG_COMMIT_ERROR_FAILED
 } GitgCommitError;
 
+typedef enum
+{
+	GITG_COMMIT_STAGE_NONE = 0,
+	GITG_COMMIT_STAGE_WRITE_TREE,
+	GITG_COMMIT_STAGE_COMMIT_TREE,
+	GITG_COMMIT_STAGE_UPDATE_REF,
+	GITG_COMMIT_STAGE_UPDATE_HISTORY
+} GitgCommitStage;
+
 struct _GitgCommit {
 	GObject parent;
 
@@ -61,6 +72,9 @@ struct _GitgCommitClass {
 
 	void (*inserted) (GitgCommit *commit, GitgChangedFile *file);
 	void (*removed) (GitgCommit *commit, GitgChangedFile *file);
+
+	void (*commit_progress) (GitgCommit *commit, GitgCommitStage stage);
+	void (*committed) (GitgCommit *commit, GError *error);
 };
 
 GQuark           gitg_commit_error_quark       (void);
@@ -84,6 +98,13 @@ gboolean         gitg_commit_commit            (GitgCommit       *commit,
                                                 gboolean          amend,
                                                 GError          **error);
 
+gboolean         gitg_commit_commit_async      (GitgCommit       *commit,
+                                                gchar const      *comment,
+                                                gboolean          signoff,
+                                                gboolean          amend,
+                                                GError          **error);
+gboolean         gitg_commit_get_committing    (GitgCommit       *commit);
+
 gboolean         gitg_commit_revert            (GitgCommit       *commit,
                                                 GitgRevision     *from,
                                                 GitgRevision     *to,
@@ -0,0 +1,575 @@
+/*
+ * gitg-config-file.c
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "gitg-config-file.h"
+
+#include <glib/gstdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <string.h>
+
+/* Maximum depth of include.path directives, like git itself */
+#define MAX_INCLUDE_DEPTH 10
+
+/* A config file parsed into its entries, in file order. Included files
+   are expanded in place. The file is parsed again when the stamp of
+   any of the files it was read from changed. */
+struct _GitgConfigFile
+{
+	GPtrArray *keys;
+	GPtrArray *values;
+
+	GSList *stamps;
+};
+
+typedef struct
+{
+	gchar *path;
+	gboolean exists;
+	ino_t ino;
+	off_t size;
+	time_t mtime;
+} FileStamp;
+
+static GHashTable *config_files = NULL;
+
+static void
+file_stamp_free (FileStamp *stamp)
+{
+	g_free (stamp->path);
+	g_slice_free (FileStamp, stamp);
+}
+
+static void
+file_stamp_read (FileStamp   *stamp,
+                 gchar const *path)
+{
+	struct stat buf;
+
+	stamp->exists = g_stat (path, &buf) == 0;
+
+	if (stamp->exists)
+	{
+		stamp->ino = buf.st_ino;
+		stamp->size = buf.st_size;
+		stamp->mtime = buf.st_mtime;
+	}
+}
+
+static gboolean
+file_stamp_valid (FileStamp *stamp)
+{
+	FileStamp current = {0,};
+
+	file_stamp_read (&current, stamp->path);
+
+	if (current.exists != stamp->exists)
+	{
+		return FALSE;
+	}
+
+	return !current.exists ||
+	       (current.ino == stamp->ino &&
+	        current.size == stamp->size &&
+	        current.mtime == stamp->mtime);
+}
+
+static void
+config_file_free (GitgConfigFile *file)
+{
+	g_ptr_array_foreach (file->keys, (GFunc)g_free, NULL);
+	g_ptr_array_free (file->keys, TRUE);
+
+	g_ptr_array_foreach (file->values, (GFunc)g_free, NULL);
+	g_ptr_array_free (file->values, TRUE);
+
+	g_slist_foreach (file->stamps, (GFunc)file_stamp_free, NULL);
+	g_slist_free (file->stamps);
+
+	g_slice_free (GitgConfigFile, file);
+}
+
+/* Section and variable names are case insensitive, subsections are not */
+static gchar *
+normalize_key (gchar const *key)
+{
+	gchar const *first = strchr (key, '.');
+	gchar const *last = strrchr (key, '.');
+	gchar *ret = g_strdup (key);
+	gchar *ptr;
+
+	if (!first)
+	{
+		return g_ascii_strdown (key, -1);
+	}
+
+	for (ptr = ret; ptr < ret + (first - key); ++ptr)
+	{
+		*ptr = g_ascii_tolower (*ptr);
+	}
+
+	for (ptr = ret + (last - key); *ptr; ++ptr)
+	{
+		*ptr = g_ascii_tolower (*ptr);
+	}
+
+	return ret;
+}
+
+typedef struct
+{
+	gchar const *ptr;
+	gchar const *end;
+} Parser;
+
+static gint
+parser_next (Parser *parser)
+{
+	if (parser->ptr >= parser->end)
+	{
+		return -1;
+	}
+
+	gint c = (guchar)*parser->ptr++;
+
+	/* Treat \r\n as a single newline */
+	if (c == '\r' && parser->ptr < parser->end && *parser->ptr == '\n')
+	{
+		c = *parser->ptr++;
+	}
+
+	return c;
+}
+
+static gint
+parser_peek (Parser *parser)
+{
+	return parser->ptr < parser->end ? (guchar)*parser->ptr : -1;
+}
+
+static void
+parser_skip_line (Parser *parser)
+{
+	gint c;
+
+	while ((c = parser_next (parser)) != -1 && c != '\n')
+	{
+	}
+}
+
+static gchar *
+parse_value (Parser *parser)
+{
+	GString *value = g_string_new ("");
+	gboolean quote = FALSE;
+	gboolean comment = FALSE;
+	guint space = 0;
+	gint c;
+
+	while ((c = parser_next (parser)) != -1 && c != '\n')
+	{
+		if (comment)
+		{
+			continue;
+		}
+
+		if (g_ascii_isspace (c) && !quote)
+		{
+			/* Only whitespace inside the value is kept */
+			if (value->len > 0)
+			{
+				++space;
+			}
+
+			continue;
+		}
+
+		if (!quote && (c == ';' || c == '#'))
+		{
+			comment = TRUE;
+			continue;
+		}
+
+		for (; space > 0; --space)
+		{
+			g_string_append_c (value, ' ');
+		}
+
+		if (c == '\\')
+		{
+			c = parser_next (parser);
+
+			switch (c)
+			{
+				case '\n':
+					/* line continuation */
+					continue;
+				case 't':
+					c = '\t';
+				break;
+				case 'b':
+					c = '\b';
+				break;
+				case 'n':
+					c = '\n';
+				break;
+				case '\\':
+				case '"':
+				break;
+				default:
+					/* invalid escape, git refuses the file */
+					g_string_free (value, TRUE);
+					return NULL;
+			}
+
+			g_string_append_c (value, c);
+		}
+		else if (c == '"')
+		{
+			quote = !quote;
+		}
+		else
+		{
+			g_string_append_c (value, c);
+		}
+	}
+
+	return g_string_free (value, FALSE);
+}
+
+static gchar *
+parse_section (Parser *parser)
+{
+	GString *section = g_string_new ("");
+	gint c;
+
+	/* [section "subsection"] or the deprecated [section.subsection] */
+	while ((c = parser_next (parser)) != -1 && c != ']' && c != '\n')
+	{
+		if (g_ascii_isspace (c))
+		{
+			while ((c = parser_next (parser)) != -1 && g_ascii_isspace (c) && c != '\n')
+			{
+			}
+
+			if (c != '"')
+			{
+				break;
+			}
+
+			g_string_append_c (section, '.');
+
+			while ((c = parser_next (parser)) != -1 && c != '"' && c != '\n')
+			{
+				if (c == '\\')
+				{
+					c = parser_next (parser);
+				}
+
+				if (c != -1)
+				{
+					g_string_append_c (section, c);
+				}
+			}
+
+			if (c == '"')
+			{
+				c = parser_next (parser);
+			}
+
+			break;
+		}
+
+		g_string_append_c (section, g_ascii_tolower (c));
+	}
+
+	if (c != ']')
+	{
+		g_string_free (section, TRUE);
+		return NULL;
+	}
+
+	return g_string_free (section, FALSE);
+}
+
+static gchar *
+expand_include_path (gchar const *path,
+                     gchar const *from)
+{
+	if (g_str_has_prefix (path, "~/"))
+	{
+		return g_build_filename (g_get_home_dir (), path + 2, NULL);
+	}
+	else if (g_path_is_absolute (path))
+	{
+		return g_strdup (path);
+	}
+	else
+	{
+		gchar *dirname = g_path_get_dirname (from);
+		gchar *ret = g_build_filename (dirname, path, NULL);
+
+		g_free (dirname);
+		return ret;
+	}
+}
+
+static void
+parse_file (GitgConfigFile *file,
+            gchar const    *path,
+            gint            depth)
+{
+	FileStamp *stamp = g_slice_new0 (FileStamp);
+	gchar *contents;
+	gsize length;
+	gchar *section = NULL;
+	Parser parser;
+
+	stamp->path = g_strdup (path);
+	file_stamp_read (stamp, path);
+
+	file->stamps = g_slist_prepend (file->stamps, stamp);
+
+	if (!stamp->exists || !g_file_get_contents (path, &contents, &length, NULL))
+	{
+		return;
+	}
+
+	parser.ptr = contents;
+	parser.end = contents + length;
+
+	while (parser.ptr < parser.end)
+	{
+		gint c = parser_next (&parser);
+
+		if (g_ascii_isspace (c))
+		{
+			continue;
+		}
+
+		if (c == '#' || c == ';')
+		{
+			parser_skip_line (&parser);
+		}
+		else if (c == '[')
+		{
+			g_free (section);
+			section = parse_section (&parser);
+
+			if (!section)
+			{
+				break;
+			}
+		}
+		else if (g_ascii_isalpha (c) && section)
+		{
+			GString *name = g_string_new ("");
+			gchar *value = NULL;
+			gboolean has_value = FALSE;
+
+			g_string_append_c (name, g_ascii_tolower (c));
+
+			while (g_ascii_isalnum (parser_peek (&parser)) || parser_peek (&parser) == '-')
+			{
+				g_string_append_c (name, g_ascii_tolower (parser_next (&parser)));
+			}
+
+			while (parser_peek (&parser) == ' ' || parser_peek (&parser) == '\t')
+			{
+				parser_next (&parser);
+			}
+
+			if (parser_peek (&parser) == '=')
+			{
+				parser_next (&parser);
+				value = parse_value (&parser);
+				has_value = TRUE;
+			}
+			else
+			{
+				/* A name without value is a boolean true */
+				parser_skip_line (&parser);
+			}
+
+			if (has_value && !value)
+			{
+				g_string_free (name, TRUE);
+				break;
+			}
+
+			gchar *key = g_strconcat (section, ".", name->str, NULL);
+			g_string_free (name, TRUE);
+
+			g_ptr_array_add (file->keys, key);
+			g_ptr_array_add (file->values, value);
+
+			if (value && strcmp (key, "include.path") == 0 && depth < MAX_INCLUDE_DEPTH)
+			{
+				gchar *included = expand_include_path (value, path);
+
+				parse_file (file, included, depth + 1);
+				g_free (included);
+			}
+		}
+		else
+		{
+			parser_skip_line (&parser);
+		}
+	}
+
+	g_free (section);
+	g_free (contents);
+}
+
+static gboolean
+config_file_valid (GitgConfigFile *file)
+{
+	GSList *item;
+
+	for (item = file->stamps; item; item = g_slist_next (item))
+	{
+		if (!file_stamp_valid (item->data))
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Get the parsed contents of a config file. The result is owned by the
+   cache and stays valid until the next call for the same path */
+GitgConfigFile *
+gitg_config_file_get (gchar const *path)
+{
+	GitgConfigFile *file;
+
+	g_return_val_if_fail (path != NULL, NULL);
+
+	if (!config_files)
+	{
+		config_files = g_hash_table_new_full (g_str_hash,
+		                                      g_str_equal,
+		                                      g_free,
+		                                      (GDestroyNotify)config_file_free);
+	}
+
+	file = g_hash_table_lookup (config_files, path);
+
+	if (file && config_file_valid (file))
+	{
+		return file;
+	}
+
+	file = g_slice_new0 (GitgConfigFile);
+
+	file->keys = g_ptr_array_new ();
+	file->values = g_ptr_array_new ();
+
+	parse_file (file, path, 0);
+
+	g_hash_table_insert (config_files, g_strdup (path), file);
+	return file;
+}
+
+void
+gitg_config_file_invalidate (gchar const *path)
+{
+	if (config_files)
+	{
+		g_hash_table_remove (config_files, path);
+	}
+}
+
+/* Find the last value set for key, like git config --get. value is set
+   to NULL for a key without value */
+gboolean
+gitg_config_file_lookup (GitgConfigFile  *file,
+                         gchar const     *key,
+                         gchar const    **value)
+{
+	gchar *normalized;
+	gint i;
+
+	g_return_val_if_fail (file != NULL, FALSE);
+	g_return_val_if_fail (key != NULL, FALSE);
+
+	normalized = normalize_key (key);
+
+	for (i = file->keys->len - 1; i >= 0; --i)
+	{
+		if (strcmp (g_ptr_array_index (file->keys, i), normalized) == 0)
+		{
+			if (value)
+			{
+				*value = g_ptr_array_index (file->values, i);
+			}
+
+			g_free (normalized);
+			return TRUE;
+		}
+	}
+
+	g_free (normalized);
+	return FALSE;
+}
+
+/* Append "key value" lines for every entry matching the regexes, in the
+   format of git config --get-regexp */
+void
+gitg_config_file_match (GitgConfigFile *file,
+                        GRegex         *regex,
+                        GRegex         *value_regex,
+                        GString        *output)
+{
+	guint i;
+
+	g_return_if_fail (file != NULL);
+	g_return_if_fail (regex != NULL);
+	g_return_if_fail (output != NULL);
+
+	for (i = 0; i < file->keys->len; ++i)
+	{
+		gchar const *key = g_ptr_array_index (file->keys, i);
+		gchar const *value = g_ptr_array_index (file->values, i);
+
+		if (!g_regex_match (regex, key, 0, NULL))
+		{
+			continue;
+		}
+
+		if (value_regex && !g_regex_match (value_regex, value ? value : "", 0, NULL))
+		{
+			continue;
+		}
+
+		g_string_append (output, key);
+
+		if (value)
+		{
+			g_string_append_c (output, ' ');
+			g_string_append (output, value);
+		}
+
+		g_string_append_c (output, '\n');
+	}
+}
@@ -0,0 +1,46 @@
+/*
+ * gitg-config-file.h
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GITG_CONFIG_FILE_H__
+#define __GITG_CONFIG_FILE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GitgConfigFile GitgConfigFile;
+
+GitgConfigFile *gitg_config_file_get        (gchar const    *path);
+void            gitg_config_file_invalidate (gchar const    *path);
+
+gboolean        gitg_config_file_lookup     (GitgConfigFile *file,
+                                             gchar const    *key,
+                                             gchar const   **value);
+
+void            gitg_config_file_match      (GitgConfigFile *file,
+                                             GRegex         *regex,
+                                             GRegex         *value_regex,
+                                             GString        *output);
+
+G_END_DECLS
+
+#endif /* __GITG_CONFIG_FILE_H__ */
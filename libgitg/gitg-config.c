@@ -21,6 +21,7 @@
  */
 
 #include "gitg-config.h"
+#include "gitg-config-file.h"
 #include "gitg-shell.h"
 
 #define GITG_CONFIG_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE((object), GITG_TYPE_CONFIG, GitgConfigPrivate))
@@ -35,8 +36,6 @@ struct _GitgConfigPrivate
 {
 	GitgRepository *repository;
 	GitgShell *shell;
-
-	GString *accumulated;
 };
 
 G_DEFINE_TYPE (GitgConfig, gitg_config, G_TYPE_OBJECT)
@@ -51,8 +50,6 @@ gitg_config_finalize (GObject *object)
 		g_object_unref(config->priv->repository);
 	}
 
-	g_string_free (config->priv->accumulated, TRUE);
-
 	G_OBJECT_CLASS (gitg_config_parent_class)->finalize (object);
 }
 
@@ -112,45 +109,12 @@ gitg_config_class_init (GitgConfigClass *klass)
 	g_type_class_add_private (object_class, sizeof(GitgConfigPrivate));
 }
 
-static void
-gitg_config_accumulate (GitgShell   *shell,
-                        gchar      **buffer,
-                        GitgConfig *config)
-{
-	gchar **ptr = buffer;
-
-	while (*ptr)
-	{
-		g_string_append (config->priv->accumulated, *ptr);
-		++ptr;
-	}
-}
-
-static void
-gitg_config_begin (GitgShell  *shell,
-                   GitgConfig *config)
-{
-	g_string_erase (config->priv->accumulated, 0, -1);
-}
-
 static void
 gitg_config_init (GitgConfig *self)
 {
 	self->priv = GITG_CONFIG_GET_PRIVATE (self);
 
 	self->priv->shell = gitg_shell_new_synchronized (1000);
-
-	self->priv->accumulated = g_string_new ("");
-
-	g_signal_connect (self->priv->shell,
-	                  "update",
-	                  G_CALLBACK (gitg_config_accumulate),
-	                  self);
-
-	g_signal_connect (self->priv->shell,
-	                  "begin",
-	                  G_CALLBACK (gitg_config_begin),
-	                  self);
 }
 
 GitgConfig *
@@ -159,152 +123,165 @@ gitg_config_new (GitgRepository *repository)
 	return g_object_new (GITG_TYPE_CONFIG, "repository", repository, NULL); 
 }
 
-static gchar *
-get_value_process (GitgConfig *config, gboolean ret)
+/* Config files read for --global, in the order git reads them */
+static GSList *
+get_global_paths (void)
 {
-	gchar *res;
+	GSList *ret = NULL;
+	gchar const *xdg = g_getenv ("XDG_CONFIG_HOME");
 
-	if (ret)
+	if (xdg && *xdg)
 	{
-		res = g_strndup (config->priv->accumulated->str,
-		                 config->priv->accumulated->len);
+		ret = g_slist_prepend (ret, g_build_filename (xdg, "git", "config", NULL));
 	}
 	else
 	{
-		res = NULL;
+		ret = g_slist_prepend (ret, g_build_filename (g_get_home_dir (), ".config", "git", "config", NULL));
 	}
 
-	return res;
+	ret = g_slist_prepend (ret, g_build_filename (g_get_home_dir (), ".gitconfig", NULL));
+
+	return g_slist_reverse (ret);
 }
 
-static gchar *
-get_value_global (GitgConfig *config, gchar const *key)
+static GSList *
+get_local_paths (GitgConfig *config)
 {
-	GError *error = NULL;
+	GFile *git_dir;
+	GFile *cfg_file;
+	gchar *cfg;
 
-	gboolean ret;
+	git_dir = gitg_repository_get_git_dir (config->priv->repository);
 
-	ret = gitg_shell_run (config->priv->shell,
-	                      gitg_command_new (NULL,
-	                                        "git",
-	                                        "config",
-	                                        "--global",
-	                                        key,
-	                                        NULL),
-	                      &error);
+	cfg_file = g_file_get_child (git_dir, "config");
+	cfg = g_file_get_path (cfg_file);
 
-	if (error)
-	{
-		g_warning ("Failed to get config: %s", error->message);
-		g_error_free (error);
-	}
+	g_object_unref (cfg_file);
+	g_object_unref (git_dir);
 
-	return get_value_process (config, ret);
+	return g_slist_prepend (NULL, cfg);
 }
 
-static gchar *
-get_value_global_regex (GitgConfig *config,
-                        gchar const *regex,
-                        gchar const *value_regex)
+static GSList *
+get_paths (GitgConfig *config)
 {
-	GError *error = NULL;
+	if (config->priv->repository != NULL)
+	{
+		return get_local_paths (config);
+	}
+	else
+	{
+		return get_global_paths ();
+	}
+}
 
-	gboolean ret;
+static void
+free_paths (GSList *paths)
+{
+	g_slist_foreach (paths, (GFunc)g_free, NULL);
+	g_slist_free (paths);
+}
 
-	ret = gitg_shell_run (config->priv->shell,
-	                      gitg_command_new (NULL,
-	                                        "git",
-	                                        "config",
-	                                        "--global",
-	                                        "--get-regexp",
-	                                        NULL),
-	                      &error);
+static void
+invalidate_paths (GitgConfig *config)
+{
+	GSList *paths = get_paths (config);
+	GSList *item;
 
-	if (error)
+	for (item = paths; item; item = g_slist_next (item))
 	{
-		g_warning ("Failed to get config: %s", error->message);
-		g_error_free (error);
+		gitg_config_file_invalidate (item->data);
 	}
 
-	return get_value_process (config, ret);
+	free_paths (paths);
 }
 
 static gchar *
-get_value_local (GitgConfig *config, gchar const *key)
+get_value (GitgConfig  *config,
+           gchar const *key)
 {
-	gboolean ret;
-	GFile *git_dir;
-	GFile *cfg_file;
-	gchar *cfg;
-	GError *error = NULL;
-
-	git_dir = gitg_repository_get_git_dir (config->priv->repository);
-
-	cfg_file = g_file_get_child (git_dir, "config");
-	cfg = g_file_get_path (cfg_file);
-
-	ret = gitg_shell_run (config->priv->shell,
-	                      gitg_command_new (config->priv->repository,
-	                                         "config",
-	                                         "--file",
-	                                         cfg,
-	                                         key,
-	                                         NULL),
-	                      &error);
-
-	if (error)
+	GSList *paths = get_paths (config);
+	GSList *item;
+	gboolean found = FALSE;
+	gchar const *value = NULL;
+	gchar *ret;
+
+	/* Later files override earlier ones */
+	for (item = paths; item; item = g_slist_next (item))
 	{
-		g_warning ("Failed to get config: %s", error->message);
-		g_error_free (error);
-	}
+		gchar const *val;
 
-	g_free (cfg);
+		if (gitg_config_file_lookup (gitg_config_file_get (item->data), key, &val))
+		{
+			found = TRUE;
+			value = val;
+		}
+	}
 
-	g_object_unref (cfg_file);
-	g_object_unref (git_dir);
+	ret = found ? g_strdup (value ? value : "") : NULL;
 
-	return get_value_process (config, ret);
+	free_paths (paths);
+	return ret;
 }
 
 static gchar *
-get_value_local_regex (GitgConfig *config,
-                       gchar const *regex,
-                       gchar const *value_regex)
+get_value_regex (GitgConfig  *config,
+                 gchar const *regex,
+                 gchar const *value_regex)
 {
-	gboolean ret;
-	GFile *git_dir;
-	GFile *cfg_file;
-	gchar *cfg;
+	GRegex *re;
+	GRegex *value_re = NULL;
 	GError *error = NULL;
+	GSList *paths;
+	GSList *item;
+	GString *output;
 
-	git_dir = gitg_repository_get_git_dir (config->priv->repository);
-
-	cfg_file = g_file_get_child (git_dir, "config");
-	cfg = g_file_get_path (cfg_file);
+	re = g_regex_new (regex, 0, 0, &error);
 
-	ret = gitg_shell_run (config->priv->shell,
-	                      gitg_command_new (config->priv->repository,
-	                                         "config",
-	                                         "--file",
-	                                         cfg,
-	                                         "--get-regexp",
-	                                         regex,
-	                                         value_regex,
-	                                         NULL),
-	                      &error);
+	if (re && value_regex)
+	{
+		value_re = g_regex_new (value_regex, 0, 0, &error);
+	}
 
 	if (error)
 	{
 		g_warning ("Failed to get config: %s", error->message);
 		g_error_free (error);
+
+		if (re)
+		{
+			g_regex_unref (re);
+		}
+
+		return NULL;
 	}
 
-	g_free (cfg);
+	paths = get_paths (config);
+	output = g_string_new ("");
 
-	g_object_unref (cfg_file);
-	g_object_unref (git_dir);
+	for (item = paths; item; item = g_slist_next (item))
+	{
+		gitg_config_file_match (gitg_config_file_get (item->data),
+		                        re,
+		                        value_re,
+		                        output);
+	}
 
-	return get_value_process (config, ret);
+	free_paths (paths);
+	g_regex_unref (re);
+
+	if (value_re)
+	{
+		g_regex_unref (value_re);
+	}
+
+	if (output->len == 0)
+	{
+		g_string_free (output, TRUE);
+		return NULL;
+	}
+
+	return g_string_free (output, FALSE);
 }
 
 static gboolean
@@ -441,14 +418,7 @@ gitg_config_get_value (GitgConfig *config, gchar const *key)
 	g_return_val_if_fail (GITG_IS_CONFIG (config), NULL);
 	g_return_val_if_fail (key != NULL, NULL);
 
-	if (config->priv->repository != NULL)
-	{
-		return get_value_local (config, key);
-	}
-	else
-	{
-		return get_value_global (config, key);
-	}
+	return get_value (config, key);
 }
 
 gchar *
@@ -459,45 +429,50 @@ gitg_config_get_value_regex (GitgConfig *config,
 	g_return_val_if_fail (GITG_IS_CONFIG (config), NULL);
 	g_return_val_if_fail (regex != NULL, NULL);
 
-	if (config->priv->repository != NULL)
-	{
-		return get_value_local_regex (config, regex, value_regex);
-	}
-	else
-	{
-		return get_value_global_regex (config, regex, value_regex);
-	}
+	return get_value_regex (config, regex, value_regex);
 }
 
 gboolean
 gitg_config_set_value (GitgConfig *config, gchar const *key, gchar const *value)
 {
+	gboolean ret;
+
 	g_return_val_if_fail (GITG_IS_CONFIG (config), FALSE);
 	g_return_val_if_fail (key != NULL, FALSE);
 
 	if (config->priv->repository != NULL)
 	{
-		return set_value_local (config, key, value);
+		ret = set_value_local (config, key, value);
 	}
 	else
 	{
-		return set_value_global (config, key, value);
+		ret = set_value_global (config, key, value);
 	}
+
+	/* Also picked up by the file stamps, but those have a resolution of
+	   a second */
+	invalidate_paths (config);
+	return ret;
 }
 
 gboolean 
 gitg_config_rename (GitgConfig *config, gchar const *old, gchar const *nw)
 {
+	gboolean ret;
+
 	g_return_val_if_fail (GITG_IS_CONFIG (config), FALSE);
 	g_return_val_if_fail (old != NULL, FALSE);
 	g_return_val_if_fail (nw != NULL, FALSE);
 
 	if (config->priv->repository != NULL)
 	{
-		return rename_local (config, old, nw);
+		ret = rename_local (config, old, nw);
 	}
 	else
 	{
-		return rename_global (config, old, nw);
+		ret = rename_global (config, old, nw);
 	}
+
+	invalidate_paths (config);
+	return ret;
 }
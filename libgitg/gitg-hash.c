@@ -145,3 +145,44 @@ gitg_hash_hash_equal (gconstpointer a, gconstpointer b)
 {
 	return memcmp (a, b, GITG_HASH_BINARY_SIZE) == 0;
 }
+
+gint
+gitg_hash_parse_prefix (gchar const *sha,
+                        gchar       *hash)
+{
+	gint length = 0;
+
+	while (sha[length])
+	{
+		if (length == GITG_HASH_SHA_SIZE || !g_ascii_isxdigit (sha[length]))
+		{
+			return 0;
+		}
+
+		++length;
+	}
+
+	memset (hash, 0, GITG_HASH_BINARY_SIZE);
+	gitg_hash_partial_sha1_to_hash (sha, length, hash);
+
+	if (length % 2 == 1)
+	{
+		hash[length / 2] = atoh (sha[length - 1]) << 4;
+	}
+
+	return length;
+}
+
+gboolean
+gitg_hash_has_prefix (gchar const *hash,
+                      gchar const *prefix,
+                      gint         length)
+{
+	if (memcmp (hash, prefix, length / 2) != 0)
+	{
+		return FALSE;
+	}
+
+	return length % 2 == 0 ||
+	       (hash[length / 2] & 0xf0) == (prefix[length / 2] & 0xf0);
+}
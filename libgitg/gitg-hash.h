@@ -45,6 +45,9 @@ gchar *gitg_hash_partial_sha1_to_hash_new (gchar const *sha, gint length, gint *
 guint gitg_hash_hash(gconstpointer v);
 gboolean gitg_hash_hash_equal(gconstpointer a, gconstpointer b);
 
+gint gitg_hash_parse_prefix (gchar const *sha, gchar *hash);
+gboolean gitg_hash_has_prefix (gchar const *hash, gchar const *prefix, gint length);
+
 G_END_DECLS
 
 #endif /* __GITG_HASH_H__ */
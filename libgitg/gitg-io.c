@@ -328,7 +328,7 @@ gitg_io_set_input (GitgIO       *io,
                    GInputStream *stream)
 {
 	g_return_if_fail (GITG_IS_IO (io));
-	g_return_if_fail (G_IS_INPUT_STREAM (stream));
+	g_return_if_fail (stream == NULL || G_IS_INPUT_STREAM (stream));
 
 	if (io->priv->input)
 	{
@@ -22,6 +22,8 @@
 
 #include "gitg-line-parser.h"
 
+#include <string.h>
+
 #define GITG_LINE_PARSER_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE((object), GITG_TYPE_LINE_PARSER, GitgLineParserPrivate))
 
 struct _GitgLineParserPrivate
@@ -35,6 +37,18 @@ struct _GitgLineParserPrivate
 	gchar *read_buffer;
 
 	gboolean preserve_line_endings;
+
+	/* Split on NUL instead of newlines, for the -z output of git */
+	gboolean nul_separated;
+
+	/* Reading stops after the current block while paused, the pending
+	   read is parked here until reading is resumed */
+	gboolean paused;
+	gpointer parked;
+
+	/* Whether a NUL byte was read, which means the data is binary
+	   unless records are NUL separated */
+	gboolean seen_nul;
 };
 
 enum
@@ -50,7 +64,8 @@ enum
 {
 	PROP_0,
 	PROP_BUFFER_SIZE,
-	PROP_PRESERVE_LINE_ENDINGS
+	PROP_PRESERVE_LINE_ENDINGS,
+	PROP_NUL_SEPARATED
 };
 
 static guint signals[NUM_SIGNALS] = {0,};
@@ -106,6 +121,11 @@ gitg_line_parser_finalize (GObject *object)
 
 	free_lines (stream);
 
+	if (stream->priv->parked)
+	{
+		async_data_free (stream->priv->parked);
+	}
+
 	g_slice_free1 (sizeof (gchar *) * (stream->priv->buffer_size + 1), stream->priv->lines);
 	g_slice_free1 (sizeof (gchar) * (stream->priv->buffer_size + 1), stream->priv->read_buffer);
 
@@ -166,6 +186,21 @@ find_newline (const gchar  *ptr,
 	return NULL;
 }
 
+static const gchar *
+find_nul (const gchar  *ptr,
+          const gchar  *end,
+          const gchar **line_end)
+{
+	const gchar *nul = memchr (ptr, '\0', end - ptr);
+
+	if (nul)
+	{
+		*line_end = nul + 1;
+	}
+
+	return nul;
+}
+
 static void
 parse_lines (GitgLineParser *stream,
              const gchar    *buffer,
@@ -201,7 +236,14 @@ parse_lines (GitgLineParser *stream,
 	const gchar *line_end;
 	end = ptr + size;
 
-	while ((newline = find_newline (ptr, end, &line_end)))
+	if (!stream->priv->nul_separated && !stream->priv->seen_nul)
+	{
+		stream->priv->seen_nul = memchr (buffer, '\0', size) != NULL;
+	}
+
+	while ((newline = stream->priv->nul_separated ?
+	                  find_nul (ptr, end, &line_end) :
+	                  find_newline (ptr, end, &line_end)))
 	{
 		if (stream->priv->preserve_line_endings)
 		{
@@ -222,8 +264,13 @@ parse_lines (GitgLineParser *stream,
 
 	if (ptr < end)
 	{
+		/* Copied as is, the rest may hold NUL separated records when
+		   the lines buffer filled up */
 		stream->priv->rest_buffer_size = end - ptr;
-		stream->priv->rest_buffer = g_strndup (ptr, stream->priv->rest_buffer_size);
+		stream->priv->rest_buffer = g_malloc (stream->priv->rest_buffer_size + 1);
+
+		memcpy (stream->priv->rest_buffer, ptr, stream->priv->rest_buffer_size);
+		stream->priv->rest_buffer[stream->priv->rest_buffer_size] = '\0';
 	}
 
 	stream->priv->lines[i] = NULL;
@@ -284,6 +331,9 @@ gitg_line_parser_set_property (GObject      *object,
 		case PROP_PRESERVE_LINE_ENDINGS:
 			self->priv->preserve_line_endings = g_value_get_boolean (value);
 		break;
+		case PROP_NUL_SEPARATED:
+			self->priv->nul_separated = g_value_get_boolean (value);
+		break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -306,6 +356,9 @@ gitg_line_parser_get_property (GObject    *object,
 		case PROP_PRESERVE_LINE_ENDINGS:
 			g_value_set_boolean (value, self->priv->preserve_line_endings);
 		break;
+		case PROP_NUL_SEPARATED:
+			g_value_set_boolean (value, self->priv->nul_separated);
+		break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -374,7 +427,19 @@ read_ready (GInputStream *stream,
 		             data->parser->priv->read_buffer,
 		             read);
 
-		start_read_lines (data);
+		/* The parser may be gone when a handler cancelled reading */
+		if (g_cancellable_is_cancelled (data->cancellable))
+		{
+			async_data_free (data);
+		}
+		else if (data->parser->priv->paused)
+		{
+			data->parser->priv->parked = data;
+		}
+		else
+		{
+			start_read_lines (data);
+		}
 	}
 }
 
@@ -444,6 +509,14 @@ gitg_line_parser_class_init (GitgLineParserClass *klass)
 	                                                       "Preserve Line Endings",
 	                                                       FALSE,
 	                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+
+	g_object_class_install_property (object_class,
+	                                 PROP_NUL_SEPARATED,
+	                                 g_param_spec_boolean ("nul-separated",
+	                                                       "NUL separated",
+	                                                       "NUL Separated",
+	                                                       FALSE,
+	                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
 }
 
 static void
@@ -473,6 +546,46 @@ gitg_line_parser_parse (GitgLineParser *parser,
 	g_return_if_fail (G_IS_INPUT_STREAM (stream));
 	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
 
+	parser->priv->seen_nul = FALSE;
+
 	data = async_data_new (parser, stream, cancellable);
 	start_read_lines (data);
 }
+
+/* Stops reading after the block being parsed, so that the writer on the
+   other end of a pipe blocks until reading is resumed */
+void
+gitg_line_parser_set_paused (GitgLineParser *parser,
+                             gboolean        paused)
+{
+	AsyncData *data;
+
+	g_return_if_fail (GITG_IS_LINE_PARSER (parser));
+
+	parser->priv->paused = paused;
+	data = parser->priv->parked;
+
+	if (paused || !data)
+	{
+		return;
+	}
+
+	parser->priv->parked = NULL;
+
+	if (g_cancellable_is_cancelled (data->cancellable))
+	{
+		async_data_free (data);
+	}
+	else
+	{
+		start_read_lines (data);
+	}
+}
+
+gboolean
+gitg_line_parser_get_seen_nul (GitgLineParser *parser)
+{
+	g_return_val_if_fail (GITG_IS_LINE_PARSER (parser), FALSE);
+
+	return parser->priv->seen_nul;
+}
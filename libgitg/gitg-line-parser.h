@@ -62,6 +62,11 @@ void gitg_line_parser_parse (GitgLineParser *parser,
                              GInputStream   *stream,
                              GCancellable   *cancellable);
 
+void gitg_line_parser_set_paused (GitgLineParser *parser,
+                                  gboolean        paused);
+
+gboolean gitg_line_parser_get_seen_nul (GitgLineParser *parser);
+
 G_END_DECLS
 
 #endif /* __GITG_LINE_PARSER_H__ */
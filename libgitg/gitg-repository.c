@@ -27,14 +27,25 @@
 #include "gitg-ref.h"
 #include "gitg-config.h"
 #include "gitg-shell.h"
+#include "gitg-search-index.h"
+#include "gitg-commit-cache.h"
 
 #include <gio/gio.h>
 #include <sys/time.h>
 #include <time.h>
 #include <string.h>
+#include <stdlib.h>
 
 #define GITG_REPOSITORY_GET_PRIVATE(object) (G_TYPE_INSTANCE_GET_PRIVATE((object), GITG_TYPE_REPOSITORY, GitgRepositoryPrivate))
 
+#define LOG_FORMAT "%H\x01%an\x01%ae\x01%at\x01%cn\x01%ce\x01%ct\x01%s\x01%P"
+
+/* Default number of revisions loaded before waiting for load_more */
+#define LOAD_PAGE_SIZE 5000
+
+/* Maximum number of formatted dates kept for the date column */
+#define DATE_CACHE_SIZE 4096
+
 static void gitg_repository_tree_model_iface_init (GtkTreeModelIface *iface);
 
 G_DEFINE_TYPE_EXTENDED (GitgRepository, gitg_repository, G_TYPE_OBJECT, 0,
@@ -55,7 +66,8 @@ enum
 	PROP_INACTIVE_MAX,
 	PROP_INACTIVE_COLLAPSE,
 	PROP_INACTIVE_GAP,
-	PROP_INACTIVE_ENABLED
+	PROP_INACTIVE_ENABLED,
+	PROP_PAGE_SIZE
 };
 
 /* Signals */
@@ -94,6 +106,14 @@ struct _GitgRepositoryPrivate
 
 	GitgShell *loader;
 	GHashTable *hashtable;
+
+	/* The hashtable stores the first head_rows rows by their (negated)
+	   row number and all later rows relative to row_offset. Commits are
+	   only inserted or removed at the top, which then only touches the
+	   few head rows instead of renumbering the whole history */
+	gulong head_rows;
+	glong row_offset;
+
 	gint stamp;
 	GType column_types[N_COLUMNS];
 
@@ -102,7 +122,31 @@ struct _GitgRepositoryPrivate
 
 	GitgRevision **storage;
 	GitgLanes *lanes;
+
+	/* Revisions of the current loader batch, not yet in storage */
+	GPtrArray *pending;
+
+	/* Display strings of author dates, by timestamp */
+	GHashTable *date_cache;
+
+	/* Revisions sorted by hash, covering the first hash_indexed rows */
+	GPtrArray *hash_index;
+	gulong hash_indexed;
+
+	/* Casefolded subject, author and email of the rows after the head
+	   rows, by their stored number and up to search_indexed */
+	GitgSearchIndex *search_index;
+	glong search_indexed;
+
+	/* Output of git commands about single commits, shared by the panels */
+	GitgCommitCache *commit_cache;
+
 	GHashTable *refs;
+
+	/* All refs, sorted by type and name when ref_index_sorted is set */
+	GPtrArray *ref_index;
+	gboolean ref_index_sorted;
+
 	GitgRef *current_ref;
 	GitgRef *working_ref;
 
@@ -117,6 +161,15 @@ struct _GitgRepositoryPrivate
 
 	LoadStage load_stage;
 
+	/* Commits are read from a single log, which is paused after every
+	   page_size commits (0 loads everything) until the next page is
+	   requested */
+	guint page_size;
+	gulong page_loaded;
+	guint has_more : 1;
+	guint commits_paused : 1;
+	guint idle_page_id;
+
 	GFileMonitor *monitor;
 
 	guint show_staged : 1;
@@ -126,6 +179,8 @@ struct _GitgRepositoryPrivate
 };
 
 static gboolean repository_relane (GitgRepository *repository);
+static void grow_storage (GitgRepository *repository,
+                          gint            size);
 static void build_log_args (GitgRepository  *self,
                             gint             argc,
                             gchar const    **av);
@@ -214,6 +269,32 @@ tree_model_get_path (GtkTreeModel *tree_model,
 	return gtk_tree_path_new_from_indices (GPOINTER_TO_INT (iter->user_data), -1);
 }
 
+static gchar const *
+get_date_for_display (GitgRepository *repository,
+                      GitgRevision   *revision)
+{
+	gint64 date = gitg_revision_get_author_date (revision);
+	gchar *ret = g_hash_table_lookup (repository->priv->date_cache, &date);
+
+	if (ret)
+	{
+		return ret;
+	}
+
+	if (g_hash_table_size (repository->priv->date_cache) >= DATE_CACHE_SIZE)
+	{
+		g_hash_table_remove_all (repository->priv->date_cache);
+	}
+
+	ret = gitg_revision_get_author_date_for_display (revision);
+
+	g_hash_table_insert (repository->priv->date_cache,
+	                     g_memdup (&date, sizeof (gint64)),
+	                     ret);
+
+	return ret;
+}
+
 static void
 tree_model_get_value (GtkTreeModel *tree_model,
                       GtkTreeIter  *iter,
@@ -238,14 +319,17 @@ tree_model_get_value (GtkTreeModel *tree_model,
 		case OBJECT_COLUMN:
 			g_value_set_boxed (value, rv);
 		break;
+		/* The strings are owned by the revision, which outlives the
+		   short lived values handed out to cell renderers */
 		case SUBJECT_COLUMN:
-			g_value_set_string (value, gitg_revision_get_subject (rv));
+			g_value_set_static_string (value, gitg_revision_get_subject (rv));
 		break;
 		case AUTHOR_COLUMN:
-			g_value_set_string (value, gitg_revision_get_author (rv));
+			g_value_set_static_string (value, gitg_revision_get_author (rv));
 		break;
 		case DATE_COLUMN:
-			g_value_take_string (value, gitg_revision_get_author_date_for_display (rv));
+			/* The cache may be flushed, so this one is copied */
+			g_value_set_string (value, get_date_for_display (rp, rv));
 		break;
 		default:
 			g_assert_not_reached ();
@@ -358,6 +442,287 @@ gitg_repository_tree_model_iface_init (GtkTreeModelIface *iface)
 	iface->iter_parent = tree_model_iter_parent;
 }
 
+static void
+store_row (GitgRepository *repository,
+           gulong          index)
+{
+	glong stored;
+
+	if (index < repository->priv->head_rows)
+	{
+		stored = -(glong)index - 1;
+	}
+	else
+	{
+		stored = (glong)index - repository->priv->row_offset;
+	}
+
+	g_hash_table_replace (repository->priv->hashtable,
+	                      (gpointer)gitg_revision_get_hash (repository->priv->storage[index]),
+	                      GINT_TO_POINTER (stored));
+}
+
+static gboolean
+lookup_row (GitgRepository *repository,
+            gchar const    *hash,
+            gulong         *index)
+{
+	gpointer value;
+	glong stored;
+
+	if (!g_hash_table_lookup_extended (repository->priv->hashtable,
+	                                   hash,
+	                                   NULL,
+	                                   &value))
+	{
+		return FALSE;
+	}
+
+	stored = GPOINTER_TO_INT (value);
+
+	if (index)
+	{
+		*index = stored < 0 ? -stored - 1 : stored + repository->priv->row_offset;
+	}
+
+	return TRUE;
+}
+
+/* The stored number of the first row after the head rows */
+static glong
+first_stored_row (GitgRepository *repository)
+{
+	return (glong)repository->priv->head_rows - repository->priv->row_offset;
+}
+
+static void
+invalidate_indices (GitgRepository *repository)
+{
+	g_ptr_array_set_size (repository->priv->hash_index, 0);
+	repository->priv->hash_indexed = 0;
+
+	gitg_search_index_clear (repository->priv->search_index);
+	repository->priv->search_indexed = 0;
+}
+
+static gint
+compare_revision_hash (gconstpointer a,
+                       gconstpointer b)
+{
+	return memcmp (gitg_revision_get_hash (*(GitgRevision * const *)a),
+	               gitg_revision_get_hash (*(GitgRevision * const *)b),
+	               GITG_HASH_BINARY_SIZE);
+}
+
+/* Position of the first revision in the hash index not sorting before hash */
+static guint
+hash_index_lower_bound (GPtrArray   *index,
+                        gchar const *hash)
+{
+	guint lower = 0;
+	guint upper = index->len;
+
+	while (lower < upper)
+	{
+		guint mid = lower + (upper - lower) / 2;
+		GitgRevision *revision = g_ptr_array_index (index, mid);
+
+		if (memcmp (gitg_revision_get_hash (revision), hash, GITG_HASH_BINARY_SIZE) < 0)
+		{
+			lower = mid + 1;
+		}
+		else
+		{
+			upper = mid;
+		}
+	}
+
+	return lower;
+}
+
+static void
+hash_index_insert (GitgRepository *repository,
+                   GitgRevision   *revision)
+{
+	GPtrArray *index = repository->priv->hash_index;
+	guint pos = hash_index_lower_bound (index, gitg_revision_get_hash (revision));
+
+	g_ptr_array_set_size (index, index->len + 1);
+
+	memmove (index->pdata + pos + 1,
+	         index->pdata + pos,
+	         sizeof (gpointer) * (index->len - pos - 1));
+
+	index->pdata[pos] = revision;
+	++repository->priv->hash_indexed;
+}
+
+static void
+hash_index_remove (GitgRepository *repository,
+                   GitgRevision   *revision)
+{
+	GPtrArray *index = repository->priv->hash_index;
+	guint pos = hash_index_lower_bound (index, gitg_revision_get_hash (revision));
+
+	/* Virtual rows can share their hash */
+	while (pos < index->len && index->pdata[pos] != revision)
+	{
+		++pos;
+	}
+
+	if (pos < index->len)
+	{
+		g_ptr_array_remove_index (index, pos);
+		--repository->priv->hash_indexed;
+	}
+}
+
+static void
+ensure_hash_index (GitgRepository *repository)
+{
+	gulong num = repository->priv->size - repository->priv->hash_indexed;
+	GPtrArray *index = repository->priv->hash_index;
+	GitgRevision **added;
+	glong i;
+	glong j;
+	glong k;
+
+	if (num == 0)
+	{
+		return;
+	}
+
+	/* Rows are only appended while loading, so sort the new rows and
+	   merge them into the existing index from the back */
+	added = g_new (GitgRevision *, num);
+
+	memcpy (added,
+	        repository->priv->storage + repository->priv->hash_indexed,
+	        sizeof (GitgRevision *) * num);
+
+	qsort (added, num, sizeof (GitgRevision *), compare_revision_hash);
+
+	i = (glong)index->len - 1;
+	j = (glong)num - 1;
+
+	g_ptr_array_set_size (index, index->len + num);
+	k = (glong)index->len - 1;
+
+	while (j >= 0)
+	{
+		if (i >= 0 && compare_revision_hash (&index->pdata[i], &added[j]) > 0)
+		{
+			index->pdata[k--] = index->pdata[i--];
+		}
+		else
+		{
+			index->pdata[k--] = added[j--];
+		}
+	}
+
+	g_free (added);
+	repository->priv->hash_indexed = repository->priv->size;
+}
+
+static gchar const *
+search_field_text (GitgRevision     *revision,
+                   GitgSearchFields  field)
+{
+	switch (field)
+	{
+		case GITG_SEARCH_SUBJECT:
+			return gitg_revision_get_subject (revision);
+		case GITG_SEARCH_AUTHOR:
+			return gitg_revision_get_author (revision);
+		case GITG_SEARCH_AUTHOR_EMAIL:
+			return gitg_revision_get_author_email (revision);
+		default:
+			return NULL;
+	}
+}
+
+static GitgSearchFields search_fields[] = {
+	GITG_SEARCH_SUBJECT,
+	GITG_SEARCH_AUTHOR,
+	GITG_SEARCH_AUTHOR_EMAIL
+};
+
+static void
+ensure_search_index (GitgRepository *repository)
+{
+	glong end = (glong)repository->priv->size - repository->priv->row_offset;
+	glong i;
+
+	/* The head rows are not indexed, they change when committing and
+	   there are only a few of them */
+	for (i = MAX (repository->priv->search_indexed, first_stored_row (repository)); i < end; ++i)
+	{
+		GitgRevision *revision = repository->priv->storage[i + repository->priv->row_offset];
+		guint f;
+
+		for (f = 0; f < G_N_ELEMENTS (search_fields); ++f)
+		{
+			gchar const *text = search_field_text (revision, search_fields[f]);
+
+			if (text)
+			{
+				gchar *folded = g_utf8_casefold (text, -1);
+				gitg_search_index_add (repository->priv->search_index, i, f, folded);
+				g_free (folded);
+			}
+		}
+	}
+
+	repository->priv->search_indexed = end;
+}
+
+static gboolean
+revision_matches (GitgRevision     *revision,
+                  gchar const      *folded,
+                  GitgSearchFields  fields)
+{
+	guint f;
+
+	for (f = 0; f < G_N_ELEMENTS (search_fields); ++f)
+	{
+		gchar const *text;
+		gboolean ret;
+
+		if (!(fields & search_fields[f]))
+		{
+			continue;
+		}
+
+		text = search_field_text (revision, search_fields[f]);
+
+		if (!text)
+		{
+			continue;
+		}
+
+		gchar *s = g_utf8_casefold (text, -1);
+		ret = strstr (s, folded) != NULL;
+		g_free (s);
+
+		if (ret)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gint
+compare_row (gconstpointer a,
+             gconstpointer b)
+{
+	guint ra = *(guint const *)a;
+	guint rb = *(guint const *)b;
+
+	return ra < rb ? -1 : (ra > rb ? 1 : 0);
+}
+
 static void
 do_clear (GitgRepository *repository,
           gboolean        emit)
@@ -382,21 +747,43 @@ do_clear (GitgRepository *repository,
 
 	if (repository->priv->storage)
 	{
-		g_slice_free1 (sizeof (GitgRevision *) * repository->priv->size,
+		g_slice_free1 (sizeof (GitgRevision *) * repository->priv->allocated,
 		               repository->priv->storage);
 	}
 
+	for (i = 0; i < repository->priv->pending->len; ++i)
+	{
+		gitg_revision_unref (g_ptr_array_index (repository->priv->pending, i));
+	}
+
+	g_ptr_array_set_size (repository->priv->pending, 0);
+
 	repository->priv->storage = NULL;
 	repository->priv->size = 0;
 	repository->priv->allocated = 0;
 
+	repository->priv->page_loaded = 0;
+	repository->priv->has_more = FALSE;
+	repository->priv->commits_paused = FALSE;
+
+	if (repository->priv->idle_page_id)
+	{
+		g_source_remove (repository->priv->idle_page_id);
+		repository->priv->idle_page_id = 0;
+	}
+
 	gitg_ref_free (repository->priv->current_ref);
 	repository->priv->current_ref = NULL;
 
 	/* clear hash tables */
 	g_hash_table_remove_all (repository->priv->hashtable);
+	repository->priv->head_rows = 0;
+	repository->priv->row_offset = 0;
+	invalidate_indices (repository);
 	g_hash_table_remove_all (repository->priv->refs);
 	g_hash_table_remove_all (repository->priv->ref_names);
+	g_ptr_array_set_size (repository->priv->ref_index, 0);
+	repository->priv->ref_index_sorted = TRUE;
 	g_hash_table_remove_all (repository->priv->ref_pushes);
 
 	gitg_color_reset ();
@@ -437,8 +824,14 @@ gitg_repository_finalize (GObject *object)
 
 	/* Free the hash */
 	g_hash_table_destroy (rp->priv->hashtable);
+	g_ptr_array_free (rp->priv->hash_index, TRUE);
+	g_ptr_array_free (rp->priv->pending, TRUE);
+	g_hash_table_destroy (rp->priv->date_cache);
+	gitg_search_index_free (rp->priv->search_index);
+	gitg_commit_cache_free (rp->priv->commit_cache);
 	g_hash_table_destroy (rp->priv->refs);
 	g_hash_table_destroy (rp->priv->ref_names);
+	g_ptr_array_free (rp->priv->ref_index, TRUE);
 	g_hash_table_destroy (rp->priv->ref_pushes);
 
 	/* Free cached args */
@@ -450,6 +843,11 @@ gitg_repository_finalize (GObject *object)
 		g_source_remove (rp->priv->idle_relane_id);
 	}
 
+	if (rp->priv->idle_page_id)
+	{
+		g_source_remove (rp->priv->idle_page_id);
+	}
+
 	if (rp->priv->current_ref)
 	{
 		gitg_ref_free (rp->priv->current_ref);
@@ -543,6 +941,9 @@ gitg_repository_set_property (GObject      *object,
 			                      value);
 			prepare_relane (self);
 		break;
+		case PROP_PAGE_SIZE:
+			self->priv->page_size = g_value_get_uint (value);
+		break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -600,6 +1001,9 @@ gitg_repository_get_property (GObject    *object,
 			                      "inactive-enabled",
 			                      value);
 		break;
+		case PROP_PAGE_SIZE:
+			g_value_set_uint (value, self->priv->page_size);
+		break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -831,6 +1235,16 @@ gitg_repository_class_init (GitgRepositoryClass *klass)
 	                                                       TRUE,
 	                                                       G_PARAM_READWRITE));
 
+	g_object_class_install_property (object_class,
+	                                 PROP_PAGE_SIZE,
+	                                 g_param_spec_uint ("page-size",
+	                                                    "Page size",
+	                                                    "Number of revisions to load at a time, 0 to load all",
+	                                                    0,
+	                                                    G_MAXUINT,
+	                                                    LOAD_PAGE_SIZE,
+	                                                    G_PARAM_READWRITE));
+
 	repository_signals[LOAD] =
 		g_signal_new ("load",
 		              G_OBJECT_CLASS_TYPE (object_class),
@@ -858,6 +1272,48 @@ gitg_repository_class_init (GitgRepositoryClass *klass)
 	g_type_class_add_private (object_class, sizeof (GitgRepositoryPrivate));
 }
 
+static void
+flush_pending (GitgRepository *repository)
+{
+	GPtrArray *pending = repository->priv->pending;
+	GtkTreePath *path;
+	GtkTreeIter iter;
+	guint i;
+
+	if (pending->len == 0)
+	{
+		return;
+	}
+
+	/* Make room for the whole batch at once, and announce the rows with
+	   a single path which is moved along */
+	grow_storage (repository, pending->len);
+	path = gtk_tree_path_new_from_indices (repository->priv->size, -1);
+
+	iter.stamp = repository->priv->stamp;
+	iter.user_data2 = NULL;
+	iter.user_data3 = NULL;
+
+	for (i = 0; i < pending->len; ++i)
+	{
+		GitgRevision *rv = g_ptr_array_index (pending, i);
+		gulong index = repository->priv->size++;
+
+		/* takes over the reference from the pending array */
+		repository->priv->storage[index] = rv;
+
+		store_row (repository, index);
+
+		iter.user_data = GINT_TO_POINTER (index);
+
+		gtk_tree_model_row_inserted (GTK_TREE_MODEL (repository), path, &iter);
+		gtk_tree_path_next (path);
+	}
+
+	gtk_tree_path_free (path);
+	g_ptr_array_set_size (pending, 0);
+}
+
 static void
 append_revision (GitgRepository *repository,
                  GitgRevision   *rv)
@@ -865,7 +1321,7 @@ append_revision (GitgRepository *repository,
 	GSList *lanes;
 	gint8 mylane = 0;
 
-	if (repository->priv->size == 0)
+	if (repository->priv->size == 0 && repository->priv->pending->len == 0)
 	{
 		gitg_lanes_reset (repository->priv->lanes);
 	}
@@ -873,8 +1329,8 @@ append_revision (GitgRepository *repository,
 	lanes = gitg_lanes_next (repository->priv->lanes, rv, &mylane);
 	gitg_revision_set_lanes (rv, lanes, mylane);
 
-	gitg_repository_add (repository, rv, NULL);
-	gitg_revision_unref (rv);
+	/* the row is inserted in the model when the batch is flushed */
+	g_ptr_array_add (repository->priv->pending, rv);
 }
 
 static void
@@ -908,6 +1364,23 @@ add_dummy_commit (GitgRepository *repository,
 	gitg_revision_set_sign (revision, staged ? 't' : 'u');
 
 	append_revision (repository, revision);
+	flush_pending (repository);
+}
+
+static gboolean
+run_commits_page (GitgRepository *repository)
+{
+	repository->priv->page_loaded = 0;
+	repository->priv->has_more = FALSE;
+	repository->priv->commits_paused = FALSE;
+
+	/* With --topo-order, git sorts the whole history before the first
+	   commit comes out, so the log is paused after every page instead
+	   of being started again for the next one */
+	return gitg_shell_run (repository->priv->loader,
+	                       gitg_command_newv (repository,
+	                                          (gchar const * const *)repository->priv->last_args),
+	                       NULL);
 }
 
 static void
@@ -969,10 +1442,11 @@ on_loader_end_loading (GitgShell      *object,
 				add_dummy_commit (repository, FALSE);
 			}
 
-			gitg_shell_run (object,
-			                gitg_command_newv (repository,
-			                                   (gchar const * const *)repository->priv->last_args),
-			                NULL);
+			run_commits_page (repository);
+		break;
+		case LOAD_STAGE_COMMITS:
+			/* The log ran to the end of the history */
+			repository->priv->has_more = FALSE;
 		break;
 		default:
 		break;
@@ -999,6 +1473,16 @@ add_ref (GitgRepository *self,
 	GitgRef *ref = gitg_ref_new (sha1, name);
 	GSList *refs = (GSList *)g_hash_table_lookup (self->priv->refs,
 	                                              gitg_ref_get_hash (ref));
+	GSList *found;
+
+	found = g_slist_find_custom (refs, ref, (GCompareFunc)find_ref_custom);
+
+	if (found)
+	{
+		/* Already known, keep the existing one */
+		gitg_ref_free (ref);
+		return found->data;
+	}
 
 	g_hash_table_insert (self->priv->ref_names,
 	                     (gpointer)gitg_ref_get_name (ref),
@@ -1012,16 +1496,12 @@ add_ref (GitgRepository *self,
 	}
 	else
 	{
-		if (!g_slist_find_custom (refs, ref, (GCompareFunc)find_ref_custom))
-		{
-			refs = g_slist_append (refs, ref);
-		}
-		else
-		{
-			gitg_ref_free (ref);
-		}
+		refs = g_slist_append (refs, ref);
 	}
 
+	g_ptr_array_add (self->priv->ref_index, ref);
+	self->priv->ref_index_sorted = FALSE;
+
 	return ref;
 }
 
@@ -1073,6 +1553,41 @@ loader_update_stash (GitgRepository  *repository,
 	}
 }
 
+static GitgRevision *
+parse_revision_line (gchar const *line)
+{
+	gchar **components = g_strsplit (line, "\01", 0);
+	guint len = g_strv_length (components);
+
+	if (len < 9)
+	{
+		g_strfreev (components);
+		return NULL;
+	}
+
+	/* components -> [hash, author, subject, parents ([1 2 3]), timestamp[, leftright]] */
+	gint64 author_date = g_ascii_strtoll (components[3], NULL, 0);
+	gint64 committer_date = g_ascii_strtoll (components[6], NULL, 0);
+
+	GitgRevision *rv = gitg_revision_new (components[0],
+	                                      components[1],
+	                                      components[2],
+	                                      author_date,
+	                                      components[4],
+	                                      components[5],
+	                                      committer_date,
+	                                      components[7],
+	                                      components[8]);
+
+	if (len > 9 && strlen (components[9]) == 1 && strchr ("<>-^", *components[9]) != NULL)
+	{
+		gitg_revision_set_sign (rv, *components[9]);
+	}
+
+	g_strfreev (components);
+	return rv;
+}
+
 static void
 loader_update_commits (GitgRepository  *self,
                        gchar          **buffer)
@@ -1082,42 +1597,45 @@ loader_update_commits (GitgRepository  *self,
 	while ( (line = *buffer++) != NULL)
 	{
 		/* new line is read */
-		gchar **components = g_strsplit (line, "\01", 0);
-		guint len = g_strv_length (components);
-
-		if (len < 9)
-		{
-			g_strfreev (components);
-			continue;
-		}
+		GitgRevision *rv = parse_revision_line (line);
 
-		/* components -> [hash, author, subject, parents ([1 2 3]), timestamp[, leftright]] */
-		gint64 author_date = g_ascii_strtoll (components[3], NULL, 0);
-		gint64 committer_date = g_ascii_strtoll (components[6], NULL, 0);
-
-		GitgRevision *rv = gitg_revision_new (components[0],
-		                                      components[1],
-		                                      components[2],
-		                                      author_date,
-		                                      components[4],
-		                                      components[5],
-		                                      committer_date,
-		                                      components[7],
-		                                      components[8]);
+		++self->priv->page_loaded;
 
-		if (len > 9 && strlen (components[9]) == 1 && strchr ("<>-^", *components[9]) != NULL)
+		if (rv)
 		{
-			gitg_revision_set_sign (rv, *components[9]);
+			append_revision (self, rv);
 		}
-
-		append_revision (self, rv);
-		g_strfreev (components);
 	}
 }
 
-static void
-on_loader_update (GitgShell       *object,
-                  gchar          **buffer,
+static gboolean
+emit_page_loaded (GitgRepository *repository)
+{
+	repository->priv->idle_page_id = 0;
+
+	g_signal_emit (repository, repository_signals[LOADED], 0);
+	return FALSE;
+}
+
+/* Stops reading the log after a full page. The rest of the history is
+   read by gitg_repository_load_more */
+static void
+pause_commits (GitgRepository *repository)
+{
+	gitg_shell_set_paused (repository->priv->loader, TRUE);
+
+	repository->priv->commits_paused = TRUE;
+	repository->priv->has_more = TRUE;
+	repository->priv->load_stage = LOAD_STAGE_LAST;
+
+	/* Emitted after the other handlers of this update ran */
+	repository->priv->idle_page_id = g_idle_add ((GSourceFunc)emit_page_loaded,
+	                                             repository);
+}
+
+static void
+on_loader_update (GitgShell       *object,
+                  gchar          **buffer,
                   GitgRepository  *repository)
 {
 	switch (repository->priv->load_stage)
@@ -1135,6 +1653,16 @@ on_loader_update (GitgShell       *object,
 		default:
 		break;
 	}
+
+	/* Insert all revisions of this batch in one go */
+	flush_pending (repository);
+
+	if (repository->priv->load_stage == LOAD_STAGE_COMMITS &&
+	    repository->priv->page_size > 0 &&
+	    repository->priv->page_loaded >= repository->priv->page_size)
+	{
+		pause_commits (repository);
+	}
 }
 
 static void
@@ -1229,11 +1757,11 @@ build_log_args (GitgRepository  *self,
 
 	if (has_left_right (av, argc))
 	{
-		argv[1] = g_strdup ("--pretty=format:%H\x01%an\x01%ae\x01%at\x01%cn\x01%ce\x01%ct\x01%s\x01%P\x01%m");
+		argv[1] = g_strdup ("--pretty=format:" LOG_FORMAT "\x01%m");
 	}
 	else
 	{
-		argv[1] = g_strdup ("--pretty=format:%H\x01%an\x01%ae\x01%at\x01%cn\x01%ce\x01%ct\x01%s\x01%P");
+		argv[1] = g_strdup ("--pretty=format:" LOG_FORMAT);
 	}
 
 	argv[2] = g_strdup ("--encoding=UTF-8");
@@ -1285,11 +1813,24 @@ gitg_repository_init (GitgRepository *object)
 	object->priv->hashtable = g_hash_table_new (gitg_hash_hash,
 	                                            gitg_hash_hash_equal);
 
+	object->priv->hash_index = g_ptr_array_new ();
+	object->priv->pending = g_ptr_array_new ();
+
+	object->priv->date_cache = g_hash_table_new_full (g_int64_hash,
+	                                                  g_int64_equal,
+	                                                  g_free,
+	                                                  g_free);
+	object->priv->search_index = gitg_search_index_new ();
+	object->priv->commit_cache = gitg_commit_cache_new ();
+
 	object->priv->ref_pushes = g_hash_table_new (gitg_hash_hash,
 	                                             gitg_hash_hash_equal);
 
 	object->priv->ref_names = g_hash_table_new (g_str_hash, g_str_equal);
 
+	object->priv->ref_index = g_ptr_array_new ();
+	object->priv->ref_index_sorted = TRUE;
+
 	object->priv->column_types[0] = GITG_TYPE_REVISION;
 	object->priv->column_types[1] = G_TYPE_STRING;
 	object->priv->column_types[2] = G_TYPE_STRING;
@@ -1297,6 +1838,7 @@ gitg_repository_init (GitgRepository *object)
 
 	object->priv->lanes = gitg_lanes_new ();
 	object->priv->grow_size = 1000;
+	object->priv->page_size = LOAD_PAGE_SIZE;
 	object->priv->stamp = g_random_int ();
 
 	object->priv->refs = g_hash_table_new_full (gitg_hash_hash,
@@ -1327,7 +1869,17 @@ grow_storage (GitgRepository *repository,
 	}
 
 	gulong prevallocated = repository->priv->allocated;
-	repository->priv->allocated += repository->priv->grow_size;
+
+	/* Grow geometrically so that loading large histories does not copy
+	   the storage over and over */
+	repository->priv->allocated = MAX (prevallocated * 2,
+	                                   prevallocated + repository->priv->grow_size);
+
+	if (repository->priv->allocated < repository->priv->size + size)
+	{
+		repository->priv->allocated = repository->priv->size + size;
+	}
+
 	GitgRevision **newstorage = g_slice_alloc (sizeof (GitgRevision *) * repository->priv->allocated);
 
 	gint i;
@@ -1378,6 +1930,13 @@ gitg_repository_get_loader (GitgRepository *self)
 	return GITG_SHELL (g_object_ref (self->priv->loader));
 }
 
+GitgCommitCache *
+gitg_repository_get_commit_cache (GitgRepository *repository)
+{
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), NULL);
+	return repository->priv->commit_cache;
+}
+
 static gboolean
 reload_revisions (GitgRepository  *repository,
                   GError         **error)
@@ -1515,6 +2074,362 @@ gitg_repository_reload (GitgRepository *repository)
 	reload_revisions (repository, NULL);
 }
 
+/* Turn the rows before end into head rows, so that they can be moved */
+static void
+extend_head_rows (GitgRepository *repository,
+                  gulong          end)
+{
+	gulong i;
+
+	for (i = repository->priv->head_rows; i < end; ++i)
+	{
+		repository->priv->head_rows = i + 1;
+		store_row (repository, i);
+	}
+}
+
+static void
+store_head_rows (GitgRepository *repository,
+                 gulong          from)
+{
+	gulong i;
+
+	for (i = from; i < repository->priv->head_rows; ++i)
+	{
+		store_row (repository, i);
+	}
+}
+
+static void
+remove_revision_at (GitgRepository *repository,
+                    gulong          index)
+{
+	GitgRevision *revision = repository->priv->storage[index];
+
+	extend_head_rows (repository, index + 1);
+
+	g_hash_table_remove (repository->priv->hashtable,
+	                     gitg_revision_get_hash (revision));
+
+	if (index < repository->priv->hash_indexed)
+	{
+		hash_index_remove (repository, revision);
+	}
+
+	memmove (repository->priv->storage + index,
+	         repository->priv->storage + index + 1,
+	         sizeof (GitgRevision *) * (repository->priv->size - index - 1));
+
+	--repository->priv->size;
+	--repository->priv->head_rows;
+	--repository->priv->row_offset;
+
+	store_head_rows (repository, index);
+
+	GtkTreePath *path = gtk_tree_path_new_from_indices (index, -1);
+	gtk_tree_model_row_deleted (GTK_TREE_MODEL (repository), path);
+	gtk_tree_path_free (path);
+
+	gitg_revision_unref (revision);
+}
+
+static void
+insert_revision_at (GitgRepository *repository,
+                    gulong          index,
+                    GitgRevision   *revision)
+{
+	GtkTreeIter iter;
+
+	grow_storage (repository, 1);
+	extend_head_rows (repository, index);
+
+	memmove (repository->priv->storage + index + 1,
+	         repository->priv->storage + index,
+	         sizeof (GitgRevision *) * (repository->priv->size - index));
+
+	repository->priv->storage[index] = gitg_revision_ref (revision);
+	++repository->priv->size;
+
+	if (index < repository->priv->hash_indexed)
+	{
+		hash_index_insert (repository, revision);
+	}
+
+	++repository->priv->head_rows;
+	++repository->priv->row_offset;
+
+	store_head_rows (repository, index);
+
+	fill_iter (repository, index, &iter);
+
+	GtkTreePath *path = gtk_tree_path_new_from_indices (index, -1);
+	gtk_tree_model_row_inserted (GTK_TREE_MODEL (repository), path, &iter);
+	gtk_tree_path_free (path);
+}
+
+static void
+remove_ref (GitgRepository *self,
+            GitgRef        *ref)
+{
+	gpointer key;
+	gpointer pushes;
+	GSList *refs;
+
+	if (g_hash_table_lookup_extended (self->priv->refs,
+	                                  gitg_ref_get_hash (ref),
+	                                  &key,
+	                                  (gpointer *)&refs))
+	{
+		/* The key points into the first ref of the list, so take the
+		   list out and put it back under whatever ref is first now */
+		g_hash_table_steal (self->priv->refs, key);
+		refs = g_slist_remove (refs, ref);
+
+		if (refs)
+		{
+			g_hash_table_insert (self->priv->refs,
+			                     (gpointer)gitg_ref_get_hash (refs->data),
+			                     refs);
+		}
+	}
+
+	g_hash_table_remove (self->priv->ref_names, gitg_ref_get_name (ref));
+
+	/* Removing keeps the order of the remaining refs */
+	g_ptr_array_remove (self->priv->ref_index, ref);
+
+	if (g_hash_table_lookup_extended (self->priv->ref_pushes,
+	                                  ref,
+	                                  NULL,
+	                                  &pushes))
+	{
+		g_hash_table_remove (self->priv->ref_pushes, ref);
+		g_slist_free (pushes);
+	}
+
+	gitg_ref_free (ref);
+}
+
+/* Whether name is a ref the way git rev-parse would find it */
+static gboolean
+is_ref_name (GitgRepository *self,
+             gchar const    *name)
+{
+	static gchar const *prefixes[] = {
+		"",
+		"refs/",
+		"refs/tags/",
+		"refs/heads/",
+		"refs/remotes/",
+		NULL
+	};
+
+	gchar const **prefix;
+
+	for (prefix = prefixes; *prefix; ++prefix)
+	{
+		gchar *full = g_strconcat (*prefix, name, NULL);
+		gboolean found = g_hash_table_lookup (self->priv->ref_names, full) != NULL;
+
+		g_free (full);
+
+		if (found)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/* Only a selection of plain revisions is known to contain the commits
+   made on top of head. Anything else (paths, --author, ranges, ...) may
+   filter them out */
+static gboolean
+selection_contains_head (GitgRepository *self,
+                         GitgRef        *head)
+{
+	gchar **ptr = self->priv->selection;
+	gboolean ret = FALSE;
+
+	if (ptr == NULL || *ptr == NULL)
+	{
+		return TRUE;
+	}
+
+	for (; *ptr; ++ptr)
+	{
+		if (strcmp (*ptr, "--all") == 0 ||
+		    strcmp (*ptr, "HEAD") == 0 ||
+		    strcmp (*ptr, gitg_ref_get_name (head)) == 0 ||
+		    strcmp (*ptr, gitg_ref_get_shortname (head)) == 0)
+		{
+			ret = TRUE;
+		}
+		else if (strcmp (*ptr, "--branches") == 0)
+		{
+			ret = ret || gitg_ref_get_ref_type (head) == GITG_REF_TYPE_BRANCH;
+		}
+		else if (!is_ref_name (self, *ptr))
+		{
+			return FALSE;
+		}
+	}
+
+	return ret;
+}
+
+/* The branch HEAD points to, when the commits made on top of it can be
+   inserted into the loaded history */
+static GitgRef *
+updatable_head (GitgRepository *repository)
+{
+	GitgRef *working = repository->priv->working_ref;
+	GitgRef *head;
+
+	if (!gitg_repository_get_loaded (repository) || !working)
+	{
+		return NULL;
+	}
+
+	head = g_hash_table_lookup (repository->priv->ref_names,
+	                            gitg_ref_get_name (working));
+
+	if (!head || !selection_contains_head (repository, head))
+	{
+		return NULL;
+	}
+
+	return head;
+}
+
+/* Returns the command of which the output has to be passed to
+   gitg_repository_update_head to insert the commit sha, which was just
+   created on top of HEAD. Returns NULL when that is not possible (e.g. when
+   HEAD is not part of the selection) and the caller should reload instead */
+GitgCommand *
+gitg_repository_update_head_command (GitgRepository *repository,
+                                     gchar const    *sha)
+{
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), NULL);
+	g_return_val_if_fail (sha != NULL, NULL);
+
+	if (!updatable_head (repository))
+	{
+		return NULL;
+	}
+
+	return gitg_command_new (repository,
+	                         "log",
+	                         "-1",
+	                         "--encoding=UTF-8",
+	                         "--pretty=format:" LOG_FORMAT,
+	                         sha,
+	                         NULL);
+}
+
+/* Insert the commit described by line, the output of the command from
+   gitg_repository_update_head_command, into the loaded history. Returns
+   FALSE when that is not possible (e.g. for amends) and the caller should
+   reload instead */
+gboolean
+gitg_repository_update_head (GitgRepository *repository,
+                             gchar const    *line)
+{
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), FALSE);
+	g_return_val_if_fail (line != NULL, FALSE);
+
+	GitgRef *head = updatable_head (repository);
+	GitgRevision *revision = head ? parse_revision_line (line) : NULL;
+
+	if (!revision)
+	{
+		return FALSE;
+	}
+
+	guint num_parents;
+	GitgHash *parents = gitg_revision_get_parents_hash (revision, &num_parents);
+
+	if (num_parents != 1 ||
+	    !gitg_hash_hash_equal (parents[0], gitg_ref_get_hash (head)) ||
+	    !lookup_row (repository, parents[0], NULL) ||
+	    lookup_row (repository, gitg_revision_get_hash (revision), NULL))
+	{
+		gitg_revision_unref (revision);
+		return FALSE;
+	}
+
+	/* Everything that was staged is now part of the commit */
+	gulong i = 0;
+
+	while (i < repository->priv->size)
+	{
+		gchar sign = gitg_revision_get_sign (repository->priv->storage[i]);
+
+		if (sign == 't')
+		{
+			remove_revision_at (repository, i);
+		}
+		else if (sign == 's' || sign == 'u')
+		{
+			++i;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	insert_revision_at (repository, i, revision);
+
+	/* Move the branch over to the new commit */
+	gchar *sha = gitg_hash_hash_to_sha1_new (gitg_revision_get_hash (revision));
+	gchar *name = g_strdup (gitg_ref_get_name (head));
+	gboolean working = gitg_ref_get_working (head);
+	gpointer pushes = NULL;
+	gboolean has_pushes;
+
+	/* The push targets of the branch stay the same */
+	has_pushes = g_hash_table_lookup_extended (repository->priv->ref_pushes,
+	                                           head,
+	                                           NULL,
+	                                           &pushes);
+
+	if (has_pushes)
+	{
+		g_hash_table_steal (repository->priv->ref_pushes, head);
+	}
+
+	remove_ref (repository, head);
+
+	head = add_ref (repository, sha, name);
+	gitg_ref_set_working (head, working);
+
+	if (has_pushes)
+	{
+		g_hash_table_insert (repository->priv->ref_pushes, head, pushes);
+	}
+
+	if (repository->priv->current_ref &&
+	    strcmp (gitg_ref_get_name (repository->priv->current_ref), name) == 0)
+	{
+		gitg_ref_free (repository->priv->current_ref);
+		repository->priv->current_ref = gitg_ref_copy (head);
+	}
+
+	/* HEAD itself still points to the same branch */
+	gitg_ref_free (repository->priv->working_ref);
+	repository->priv->working_ref = gitg_ref_copy (head);
+	gitg_ref_set_working (repository->priv->working_ref, TRUE);
+
+	gitg_revision_unref (revision);
+	g_free (sha);
+	g_free (name);
+
+	prepare_relane (repository);
+	return TRUE;
+}
+
 gboolean
 gitg_repository_load (GitgRepository  *self,
                       int              argc,
@@ -1562,9 +2477,7 @@ gitg_repository_add (GitgRepository *self,
 	/* put this object in our data storage */
 	self->priv->storage[self->priv->size++] = gitg_revision_ref (obj);
 
-	g_hash_table_insert (self->priv->hashtable,
-	                     (gpointer)gitg_revision_get_hash (obj),
-	                     GUINT_TO_POINTER (self->priv->size - 1));
+	store_row (self, self->priv->size - 1);
 
 	iter1.stamp = self->priv->stamp;
 	iter1.user_data = GINT_TO_POINTER (self->priv->size - 1);
@@ -1595,14 +2508,14 @@ gitg_repository_lookup (GitgRepository *store,
 {
 	g_return_val_if_fail (GITG_IS_REPOSITORY (store), NULL);
 
-	gpointer result = g_hash_table_lookup (store->priv->hashtable, hash);
+	gulong row;
 
-	if (!result)
+	if (!lookup_row (store, hash, &row))
 	{
 		return NULL;
 	}
 
-	return store->priv->storage[GPOINTER_TO_UINT (result)];
+	return store->priv->storage[row];
 }
 
 gboolean
@@ -1612,21 +2525,209 @@ gitg_repository_find_by_hash (GitgRepository *store,
 {
 	g_return_val_if_fail (GITG_IS_REPOSITORY (store), FALSE);
 
-	gpointer result = g_hash_table_lookup (store->priv->hashtable, hash);
+	gulong row;
 
-	if (!result)
+	if (!lookup_row (store, hash, &row))
 	{
 		return FALSE;
 	}
 
-	GtkTreePath *path = gtk_tree_path_new_from_indices (GPOINTER_TO_UINT (result),
-	                                                    -1);
+	GtkTreePath *path = gtk_tree_path_new_from_indices (row, -1);
 	gtk_tree_model_get_iter (GTK_TREE_MODEL (store), iter, path);
 	gtk_tree_path_free (path);
 
 	return TRUE;
 }
 
+gboolean
+gitg_repository_find_by_prefix (GitgRepository *repository,
+                                gchar const    *prefix,
+                                GtkTreeIter    *iter,
+                                gboolean       *ambiguous)
+{
+	GitgHash hash;
+	gint length;
+	GPtrArray *index;
+	guint lower;
+	gulong row;
+
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), FALSE);
+	g_return_val_if_fail (prefix != NULL, FALSE);
+
+	if (ambiguous)
+	{
+		*ambiguous = FALSE;
+	}
+
+	length = gitg_hash_parse_prefix (prefix, hash);
+
+	if (length == 0)
+	{
+		return FALSE;
+	}
+
+	ensure_hash_index (repository);
+	index = repository->priv->hash_index;
+
+	/* Find the first revision not sorting before the prefix */
+	lower = hash_index_lower_bound (index, hash);
+
+	if (lower == index->len ||
+	    !gitg_hash_has_prefix (gitg_revision_get_hash (g_ptr_array_index (index, lower)),
+	                           hash,
+	                           length))
+	{
+		return FALSE;
+	}
+
+	if (lower + 1 < index->len &&
+	    gitg_hash_has_prefix (gitg_revision_get_hash (g_ptr_array_index (index, lower + 1)),
+	                          hash,
+	                          length))
+	{
+		if (ambiguous)
+		{
+			*ambiguous = TRUE;
+		}
+
+		return FALSE;
+	}
+
+	if (iter)
+	{
+		lookup_row (repository,
+		            gitg_revision_get_hash (g_ptr_array_index (index, lower)),
+		            &row);
+
+		fill_iter (repository, row, iter);
+	}
+
+	return TRUE;
+}
+
+/* Returns the ascending row numbers of the revisions of which one of the
+   given fields contains query, ignoring case */
+GArray *
+gitg_repository_search (GitgRepository   *repository,
+                        gchar const      *query,
+                        GitgSearchFields  fields)
+{
+	GArray *candidates = NULL;
+	GArray *ret;
+	gchar *folded;
+	guint f;
+	guint i;
+
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), NULL);
+	g_return_val_if_fail (query != NULL, NULL);
+
+	folded = g_utf8_casefold (query, -1);
+	ensure_search_index (repository);
+
+	for (f = 0; f < G_N_ELEMENTS (search_fields); ++f)
+	{
+		GArray *found;
+
+		if (!(fields & search_fields[f]))
+		{
+			continue;
+		}
+
+		found = gitg_search_index_lookup (repository->priv->search_index,
+		                                  f,
+		                                  folded);
+
+		if (!found)
+		{
+			/* Query too short for the index, check every row */
+			if (candidates)
+			{
+				g_array_free (candidates, TRUE);
+			}
+
+			candidates = NULL;
+			break;
+		}
+
+		if (!candidates)
+		{
+			candidates = found;
+		}
+		else
+		{
+			g_array_append_vals (candidates, found->data, found->len);
+			g_array_free (found, TRUE);
+		}
+	}
+
+	ret = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	if (!candidates)
+	{
+		for (i = 0; i < repository->priv->size; ++i)
+		{
+			if (revision_matches (repository->priv->storage[i], folded, fields))
+			{
+				g_array_append_val (ret, i);
+			}
+		}
+	}
+	else
+	{
+		glong first = first_stored_row (repository);
+
+		/* The head rows are not in the index */
+		for (i = 0; i < repository->priv->head_rows; ++i)
+		{
+			if (revision_matches (repository->priv->storage[i], folded, fields))
+			{
+				g_array_append_val (ret, i);
+			}
+		}
+
+		/* Candidates of multiple fields may overlap */
+		g_array_sort (candidates, compare_row);
+
+		for (i = 0; i < candidates->len; ++i)
+		{
+			guint stored = g_array_index (candidates, guint, i);
+			guint row;
+
+			if ((i > 0 && g_array_index (candidates, guint, i - 1) == stored) ||
+			    (glong)stored < first)
+			{
+				continue;
+			}
+
+			row = stored + repository->priv->row_offset;
+
+			if (revision_matches (repository->priv->storage[row], folded, fields))
+			{
+				g_array_append_val (ret, row);
+			}
+		}
+
+		g_array_free (candidates, TRUE);
+	}
+
+	g_free (folded);
+	return ret;
+}
+
+/* Whether row is one of the rows returned by gitg_repository_search */
+gboolean
+gitg_repository_search_contains (GArray *rows,
+                                 guint   row)
+{
+	g_return_val_if_fail (rows != NULL, FALSE);
+
+	return bsearch (&row,
+	                rows->data,
+	                rows->len,
+	                sizeof (guint),
+	                compare_row) != NULL;
+}
+
 gboolean
 gitg_repository_find (GitgRepository *store,
                       GitgRevision   *revision,
@@ -1650,35 +2751,109 @@ ref_compare (GitgRef *a,
 	}
 	else
 	{
-		return g_strcmp0 (gitg_ref_get_shortname (a),
-		                  gitg_ref_get_shortname (b));
+		gint ret = g_ascii_strcasecmp (gitg_ref_get_shortname (a),
+		                               gitg_ref_get_shortname (b));
+
+		return ret != 0 ? ret : g_strcmp0 (gitg_ref_get_shortname (a),
+		                                   gitg_ref_get_shortname (b));
+	}
+}
+
+static gint
+ref_index_compare (gconstpointer a,
+                   gconstpointer b)
+{
+	return ref_compare (*(GitgRef * const *)a, *(GitgRef * const *)b);
+}
+
+static void
+ensure_ref_index (GitgRepository *repository)
+{
+	if (!repository->priv->ref_index_sorted)
+	{
+		g_ptr_array_sort (repository->priv->ref_index, ref_index_compare);
+		repository->priv->ref_index_sorted = TRUE;
 	}
 }
 
+static GSList *
+copy_ref_range (GitgRepository *repository,
+                guint           start,
+                guint           end)
+{
+	GSList *ret = NULL;
+
+	while (end > start)
+	{
+		--end;
+		ret = g_slist_prepend (ret,
+		                       gitg_ref_copy (g_ptr_array_index (repository->priv->ref_index,
+		                                                         end)));
+	}
+
+	return ret;
+}
+
 GSList *
 gitg_repository_get_refs (GitgRepository *repository)
 {
 	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), NULL);
 
-	GList *values = g_hash_table_get_values (repository->priv->refs);
-	GSList *ret = NULL;
-	GList *item;
+	ensure_ref_index (repository);
 
-	for (item = values; item; item = item->next)
+	return copy_ref_range (repository, 0, repository->priv->ref_index->len);
+}
+
+/* Refs of a single type, sorted by name */
+GSList *
+gitg_repository_get_refs_by_type (GitgRepository *repository,
+                                  GitgRefType     type)
+{
+	GPtrArray *index;
+	guint start = 0;
+	guint end;
+
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), NULL);
+
+	ensure_ref_index (repository);
+	index = repository->priv->ref_index;
+
+	end = index->len;
+
+	/* Find the first ref of this type */
+	while (start < end)
 	{
-		GSList *val;
+		guint mid = start + (end - start) / 2;
 
-		for (val = item->data; val; val = val->next)
+		if (gitg_ref_get_ref_type (g_ptr_array_index (index, mid)) < type)
+		{
+			start = mid + 1;
+		}
+		else
 		{
-			ret = g_slist_insert_sorted (ret,
-			                             gitg_ref_copy (val->data),
-			                             (GCompareFunc)ref_compare);
+			end = mid;
 		}
 	}
 
-	g_list_free (values);
+	end = start;
 
-	return ret;
+	while (end < index->len &&
+	       gitg_ref_get_ref_type (g_ptr_array_index (index, end)) == type)
+	{
+		++end;
+	}
+
+	return copy_ref_range (repository, start, end);
+}
+
+GitgRef *
+gitg_repository_lookup_ref (GitgRepository *repository,
+                            gchar const    *name)
+{
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+
+	return g_hash_table_lookup (repository->priv->ref_names, name);
 }
 
 GSList *
@@ -1893,7 +3068,46 @@ gitg_repository_get_loaded (GitgRepository *repository)
 	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), FALSE);
 
 	return repository->priv->load_stage == LOAD_STAGE_LAST &&
-	       !gitg_io_get_running (GITG_IO (repository->priv->loader));
+	       (repository->priv->commits_paused ||
+	        !gitg_io_get_running (GITG_IO (repository->priv->loader)));
+}
+
+gboolean
+gitg_repository_get_has_more (GitgRepository *repository)
+{
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), FALSE);
+
+	return repository->priv->has_more;
+}
+
+/* Load the next page of history, continuing the lanes of the rows that
+   are already loaded. Emits "loaded" again when the page is in */
+gboolean
+gitg_repository_load_more (GitgRepository *repository)
+{
+	g_return_val_if_fail (GITG_IS_REPOSITORY (repository), FALSE);
+
+	if (!repository->priv->has_more ||
+	    !gitg_repository_get_loaded (repository))
+	{
+		return FALSE;
+	}
+
+	repository->priv->load_stage = LOAD_STAGE_COMMITS;
+
+	repository->priv->page_loaded = 0;
+	repository->priv->has_more = FALSE;
+	repository->priv->commits_paused = FALSE;
+
+	if (repository->priv->idle_page_id)
+	{
+		g_source_remove (repository->priv->idle_page_id);
+		repository->priv->idle_page_id = 0;
+	}
+
+	/* Continue reading the log where the previous page stopped */
+	gitg_shell_set_paused (repository->priv->loader, FALSE);
+	return TRUE;
 }
 
 gchar const **
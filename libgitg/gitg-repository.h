@@ -43,6 +43,7 @@ typedef struct _GitgRepositoryClass	GitgRepositoryClass;
 typedef struct _GitgRepositoryPrivate	GitgRepositoryPrivate;
 
 struct _GitgShell;
+struct _GitgCommand;
 
 typedef enum
 {
@@ -50,6 +51,13 @@ typedef enum
 	GITG_REPOSITORY_ERROR_NOT_FOUND
 } GitgRepositoryError;
 
+typedef enum
+{
+	GITG_SEARCH_SUBJECT = 1 << 0,
+	GITG_SEARCH_AUTHOR = 1 << 1,
+	GITG_SEARCH_AUTHOR_EMAIL = 1 << 2
+} GitgSearchFields;
+
 struct _GitgRepository
 {
 	GObject parent;
@@ -77,16 +85,23 @@ gboolean gitg_repository_exists (GitgRepository *repository);
 
 gboolean gitg_repository_load(GitgRepository *repository, int argc, gchar const **argv, GError **error);
 gboolean gitg_repository_get_loaded(GitgRepository *repository);
+gboolean gitg_repository_get_has_more (GitgRepository *repository);
+gboolean gitg_repository_load_more (GitgRepository *repository);
 
 void gitg_repository_add(GitgRepository *repository, GitgRevision *revision, GtkTreeIter *iter);
 void gitg_repository_clear(GitgRepository *repository);
 
 gboolean gitg_repository_find_by_hash(GitgRepository *self, gchar const *hash, GtkTreeIter *iter);
+gboolean gitg_repository_find_by_prefix (GitgRepository *repository, gchar const *prefix, GtkTreeIter *iter, gboolean *ambiguous);
+GArray *gitg_repository_search (GitgRepository *repository, gchar const *query, GitgSearchFields fields);
+gboolean gitg_repository_search_contains (GArray *rows, guint row);
 gboolean gitg_repository_find(GitgRepository *store, GitgRevision *revision, GtkTreeIter *iter);
 GitgRevision *gitg_repository_lookup(GitgRepository *store, gchar const *hash);
 
 GSList *gitg_repository_get_refs(GitgRepository *repository);
 GSList *gitg_repository_get_refs_for_hash(GitgRepository *repository, gchar const *hash);
+GSList *gitg_repository_get_refs_by_type (GitgRepository *repository, GitgRefType type);
+GitgRef *gitg_repository_lookup_ref (GitgRepository *repository, gchar const *name);
 GitgRef *gitg_repository_get_current_ref(GitgRepository *repository);
 GitgRef *gitg_repository_get_current_working_ref(GitgRepository *repository);
 
@@ -96,8 +111,11 @@ gchar *gitg_repository_parse_ref(GitgRepository *repository, gchar const *ref);
 gchar *gitg_repository_parse_head(GitgRepository *repository);
 
 void gitg_repository_reload(GitgRepository *repository);
+struct _GitgCommand *gitg_repository_update_head_command (GitgRepository *repository, gchar const *sha);
+gboolean gitg_repository_update_head (GitgRepository *repository, gchar const *line);
 
 struct _GitgShell *gitg_repository_get_loader (GitgRepository *repository);
+struct _GitgCommitCache *gitg_repository_get_commit_cache (GitgRepository *repository);
 
 gchar **gitg_repository_get_remotes (GitgRepository *repository);
 GSList const *gitg_repository_get_ref_pushes (GitgRepository *repository, GitgRef *ref);
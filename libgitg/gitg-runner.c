@@ -30,6 +30,7 @@
 #include <sys/wait.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include <gio/gunixoutputstream.h>
 #include <gio/gunixinputstream.h>
@@ -43,6 +44,9 @@ struct _GitgRunnerPrivate
 	GInputStream *stdout;
 	GOutputStream *stdin;
 
+	GitgSmartCharsetConverter *converter;
+	gboolean raw;
+
 	GCancellable *cancellable;
 	gboolean cancelled;
 
@@ -52,6 +56,13 @@ struct _GitgRunnerPrivate
 
 G_DEFINE_TYPE (GitgRunner, gitg_runner, GITG_TYPE_IO)
 
+/* Converters are reused between runners, they keep the charset converters
+   they made while guessing */
+#define CONVERTER_POOL_SIZE 8
+
+static GQueue converter_pool = G_QUEUE_INIT;
+G_LOCK_DEFINE_STATIC (converter_pool);
+
 enum
 {
 	PROP_0,
@@ -90,6 +101,73 @@ gitg_runner_finalize (GObject *object)
 	G_OBJECT_CLASS (gitg_runner_parent_class)->finalize (object);
 }
 
+static GitgSmartCharsetConverter *
+acquire_converter (void)
+{
+	GitgSmartCharsetConverter *smart;
+
+	G_LOCK (converter_pool);
+	smart = g_queue_pop_head (&converter_pool);
+	G_UNLOCK (converter_pool);
+
+	if (smart == NULL)
+	{
+		smart = gitg_smart_charset_converter_new (gitg_encoding_get_candidates ());
+	}
+
+	return smart;
+}
+
+static gboolean
+pool_converter (GitgSmartCharsetConverter *smart)
+{
+	gboolean pooled = FALSE;
+
+	G_LOCK (converter_pool);
+
+	if (g_queue_get_length (&converter_pool) < CONVERTER_POOL_SIZE)
+	{
+		g_converter_reset (G_CONVERTER (smart));
+		gitg_smart_charset_converter_set_hint (smart, NULL);
+
+		g_queue_push_head (&converter_pool, smart);
+		pooled = TRUE;
+	}
+
+	G_UNLOCK (converter_pool);
+
+	return pooled;
+}
+
+static void
+on_converter_toggled (gpointer  data,
+                      GObject  *object,
+                      gboolean  is_last_ref)
+{
+	if (!is_last_ref)
+	{
+		return;
+	}
+
+	/* Only the toggle reference is left, keep a normal one in the pool */
+	g_object_ref (object);
+	g_object_remove_toggle_ref (object, on_converter_toggled, NULL);
+
+	if (!pool_converter (GITG_SMART_CHARSET_CONVERTER (object)))
+	{
+		g_object_unref (object);
+	}
+}
+
+static void
+release_converter (GitgSmartCharsetConverter *smart)
+{
+	/* A pending splice may still be reading through it, so it is only
+	   pooled once the last other reference is dropped */
+	g_object_add_toggle_ref (G_OBJECT (smart), on_converter_toggled, NULL);
+	g_object_unref (smart);
+}
+
 static void
 close_streams (GitgRunner *runner)
 {
@@ -114,6 +192,12 @@ close_streams (GitgRunner *runner)
 		runner->priv->stdout = NULL;
 	}
 
+	if (runner->priv->converter != NULL)
+	{
+		release_converter (runner->priv->converter);
+		runner->priv->converter = NULL;
+	}
+
 	gitg_io_close (GITG_IO (runner));
 }
 
@@ -202,10 +286,49 @@ kill_process (GitgRunner *runner)
 	gitg_io_set_exit_status (GITG_IO (runner), EXIT_FAILURE);
 }
 
+static GQuark
+encoding_quark (void)
+{
+	static GQuark quark = 0;
+
+	if (G_UNLIKELY (quark == 0))
+	{
+		quark = g_quark_from_static_string ("GitgRunnerEncoding");
+	}
+
+	return quark;
+}
+
+static void
+remember_encoding (GitgRunner *runner)
+{
+	GitgRepository *repository;
+	GitgEncoding const *encoding;
+
+	repository = gitg_command_get_repository (runner->priv->command);
+
+	if (!repository || !runner->priv->converter)
+	{
+		return;
+	}
+
+	encoding = gitg_smart_charset_converter_get_guessed (runner->priv->converter);
+
+	/* Output that is not UTF-8 is most likely in the same encoding as
+	   the previous one that was not, so that one is tried first */
+	if (encoding && encoding != gitg_encoding_get_utf8 ())
+	{
+		g_object_set_qdata (G_OBJECT (repository),
+		                    encoding_quark (),
+		                    (gpointer)encoding);
+	}
+}
+
 static void
 runner_done (GitgRunner *runner,
              GError     *error)
 {
+	remember_encoding (runner);
 	close_streams (runner);
 	kill_process (runner);
 
@@ -412,6 +535,13 @@ process_watch_cb (GPid        pid,
 	}
 }
 
+static void
+merge_error_setup (gpointer user_data)
+{
+	/* Runs in the child, after its output has been redirected */
+	dup2 (STDOUT_FILENO, STDERR_FILENO);
+}
+
 void
 gitg_runner_run (GitgRunner *runner)
 {
@@ -423,8 +553,8 @@ gitg_runner_run (GitgRunner *runner)
 	GInputStream *start_input;
 	GOutputStream *end_output;
 	GInputStream *output;
-	GitgSmartCharsetConverter *smart;
 	GError *error = NULL;
+	gboolean merge_error;
 
 	g_return_if_fail (GITG_IS_RUNNER (runner));
 
@@ -441,13 +571,14 @@ gitg_runner_run (GitgRunner *runner)
 	}
 
 	start_input = gitg_io_get_input (GITG_IO (runner));
+	merge_error = gitg_command_get_merge_error (runner->priv->command);
 
 	ret = g_spawn_async_with_pipes (wd_path,
 	                                (gchar **)gitg_command_get_arguments (runner->priv->command),
 	                                (gchar **)gitg_command_get_environment (runner->priv->command),
 	                                G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD |
-	                                (gitg_debug_enabled (GITG_DEBUG_RUNNER) ? 0 : G_SPAWN_STDERR_TO_DEV_NULL),
-	                                NULL,
+	                                (gitg_debug_enabled (GITG_DEBUG_RUNNER) || merge_error ? 0 : G_SPAWN_STDERR_TO_DEV_NULL),
+	                                merge_error ? merge_error_setup : NULL,
 	                                NULL,
 	                                &(runner->priv->pid),
 	                                start_input ? &stdinf : NULL,
@@ -495,13 +626,29 @@ gitg_runner_run (GitgRunner *runner)
 	output = G_INPUT_STREAM (g_unix_input_stream_new (stdoutf,
 	                                                  TRUE));
 
-	smart = gitg_smart_charset_converter_new (gitg_encoding_get_candidates ());
+	if (runner->priv->raw)
+	{
+		runner->priv->stdout = output;
+	}
+	else
+	{
+		runner->priv->converter = acquire_converter ();
 
-	runner->priv->stdout = g_converter_input_stream_new (output,
-	                                                     G_CONVERTER (smart));
+		if (gitg_command_get_repository (runner->priv->command))
+		{
+			GObject *repository;
 
-	g_object_unref (smart);
-	g_object_unref (output);
+			repository = G_OBJECT (gitg_command_get_repository (runner->priv->command));
+			gitg_smart_charset_converter_set_hint (runner->priv->converter,
+			                                       g_object_get_qdata (repository,
+			                                                           encoding_quark ()));
+		}
+
+		runner->priv->stdout = g_converter_input_stream_new (output,
+		                                                     G_CONVERTER (runner->priv->converter));
+
+		g_object_unref (output);
+	}
 
 	end_output = gitg_io_get_output (GITG_IO (runner));
 
@@ -551,6 +698,17 @@ gitg_runner_set_command (GitgRunner *runner, GitgCommand *command)
 	g_object_notify (G_OBJECT (runner), "command");
 }
 
+/* Pass the output of the command on as is instead of converting it to
+   UTF-8. Must be set before running */
+void
+gitg_runner_set_raw (GitgRunner *runner,
+                     gboolean    raw)
+{
+	g_return_if_fail (GITG_IS_RUNNER (runner));
+
+	runner->priv->raw = raw;
+}
+
 GitgCommand *
 gitg_runner_get_command (GitgRunner *runner)
 {
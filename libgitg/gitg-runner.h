@@ -68,6 +68,8 @@ void gitg_runner_run (GitgRunner *runner);
 GitgCommand *gitg_runner_get_command (GitgRunner *runner);
 void gitg_runner_set_command (GitgRunner *runner, GitgCommand *command);
 
+void gitg_runner_set_raw (GitgRunner *runner, gboolean raw);
+
 GInputStream *gitg_runner_get_stream (GitgRunner *runner);
 void gitg_runner_stream_close (GitgRunner *runner, GError *error);
 
@@ -0,0 +1,207 @@
+/*
+ * gitg-search-index.c
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "gitg-search-index.h"
+
+#include <string.h>
+
+/* Trigram index over casefolded text. Every trigram of a field maps to the
+   ascending list of ids containing it. Ids have to be added in ascending
+   order, which keeps the lists sorted without sorting them. */
+struct _GitgSearchIndex
+{
+	GHashTable *trigrams;
+};
+
+static guint
+trigram_key (guint        field,
+             gchar const *text)
+{
+	guchar const *p = (guchar const *)text;
+
+	return (field << 24) | (p[0] << 16) | (p[1] << 8) | p[2];
+}
+
+static void
+free_postings (GArray *postings)
+{
+	g_array_free (postings, TRUE);
+}
+
+GitgSearchIndex *
+gitg_search_index_new (void)
+{
+	GitgSearchIndex *index = g_slice_new (GitgSearchIndex);
+
+	index->trigrams = g_hash_table_new_full (g_direct_hash,
+	                                         g_direct_equal,
+	                                         NULL,
+	                                         (GDestroyNotify)free_postings);
+
+	return index;
+}
+
+void
+gitg_search_index_free (GitgSearchIndex *index)
+{
+	if (!index)
+	{
+		return;
+	}
+
+	g_hash_table_destroy (index->trigrams);
+	g_slice_free (GitgSearchIndex, index);
+}
+
+void
+gitg_search_index_clear (GitgSearchIndex *index)
+{
+	g_hash_table_remove_all (index->trigrams);
+}
+
+void
+gitg_search_index_add (GitgSearchIndex *index,
+                       guint            id,
+                       guint            field,
+                       gchar const     *folded)
+{
+	gsize len = strlen (folded);
+	gsize i;
+
+	for (i = 0; i + 3 <= len; ++i)
+	{
+		gpointer key = GUINT_TO_POINTER (trigram_key (field, folded + i));
+		GArray *postings = g_hash_table_lookup (index->trigrams, key);
+
+		if (!postings)
+		{
+			postings = g_array_sized_new (FALSE, FALSE, sizeof (guint), 1);
+			g_hash_table_insert (index->trigrams, key, postings);
+		}
+		else if (g_array_index (postings, guint, postings->len - 1) == id)
+		{
+			/* Trigram occurs more than once in this field */
+			continue;
+		}
+
+		g_array_append_val (postings, id);
+	}
+}
+
+static gboolean
+postings_contain (GArray *postings,
+                  guint   id)
+{
+	guint lower = 0;
+	guint upper = postings->len;
+
+	while (lower < upper)
+	{
+		guint mid = lower + (upper - lower) / 2;
+		guint val = g_array_index (postings, guint, mid);
+
+		if (val == id)
+		{
+			return TRUE;
+		}
+		else if (val < id)
+		{
+			lower = mid + 1;
+		}
+		else
+		{
+			upper = mid;
+		}
+	}
+
+	return FALSE;
+}
+
+/* Returns the ascending ids of which the field contains every trigram of
+   folded. These are candidates only, the caller still has to check the
+   text itself. Returns NULL when folded is too short to narrow down the
+   candidates at all. */
+GArray *
+gitg_search_index_lookup (GitgSearchIndex *index,
+                          guint            field,
+                          gchar const     *folded)
+{
+	gsize len = strlen (folded);
+	GPtrArray *lists;
+	GArray *shortest = NULL;
+	GArray *ret;
+	gsize i;
+
+	if (len < 3)
+	{
+		return NULL;
+	}
+
+	ret = g_array_new (FALSE, FALSE, sizeof (guint));
+	lists = g_ptr_array_new ();
+
+	for (i = 0; i + 3 <= len; ++i)
+	{
+		GArray *postings;
+
+		postings = g_hash_table_lookup (index->trigrams,
+		                                GUINT_TO_POINTER (trigram_key (field, folded + i)));
+
+		if (!postings)
+		{
+			g_ptr_array_free (lists, TRUE);
+			return ret;
+		}
+
+		g_ptr_array_add (lists, postings);
+
+		if (!shortest || postings->len < shortest->len)
+		{
+			shortest = postings;
+		}
+	}
+
+	/* Intersect all the lists, walking the shortest one */
+	for (i = 0; i < shortest->len; ++i)
+	{
+		guint id = g_array_index (shortest, guint, i);
+		guint j;
+
+		for (j = 0; j < lists->len; ++j)
+		{
+			GArray *postings = g_ptr_array_index (lists, j);
+
+			if (postings != shortest && !postings_contain (postings, id))
+			{
+				break;
+			}
+		}
+
+		if (j == lists->len)
+		{
+			g_array_append_val (ret, id);
+		}
+	}
+
+	g_ptr_array_free (lists, TRUE);
+	return ret;
+}
@@ -0,0 +1,47 @@
+/*
+ * gitg-search-index.h
+ * This file is part of gitg - git repository viewer
+ *
+ * Copyright (C) 2011 - Jesse van den Kieboom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GITG_SEARCH_INDEX_H__
+#define __GITG_SEARCH_INDEX_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GitgSearchIndex GitgSearchIndex;
+
+GitgSearchIndex *gitg_search_index_new    (void);
+void             gitg_search_index_free   (GitgSearchIndex *index);
+void             gitg_search_index_clear  (GitgSearchIndex *index);
+
+void             gitg_search_index_add    (GitgSearchIndex *index,
+                                           guint            id,
+                                           guint            field,
+                                           gchar const     *folded);
+
+GArray          *gitg_search_index_lookup (GitgSearchIndex *index,
+                                           guint            field,
+                                           gchar const     *folded);
+
+G_END_DECLS
+
+#endif /* __GITG_SEARCH_INDEX_H__ */
@@ -56,7 +56,8 @@ enum
 
 	PROP_BUFFER_SIZE,
 	PROP_SYNCHRONIZED,
-	PROP_PRESERVE_LINE_ENDINGS
+	PROP_PRESERVE_LINE_ENDINGS,
+	PROP_NUL_SEPARATED
 };
 
 struct _GitgShellPrivate
@@ -74,6 +75,7 @@ struct _GitgShellPrivate
 
 	guint synchronized : 1;
 	guint preserve_line_endings : 1;
+	guint nul_separated : 1;
 	guint cancelled : 1;
 	guint read_done : 1;
 };
@@ -172,6 +174,9 @@ gitg_shell_get_property (GObject    *object,
 		case PROP_PRESERVE_LINE_ENDINGS:
 			g_value_set_boolean (value, shell->priv->preserve_line_endings);
 			break;
+		case PROP_NUL_SEPARATED:
+			g_value_set_boolean (value, shell->priv->nul_separated);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -197,6 +202,9 @@ gitg_shell_set_property (GObject      *object,
 		case PROP_PRESERVE_LINE_ENDINGS:
 			shell->priv->preserve_line_endings = g_value_get_boolean (value);
 			break;
+		case PROP_NUL_SEPARATED:
+			shell->priv->nul_separated = g_value_get_boolean (value);
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -265,6 +273,14 @@ gitg_shell_class_init (GitgShellClass *klass)
 	                                                       FALSE,
 	                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
 
+	g_object_class_install_property (object_class,
+	                                 PROP_NUL_SEPARATED,
+	                                 g_param_spec_boolean ("nul-separated",
+	                                                       "NUL Separated",
+	                                                       "split output on NUL instead of newlines",
+	                                                       FALSE,
+	                                                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT));
+
 	shell_signals[UPDATE] =
 		g_signal_new ("update",
 		              G_OBJECT_CLASS_TYPE (object_class),
@@ -332,6 +348,49 @@ gitg_shell_get_preserve_line_endings (GitgShell *shell)
 	return shell->priv->preserve_line_endings;
 }
 
+void
+gitg_shell_set_nul_separated (GitgShell *shell,
+                              gboolean   nul_separated)
+{
+	g_return_if_fail (GITG_IS_SHELL (shell));
+
+	shell->priv->nul_separated = nul_separated;
+	g_object_notify (G_OBJECT (shell), "nul-separated");
+}
+
+gboolean
+gitg_shell_get_nul_separated (GitgShell *shell)
+{
+	g_return_val_if_fail (GITG_IS_SHELL (shell), FALSE);
+
+	return shell->priv->nul_separated;
+}
+
+/* Stops reading the output of the running commands until unpaused, which
+   blocks them once the pipe is full */
+void
+gitg_shell_set_paused (GitgShell *shell,
+                       gboolean   paused)
+{
+	g_return_if_fail (GITG_IS_SHELL (shell));
+
+	if (shell->priv->line_parser)
+	{
+		gitg_line_parser_set_paused (shell->priv->line_parser, paused);
+	}
+}
+
+/* Whether the output read so far had a NUL byte in it, for telling
+   binary output apart when not NUL separated */
+gboolean
+gitg_shell_get_seen_nul (GitgShell *shell)
+{
+	g_return_val_if_fail (GITG_IS_SHELL (shell), FALSE);
+
+	return shell->priv->line_parser &&
+	       gitg_line_parser_get_seen_nul (shell->priv->line_parser);
+}
+
 static void
 shell_done (GitgShell *shell,
             GError    *error)
@@ -419,12 +478,57 @@ on_lines_done_cb (GitgLineParser *parser,
 	}
 }
 
+/* Returns the records converted to UTF-8, or NULL when they all are
+   valid already */
+static gchar **
+convert_records (gchar **lines)
+{
+	gchar **ret;
+	guint num;
+	guint i;
+
+	for (i = 0; lines[i]; ++i)
+	{
+		if (!g_utf8_validate (lines[i], -1, NULL))
+		{
+			break;
+		}
+	}
+
+	if (!lines[i])
+	{
+		return NULL;
+	}
+
+	num = g_strv_length (lines);
+	ret = g_new (gchar *, num + 1);
+
+	for (i = 0; i < num; ++i)
+	{
+		ret[i] = gitg_convert_utf8 (lines[i], -1);
+	}
+
+	ret[num] = NULL;
+	return ret;
+}
+
 static void
 on_lines_cb (GitgLineParser  *parser,
              gchar          **lines,
              GitgShell       *shell)
 {
-	g_signal_emit (shell, shell_signals[UPDATE], 0, lines);
+	gchar **converted = NULL;
+
+	/* NUL separated output is read raw, the NULs would throw off
+	   guessing the encoding of the whole block */
+	if (shell->priv->nul_separated)
+	{
+		converted = convert_records (lines);
+	}
+
+	g_signal_emit (shell, shell_signals[UPDATE], 0, converted ? converted : lines);
+
+	g_strfreev (converted);
 }
 
 static void
@@ -438,6 +542,11 @@ run_stream (GitgShell    *shell,
 	shell->priv->line_parser = gitg_line_parser_new (shell->priv->buffer_size,
 	                                                 shell->priv->preserve_line_endings);
 
+	g_object_set (shell->priv->line_parser,
+	              "nul-separated",
+	              shell->priv->nul_separated,
+	              NULL);
+
 	g_signal_connect (shell->priv->line_parser,
 	                  "lines",
 	                  G_CALLBACK (on_lines_cb),
@@ -525,6 +634,11 @@ run_commands (GitgShell    *shell,
 			{
 				gitg_io_set_output (GITG_IO (runner), output);
 			}
+			else if (shell->priv->nul_separated)
+			{
+				/* Records are converted one by one when parsed */
+				gitg_runner_set_raw (runner, TRUE);
+			}
 		}
 
 		shell->priv->runners = g_slist_append (shell->priv->runners,
@@ -69,6 +69,15 @@ void       gitg_shell_set_preserve_line_endings (GitgShell    *shell,
                                                  gboolean      preserve_line_endings);
 gboolean   gitg_shell_get_preserve_line_endings (GitgShell    *shell);
 
+void       gitg_shell_set_nul_separated         (GitgShell    *shell,
+                                                 gboolean      nul_separated);
+gboolean   gitg_shell_get_nul_separated         (GitgShell    *shell);
+
+void       gitg_shell_set_paused                (GitgShell    *shell,
+                                                 gboolean      paused);
+
+gboolean   gitg_shell_get_seen_nul              (GitgShell    *shell);
+
 guint      gitg_shell_get_buffer_size           (GitgShell    *shell);
 
 GitgCommand **gitg_shell_parse_commands         (GitgRepository  *repository,
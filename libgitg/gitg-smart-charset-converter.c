@@ -24,6 +24,7 @@
 
 #include <gio/gio.h>
 #include <glib/gi18n.h>
+#include <string.h>
 
 #define GITG_SMART_CHARSET_CONVERTER_GET_PRIVATE(object)(G_TYPE_INSTANCE_GET_PRIVATE((object), GITG_TYPE_SMART_CHARSET_CONVERTER, GitgSmartCharsetConverterPrivate))
 
@@ -31,9 +32,15 @@ struct _GitgSmartCharsetConverterPrivate
 {
 	GCharsetConverter *charset_conv;
 
+	/* Charset converters by encoding, kept across resets */
+	GHashTable *charset_convs;
+
 	GSList *encodings;
 	GSList *current_encoding;
 
+	const GitgEncoding *hint;
+	const GitgEncoding *guessed;
+
 	guint is_utf8 : 1;
 	guint use_first : 1;
 };
@@ -79,6 +86,12 @@ gitg_smart_charset_converter_dispose (GObject *object)
 		smart->priv->charset_conv = NULL;
 	}
 
+	if (smart->priv->charset_convs != NULL)
+	{
+		g_hash_table_destroy (smart->priv->charset_convs);
+		smart->priv->charset_convs = NULL;
+	}
+
 	G_OBJECT_CLASS (gitg_smart_charset_converter_parent_class)->dispose (object);
 }
 
@@ -99,12 +112,50 @@ gitg_smart_charset_converter_init (GitgSmartCharsetConverter *smart)
 	smart->priv = GITG_SMART_CHARSET_CONVERTER_GET_PRIVATE (smart);
 
 	smart->priv->charset_conv = NULL;
+	smart->priv->charset_convs = g_hash_table_new_full (g_direct_hash,
+	                                                    g_direct_equal,
+	                                                    NULL,
+	                                                    (GDestroyNotify)g_object_unref);
 	smart->priv->encodings = NULL;
 	smart->priv->current_encoding = NULL;
+	smart->priv->hint = NULL;
+	smart->priv->guessed = NULL;
 	smart->priv->is_utf8 = FALSE;
 	smart->priv->use_first = FALSE;
 }
 
+/* 0x0101...01 and 0x8080...80 for the size of a long */
+#define WORD_ONES ((gulong)-1 / 0xff)
+#define WORD_HIGHS (WORD_ONES * 0x80)
+
+static gboolean
+validate_utf8 (const gchar  *inbuf,
+               gsize         inbuf_size,
+               const gchar **end)
+{
+	const gchar *ptr = inbuf;
+	const gchar *stop = inbuf + inbuf_size;
+
+	/* Skip plain ASCII a word at a time, which is what most of the
+	   output of git is. A word is plain ASCII when no byte has the high
+	   bit set and no byte is NUL (which g_utf8_validate rejects). */
+	while (ptr + sizeof (gulong) <= stop)
+	{
+		gulong word;
+
+		memcpy (&word, ptr, sizeof (gulong));
+
+		if (((word | ((word - WORD_ONES) & ~word)) & WORD_HIGHS) != 0)
+		{
+			break;
+		}
+
+		ptr += sizeof (gulong);
+	}
+
+	return g_utf8_validate (ptr, stop - ptr, end);
+}
+
 static const GitgEncoding *
 get_encoding (GitgSmartCharsetConverter *smart)
 {
@@ -131,6 +182,35 @@ get_encoding (GitgSmartCharsetConverter *smart)
 	return NULL;
 }
 
+static GCharsetConverter *
+get_charset_converter (GitgSmartCharsetConverter *smart,
+                       const GitgEncoding        *enc)
+{
+	GCharsetConverter *conv;
+
+	conv = g_hash_table_lookup (smart->priv->charset_convs, enc);
+
+	if (conv == NULL)
+	{
+		conv = g_charset_converter_new ("UTF-8",
+		                                gitg_encoding_get_charset (enc),
+		                                NULL);
+
+		if (conv == NULL)
+		{
+			return NULL;
+		}
+
+		g_hash_table_insert (smart->priv->charset_convs, (gpointer)enc, conv);
+	}
+	else
+	{
+		g_converter_reset (G_CONVERTER (conv));
+	}
+
+	return conv;
+}
+
 static gboolean
 try_convert (GCharsetConverter *converter,
              const void        *inbuf,
@@ -209,6 +289,8 @@ guess_encoding (GitgSmartCharsetConverter *smart,
 		gsize                       inbuf_size)
 {
 	GCharsetConverter *conv = NULL;
+	const GitgEncoding *enc = NULL;
+	const gchar *end;
 
 	if (inbuf == NULL || inbuf_size == 0)
 	{
@@ -216,6 +298,31 @@ guess_encoding (GitgSmartCharsetConverter *smart,
 		return NULL;
 	}
 
+	/* Valid UTF-8 is passed through as is, whatever the candidates. The
+	   end may be cut off in the middle of a character. */
+	if (validate_utf8 (inbuf, inbuf_size, &end) ||
+	    inbuf_size - (end - (const gchar *)inbuf) < 6)
+	{
+		smart->priv->is_utf8 = TRUE;
+		return NULL;
+	}
+
+	if (smart->priv->hint != NULL &&
+	    smart->priv->hint != gitg_encoding_get_utf8 ())
+	{
+		conv = get_charset_converter (smart, smart->priv->hint);
+
+		if (conv != NULL && try_convert (conv, inbuf, inbuf_size))
+		{
+			smart->priv->guessed = smart->priv->hint;
+			g_converter_reset (G_CONVERTER (conv));
+
+			return g_object_ref (conv);
+		}
+
+		conv = NULL;
+	}
+
 	if (smart->priv->encodings != NULL &&
 	    smart->priv->encodings->next == NULL)
 	{
@@ -225,13 +332,7 @@ guess_encoding (GitgSmartCharsetConverter *smart,
 	/* We just check the first block */
 	while (TRUE)
 	{
-		const GitgEncoding *enc;
-
-		if (conv != NULL)
-		{
-			g_object_unref (conv);
-			conv = NULL;
-		}
+		conv = NULL;
 
 		/* We get an encoding from the list */
 		enc = get_encoding (smart);
@@ -244,19 +345,8 @@ guess_encoding (GitgSmartCharsetConverter *smart,
 
 		if (enc == gitg_encoding_get_utf8 ())
 		{
-			gsize remainder;
-			const gchar *end;
-			
-			if (g_utf8_validate (inbuf, inbuf_size, &end) ||
-			    smart->priv->use_first)
-			{
-				smart->priv->is_utf8 = TRUE;
-				break;
-			}
-
-			/* Check if the end is less than one char */
-			remainder = inbuf_size - (end - (gchar *)inbuf);
-			if (remainder < 6)
+			/* Validated above already */
+			if (smart->priv->use_first)
 			{
 				smart->priv->is_utf8 = TRUE;
 				break;
@@ -265,9 +355,7 @@ guess_encoding (GitgSmartCharsetConverter *smart,
 			continue;
 		}
 
-		conv = g_charset_converter_new ("UTF-8",
-						gitg_encoding_get_charset (enc),
-						NULL);
+		conv = get_charset_converter (smart, enc);
 
 		/* If we tried all encodings we use the first one */
 		if (smart->priv->use_first)
@@ -276,7 +364,7 @@ guess_encoding (GitgSmartCharsetConverter *smart,
 		}
 
 		/* Try to convert */
-		if (try_convert (conv, inbuf, inbuf_size))
+		if (conv != NULL && try_convert (conv, inbuf, inbuf_size))
 		{
 			break;
 		}
@@ -284,10 +372,13 @@ guess_encoding (GitgSmartCharsetConverter *smart,
 
 	if (conv != NULL)
 	{
+		smart->priv->guessed = enc;
 		g_converter_reset (G_CONVERTER (conv));
 
 		/* FIXME: uncomment this when we want to use the fallback
 		g_charset_converter_set_use_fallback (conv, TRUE);*/
+
+		g_object_ref (conv);
 	}
 
 	return conv;
@@ -366,6 +457,7 @@ gitg_smart_charset_converter_reset (GConverter *converter)
 	GitgSmartCharsetConverter *smart = GITG_SMART_CHARSET_CONVERTER (converter);
 
 	smart->priv->current_encoding = NULL;
+	smart->priv->guessed = NULL;
 	smart->priv->is_utf8 = FALSE;
 
 	if (smart->priv->charset_conv != NULL)
@@ -401,9 +493,9 @@ gitg_smart_charset_converter_get_guessed (GitgSmartCharsetConverter *smart)
 {
 	g_return_val_if_fail (GITG_IS_SMART_CHARSET_CONVERTER (smart), NULL);
 
-	if (smart->priv->current_encoding != NULL)
+	if (smart->priv->guessed != NULL)
 	{
-		return (const GitgEncoding *)smart->priv->current_encoding->data;
+		return smart->priv->guessed;
 	}
 	else if (smart->priv->is_utf8)
 	{
@@ -413,6 +505,15 @@ gitg_smart_charset_converter_get_guessed (GitgSmartCharsetConverter *smart)
 	return NULL;
 }
 
+void
+gitg_smart_charset_converter_set_hint (GitgSmartCharsetConverter *smart,
+                                       const GitgEncoding        *encoding)
+{
+	g_return_if_fail (GITG_IS_SMART_CHARSET_CONVERTER (smart));
+
+	smart->priv->hint = encoding;
+}
+
 guint
 gitg_smart_charset_converter_get_num_fallbacks (GitgSmartCharsetConverter *smart)
 {
@@ -67,6 +67,9 @@ GitgSmartCharsetConverter	*gitg_smart_charset_converter_new		(GSList *candidate_
 
 const GitgEncoding		*gitg_smart_charset_converter_get_guessed	(GitgSmartCharsetConverter *smart);
 
+void				 gitg_smart_charset_converter_set_hint		(GitgSmartCharsetConverter *smart,
+										 const GitgEncoding        *encoding);
+
 guint				 gitg_smart_charset_converter_get_num_fallbacks(GitgSmartCharsetConverter *smart);
 
 G_END_DECLS
@@ -0,0 +1,282 @@
+#include <libgitg/gitg-config-file.h>
+#include <libgitg/gitg-debug.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#define test_add_config(name, callback) g_test_add (name, ConfigInfo, NULL, config_setup, callback, config_cleanup)
+
+typedef struct
+{
+	gchar *path;
+	gchar *config;
+} ConfigInfo;
+
+static void
+remove_all (gchar const *path,
+            GError      **error)
+{
+	gchar const *argv[] = {
+		"rm",
+		"-rf",
+		path,
+		NULL
+	};
+
+	g_spawn_sync ("/",
+	              (gchar **)argv,
+	              NULL,
+	              G_SPAWN_SEARCH_PATH |
+	              G_SPAWN_STDOUT_TO_DEV_NULL |
+	              G_SPAWN_STDERR_TO_DEV_NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              error);
+}
+
+static void
+write_file (ConfigInfo  *info,
+            gchar const *name,
+            gchar const *contents)
+{
+	gchar *filename = g_build_filename (info->path, name, NULL);
+	GError *error = NULL;
+
+	g_file_set_contents (filename, contents, -1, &error);
+	g_assert_no_error (error);
+
+	g_free (filename);
+}
+
+static void
+config_setup (ConfigInfo    *info,
+              gconstpointer  data)
+{
+	GError *error = NULL;
+
+	info->path = g_build_filename (g_get_tmp_dir (), "gitg-test-config", NULL);
+
+	if (g_file_test (info->path, G_FILE_TEST_EXISTS))
+	{
+		remove_all (info->path, &error);
+
+		g_assert_no_error (error);
+	}
+
+	g_assert (g_mkdir (info->path, 0700) == 0);
+
+	info->config = g_build_filename (info->path, "config", NULL);
+}
+
+static void
+config_cleanup (ConfigInfo    *info,
+                gconstpointer  data)
+{
+	GError *error = NULL;
+
+	gitg_config_file_invalidate (info->config);
+
+	remove_all (info->path, &error);
+	g_assert_no_error (error);
+
+	g_free (info->config);
+	g_free (info->path);
+}
+
+static void
+assert_value (GitgConfigFile *file,
+              gchar const    *key,
+              gchar const    *expected)
+{
+	gchar const *value = NULL;
+
+	g_assert (gitg_config_file_lookup (file, key, &value));
+	g_assert_cmpstr (value, ==, expected);
+}
+
+static void
+test_subsection (ConfigInfo    *info,
+                 gconstpointer  data)
+{
+	GitgConfigFile *file;
+
+	write_file (info,
+	            "config",
+	            "[Remote \"Origin \\\"Repo\\\"\"]\n"
+	            "\turl = git://example.com/repo.git\n"
+	            "[branch.Master]\n"
+	            "\tRemote = origin\n");
+
+	file = gitg_config_file_get (info->config);
+	g_assert (file);
+
+	/* Subsections keep their case, sections and names do not */
+	assert_value (file, "remote.Origin \"Repo\".url", "git://example.com/repo.git");
+	assert_value (file, "REMOTE.Origin \"Repo\".URL", "git://example.com/repo.git");
+	g_assert (!gitg_config_file_lookup (file, "remote.origin \"repo\".url", NULL));
+
+	/* The deprecated [section.subsection] form is all lower case */
+	assert_value (file, "branch.master.remote", "origin");
+}
+
+static void
+test_escapes (ConfigInfo    *info,
+              gconstpointer  data)
+{
+	GitgConfigFile *file;
+
+	write_file (info,
+	            "config",
+	            "[alias]\n"
+	            "\tquoted = \"say \\\"hi\\\"\\\\there\\t\"\n"
+	            "\tspaced = \"  two  spaces  \" ; comment\n"
+	            "\tcomment = one # two\n"
+	            "\tnewline = a\\nb\n"
+	            "\tflag\n");
+
+	file = gitg_config_file_get (info->config);
+	g_assert (file);
+
+	assert_value (file, "alias.quoted", "say \"hi\"\\there\t");
+	assert_value (file, "alias.spaced", "  two  spaces  ");
+	assert_value (file, "alias.comment", "one");
+	assert_value (file, "alias.newline", "a\nb");
+
+	/* A name without value is set, but has no value */
+	assert_value (file, "alias.flag", NULL);
+}
+
+static void
+test_invalid_escape (ConfigInfo    *info,
+                     gconstpointer  data)
+{
+	GitgConfigFile *file;
+
+	write_file (info,
+	            "config",
+	            "[alias]\n"
+	            "\tfirst = 1\n"
+	            "\tbad = \\q\n"
+	            "\tlast = 2\n");
+
+	file = gitg_config_file_get (info->config);
+	g_assert (file);
+
+	/* Parsing stops at the invalid escape */
+	assert_value (file, "alias.first", "1");
+	g_assert (!gitg_config_file_lookup (file, "alias.bad", NULL));
+	g_assert (!gitg_config_file_lookup (file, "alias.last", NULL));
+}
+
+static void
+test_continuation (ConfigInfo    *info,
+                   gconstpointer  data)
+{
+	GitgConfigFile *file;
+
+	write_file (info,
+	            "config",
+	            "[alias]\n"
+	            "\tlong = one \\\n"
+	            "two\\\r\n"
+	            "three\n"
+	            "\tafter = yes\n");
+
+	file = gitg_config_file_get (info->config);
+	g_assert (file);
+
+	assert_value (file, "alias.long", "one twothree");
+	assert_value (file, "alias.after", "yes");
+}
+
+static void
+test_include_depth (ConfigInfo    *info,
+                    gconstpointer  data)
+{
+	GitgConfigFile *file;
+	gint i;
+
+	/* config includes level1, which includes level2 and so on */
+	for (i = 0; i <= 12; ++i)
+	{
+		gchar *name = i == 0 ? g_strdup ("config") : g_strdup_printf ("level%d", i);
+		gchar *contents = g_strdup_printf ("[depth]\n"
+		                                   "\tlevel%d = yes\n"
+		                                   "\tlast = %d\n"
+		                                   "[include]\n"
+		                                   "\tpath = level%d\n",
+		                                   i,
+		                                   i,
+		                                   i + 1);
+
+		write_file (info, name, contents);
+
+		g_free (contents);
+		g_free (name);
+	}
+
+	file = gitg_config_file_get (info->config);
+	g_assert (file);
+
+	for (i = 0; i <= 10; ++i)
+	{
+		gchar *key = g_strdup_printf ("depth.level%d", i);
+
+		assert_value (file, key, "yes");
+		g_free (key);
+	}
+
+	/* Includes nested deeper than git follows them are ignored */
+	g_assert (!gitg_config_file_lookup (file, "depth.level11", NULL));
+	assert_value (file, "depth.last", "10");
+}
+
+static void
+test_include_reload (ConfigInfo    *info,
+                     gconstpointer  data)
+{
+	GitgConfigFile *file;
+
+	write_file (info,
+	            "config",
+	            "[include]\n"
+	            "\tpath = included\n"
+	            "[core]\n"
+	            "\tbare = false\n");
+
+	file = gitg_config_file_get (info->config);
+	g_assert (!gitg_config_file_lookup (file, "user.name", NULL));
+
+	/* A missing include is watched as well */
+	write_file (info,
+	            "included",
+	            "[user]\n"
+	            "\tname = Someone\n");
+
+	file = gitg_config_file_get (info->config);
+
+	assert_value (file, "user.name", "Someone");
+	assert_value (file, "core.bare", "false");
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	g_type_init ();
+	g_test_init (&argc, &argv, NULL);
+
+	gitg_debug_init ();
+
+	test_add_config ("/config/subsection", test_subsection);
+	test_add_config ("/config/escapes", test_escapes);
+	test_add_config ("/config/invalid-escape", test_invalid_escape);
+	test_add_config ("/config/continuation", test_continuation);
+	test_add_config ("/config/include-depth", test_include_depth);
+	test_add_config ("/config/include-reload", test_include_reload);
+
+	return g_test_run ();
+}
+/* ex:ts=8:noet: */
@@ -0,0 +1,341 @@
+#include <libgitg/gitg-hash.h>
+#include <libgitg/gitg-shell.h>
+#include <libgitg/gitg-debug.h>
+#include <string.h>
+
+#define test_add_repo(name, callback) g_test_add (name, RepositoryInfo, NULL, repository_setup, callback, repository_cleanup)
+
+/* More commits than hex digits, so some one digit prefixes must be
+   ambiguous */
+#define NUM_COMMITS 20
+
+typedef struct
+{
+	GitgRepository *repository;
+} RepositoryInfo;
+
+static void
+remove_all (gchar const *path,
+            GError      **error)
+{
+	gchar const *argv[] = {
+		"rm",
+		"-rf",
+		path,
+		NULL
+	};
+
+	g_spawn_sync ("/",
+	              (gchar **)argv,
+	              NULL,
+	              G_SPAWN_SEARCH_PATH |
+	              G_SPAWN_STDOUT_TO_DEV_NULL |
+	              G_SPAWN_STDERR_TO_DEV_NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              error);
+}
+
+static void
+on_loaded (GitgRepository *repository,
+           GMainLoop      *loop)
+{
+	g_main_loop_quit (loop);
+}
+
+static void
+repository_setup (RepositoryInfo *info,
+                  gconstpointer   data)
+{
+	gchar const *tmp = g_get_tmp_dir ();
+	gchar *repo_path;
+	gchar *script;
+	GError *error = NULL;
+
+	repo_path = g_build_filename (tmp, "gitg-test-hash", NULL);
+
+	if (g_file_test (repo_path, G_FILE_TEST_EXISTS))
+	{
+		remove_all (repo_path, &error);
+
+		g_assert_no_error (error);
+	}
+
+	g_assert (g_mkdir (repo_path, 0700) == 0);
+
+	script = g_strdup_printf ("git init && "
+	                          "for i in $(seq %d); do "
+	                          "echo $i > test.txt && "
+	                          "git add test.txt && "
+	                          "git -c user.name=gitg -c user.email=gitg@localhost commit -m \"Commit $i\" || exit 1; "
+	                          "done",
+	                          NUM_COMMITS);
+
+	gchar const *argv[] = {
+		"/bin/bash",
+		"-c",
+		script,
+		NULL
+	};
+
+	gint status = 0;
+
+	g_spawn_sync (repo_path,
+	              (gchar **)argv,
+	              NULL,
+	              G_SPAWN_STDOUT_TO_DEV_NULL |
+	              G_SPAWN_STDERR_TO_DEV_NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              &status,
+	              &error);
+
+	g_assert_no_error (error);
+	g_assert_cmpint (status, ==, 0);
+
+	g_free (script);
+
+	GFile *work_tree = g_file_new_for_path (repo_path);
+	gchar *git_dir_path = g_build_filename (repo_path, ".git", NULL);
+	GFile *git_dir = g_file_new_for_path (git_dir_path);
+	g_free (git_dir_path);
+	g_free (repo_path);
+
+	info->repository = gitg_repository_new (git_dir, work_tree);
+
+	g_object_unref (work_tree);
+	g_object_unref (git_dir);
+
+	/* Load all the revisions */
+	GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+	guint id = g_signal_connect (info->repository,
+	                             "loaded",
+	                             G_CALLBACK (on_loaded),
+	                             loop);
+
+	gitg_repository_load (info->repository, 0, NULL, &error);
+	g_assert_no_error (error);
+
+	g_main_loop_run (loop);
+
+	g_signal_handler_disconnect (info->repository, id);
+	g_main_loop_unref (loop);
+}
+
+static void
+repository_cleanup (RepositoryInfo *info,
+                    gconstpointer   data)
+{
+	GFile *work_tree;
+	GError *error = NULL;
+
+	work_tree = gitg_repository_get_work_tree (info->repository);
+	gchar *path = g_file_get_path (work_tree);
+	g_object_unref (work_tree);
+
+	remove_all (path, &error);
+	g_free (path);
+
+	g_assert_no_error (error);
+
+	g_object_unref (info->repository);
+}
+
+static void
+test_parse_prefix (void)
+{
+	GitgHash hash;
+	GitgHash full;
+	gchar const *sha = "0123456789abcdef0123456789abcdef01234567";
+
+	g_assert_cmpint (gitg_hash_parse_prefix ("ab12", hash), ==, 4);
+	g_assert (memcmp (hash, "\xab\x12\0\0", 4) == 0);
+
+	/* An odd prefix only sets the high nibble of the last byte */
+	g_assert_cmpint (gitg_hash_parse_prefix ("abc", hash), ==, 3);
+	g_assert (memcmp (hash, "\xab\xc0\0", 3) == 0);
+
+	g_assert_cmpint (gitg_hash_parse_prefix (sha, hash), ==, 40);
+	gitg_hash_sha1_to_hash (sha, full);
+	g_assert (memcmp (hash, full, GITG_HASH_BINARY_SIZE) == 0);
+
+	g_assert_cmpint (gitg_hash_parse_prefix ("", hash), ==, 0);
+	g_assert_cmpint (gitg_hash_parse_prefix ("abg", hash), ==, 0);
+	g_assert_cmpint (gitg_hash_parse_prefix ("HEAD", hash), ==, 0);
+
+	/* Longer than a full sha */
+	gchar *longer = g_strconcat (sha, "0", NULL);
+	g_assert_cmpint (gitg_hash_parse_prefix (longer, hash), ==, 0);
+	g_free (longer);
+}
+
+static void
+test_has_prefix (void)
+{
+	GitgHash hash;
+	GitgHash prefix;
+	gint length;
+
+	gitg_hash_sha1_to_hash ("0123456789abcdef0123456789abcdef01234567", hash);
+
+	length = gitg_hash_parse_prefix ("012", prefix);
+	g_assert (gitg_hash_has_prefix (hash, prefix, length));
+
+	length = gitg_hash_parse_prefix ("0123", prefix);
+	g_assert (gitg_hash_has_prefix (hash, prefix, length));
+
+	/* Differs in the last, odd, nibble */
+	length = gitg_hash_parse_prefix ("013", prefix);
+	g_assert (!gitg_hash_has_prefix (hash, prefix, length));
+
+	length = gitg_hash_parse_prefix ("1", prefix);
+	g_assert (!gitg_hash_has_prefix (hash, prefix, length));
+}
+
+static guint
+count_prefix (gchar **shas,
+              gchar const *prefix)
+{
+	guint ret = 0;
+	gchar **ptr;
+
+	for (ptr = shas; *ptr; ++ptr)
+	{
+		if (g_str_has_prefix (*ptr, prefix))
+		{
+			++ret;
+		}
+	}
+
+	return ret;
+}
+
+static void
+assert_find (GitgRepository *repository,
+             gchar         **shas,
+             gchar const    *sha,
+             gint            length)
+{
+	gchar *prefix = g_strndup (sha, length);
+	guint count = count_prefix (shas, prefix);
+	GtkTreeIter iter;
+	gboolean ambiguous = TRUE;
+	gboolean found;
+
+	found = gitg_repository_find_by_prefix (repository, prefix, &iter, &ambiguous);
+
+	g_assert (found == (count == 1));
+	g_assert (ambiguous == (count > 1));
+
+	if (found)
+	{
+		GitgRevision *revision;
+		GitgHash hash;
+
+		gtk_tree_model_get (GTK_TREE_MODEL (repository), &iter, 0, &revision, -1);
+
+		/* A unique prefix finds the revision it is a prefix of */
+		gitg_hash_sha1_to_hash (sha, hash);
+		g_assert (gitg_hash_hash_equal (gitg_revision_get_hash (revision), hash));
+
+		gitg_revision_unref (revision);
+	}
+
+	g_free (prefix);
+}
+
+static void
+test_find_by_prefix (RepositoryInfo *info,
+                     gconstpointer   data)
+{
+	gchar **shas;
+	gchar **ptr;
+	GError *error = NULL;
+	guint num_ambiguous = 0;
+
+	shas = gitg_shell_run_sync_with_output (gitg_command_new (info->repository,
+	                                                           "rev-list",
+	                                                           "HEAD",
+	                                                           NULL),
+	                                        FALSE,
+	                                        &error);
+
+	g_assert_no_error (error);
+	g_assert_cmpint (g_strv_length (shas), ==, NUM_COMMITS);
+
+	for (ptr = shas; *ptr; ++ptr)
+	{
+		gchar digit[] = {(*ptr)[0], '\0'};
+
+		if (count_prefix (shas, digit) > 1)
+		{
+			++num_ambiguous;
+		}
+
+		assert_find (info->repository, shas, *ptr, 1);
+		assert_find (info->repository, shas, *ptr, 4);
+		assert_find (info->repository, shas, *ptr, 7);
+		assert_find (info->repository, shas, *ptr, GITG_HASH_SHA_SIZE);
+	}
+
+	g_assert_cmpuint (num_ambiguous, >, 0);
+
+	g_strfreev (shas);
+}
+
+static void
+test_find_by_prefix_missing (RepositoryInfo *info,
+                             gconstpointer   data)
+{
+	gboolean ambiguous = TRUE;
+	gchar **shas;
+	GError *error = NULL;
+
+	shas = gitg_shell_run_sync_with_output (gitg_command_new (info->repository,
+	                                                           "rev-parse",
+	                                                           "HEAD",
+	                                                           NULL),
+	                                        FALSE,
+	                                        &error);
+
+	g_assert_no_error (error);
+	g_assert (shas && shas[0]);
+
+	/* Change the last digit to get a sha which is not in the history */
+	gchar *missing = g_strdup (shas[0]);
+	missing[GITG_HASH_SHA_SIZE - 1] = missing[GITG_HASH_SHA_SIZE - 1] == '0' ? '1' : '0';
+
+	g_assert (!gitg_repository_find_by_prefix (info->repository, missing, NULL, &ambiguous));
+	g_assert (!ambiguous);
+
+	ambiguous = TRUE;
+	g_assert (!gitg_repository_find_by_prefix (info->repository, "xyz", NULL, &ambiguous));
+	g_assert (!ambiguous);
+
+	g_free (missing);
+	g_strfreev (shas);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+	g_type_init ();
+	g_test_init (&argc, &argv, NULL);
+
+	gitg_debug_init ();
+
+	g_test_add_func ("/hash/parse-prefix", test_parse_prefix);
+	g_test_add_func ("/hash/has-prefix", test_has_prefix);
+
+	test_add_repo ("/hash/find-by-prefix", test_find_by_prefix);
+	test_add_repo ("/hash/find-by-prefix-missing", test_find_by_prefix_missing);
+
+	return g_test_run ();
+}
+/* ex:ts=8:noet: */
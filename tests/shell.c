@@ -1,4 +1,5 @@
 #include <libgitg/gitg-shell.h>
+#include <libgitg/gitg-line-parser.h>
 #include <string.h>
 
 #define test_add_repo(name, callback) g_test_add (name, RepositoryInfo, NULL, repository_setup, callback, repository_cleanup)
@@ -250,6 +251,261 @@ test_pipestr (void)
 	g_assert_cmpstr (ret[0], ==, input);
 }
 
+/* Records of the NUL separated tests, spanning several small reads */
+static gchar const nul_input[] = "first\0second\0\0a line\nwith newline\0tail";
+
+static gchar const *nul_records[] = {
+	"first",
+	"second",
+	"",
+	"a line\nwith newline",
+	"tail",
+	NULL
+};
+
+static void
+append_records (GPtrArray  *records,
+                gchar     **lines)
+{
+	gchar **ptr;
+
+	for (ptr = lines; *ptr; ++ptr)
+	{
+		g_ptr_array_add (records, g_strdup (*ptr));
+	}
+}
+
+static void
+assert_nul_records (GPtrArray *records)
+{
+	guint i;
+
+	g_assert_cmpuint (records->len, ==, g_strv_length ((gchar **)nul_records));
+
+	for (i = 0; i < records->len; ++i)
+	{
+		g_assert_cmpstr (g_ptr_array_index (records, i), ==, nul_records[i]);
+	}
+}
+
+static void
+on_parser_lines (GitgLineParser  *parser,
+                 gchar          **lines,
+                 GPtrArray       *records)
+{
+	append_records (records, lines);
+}
+
+static void
+on_parser_done (GitgLineParser *parser,
+                GError         *error,
+                GMainLoop      *loop)
+{
+	g_assert_no_error (error);
+	g_main_loop_quit (loop);
+}
+
+static void
+test_nul_separated_parser (void)
+{
+	GInputStream *stream;
+	GitgLineParser *parser;
+	GPtrArray *records;
+	GMainLoop *loop;
+
+	stream = g_memory_input_stream_new_from_data (nul_input,
+	                                              sizeof (nul_input) - 1,
+	                                              NULL);
+
+	/* Read 4 bytes at a time */
+	parser = gitg_line_parser_new (4, FALSE);
+	g_object_set (parser, "nul-separated", TRUE, NULL);
+
+	records = g_ptr_array_new ();
+	loop = g_main_loop_new (NULL, FALSE);
+
+	g_signal_connect (parser,
+	                  "lines",
+	                  G_CALLBACK (on_parser_lines),
+	                  records);
+
+	g_signal_connect (parser,
+	                  "done",
+	                  G_CALLBACK (on_parser_done),
+	                  loop);
+
+	gitg_line_parser_parse (parser, stream, NULL);
+	g_main_loop_run (loop);
+
+	assert_nul_records (records);
+
+	g_ptr_array_foreach (records, (GFunc)g_free, NULL);
+	g_ptr_array_free (records, TRUE);
+
+	g_main_loop_unref (loop);
+	g_object_unref (parser);
+	g_object_unref (stream);
+}
+
+static void
+on_shell_update (GitgShell  *shell,
+                 gchar     **lines,
+                 GPtrArray  *records)
+{
+	append_records (records, lines);
+}
+
+static void
+test_nul_separated_shell (void)
+{
+	GitgShell *shell;
+	GPtrArray *records;
+	GError *error = NULL;
+	gboolean ret;
+
+	/* Read 3 bytes at a time */
+	shell = gitg_shell_new_synchronized (3);
+	gitg_shell_set_nul_separated (shell, TRUE);
+
+	records = g_ptr_array_new ();
+
+	g_signal_connect (shell,
+	                  "update",
+	                  G_CALLBACK (on_shell_update),
+	                  records);
+
+	ret = gitg_shell_run (shell,
+	                      gitg_command_new (NULL,
+	                                        "printf",
+	                                        "first\\0second\\0\\0a line\\nwith newline\\0tail",
+	                                        NULL),
+	                      &error);
+
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	assert_nul_records (records);
+
+	g_ptr_array_foreach (records, (GFunc)g_free, NULL);
+	g_ptr_array_free (records, TRUE);
+
+	g_object_unref (shell);
+}
+
+static void
+test_nul_separated_utf8 (RepositoryInfo *info,
+                         gconstpointer   data)
+{
+	GitgShell *shell;
+	GPtrArray *records;
+	GError *error = NULL;
+	gboolean ret;
+	gchar const *name = "caf\xc3\xa9 na\xc3\xafve.txt";
+
+	/* Commit a file with a non-ASCII name */
+	gchar *script = g_strdup_printf ("echo haha > '%s' && git add . && git commit -m 'Add'",
+	                                 name);
+
+	gchar const *argv[] = {
+		"/bin/bash",
+		"-c",
+		script,
+		NULL
+	};
+
+	GFile *work_tree = gitg_repository_get_work_tree (info->repository);
+	gchar *work_path = g_file_get_path (work_tree);
+	g_object_unref (work_tree);
+
+	g_spawn_sync (work_path,
+	              (gchar **)argv,
+	              NULL,
+	              G_SPAWN_STDOUT_TO_DEV_NULL |
+	              G_SPAWN_STDERR_TO_DEV_NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              NULL,
+	              &error);
+
+	g_assert_no_error (error);
+
+	g_free (work_path);
+	g_free (script);
+
+	shell = gitg_shell_new_synchronized (1000);
+	gitg_shell_set_nul_separated (shell, TRUE);
+
+	records = g_ptr_array_new ();
+
+	g_signal_connect (shell,
+	                  "update",
+	                  G_CALLBACK (on_shell_update),
+	                  records);
+
+	ret = gitg_shell_run (shell,
+	                      gitg_command_new (info->repository,
+	                                        "ls-tree",
+	                                        "-z",
+	                                        "--name-only",
+	                                        "HEAD",
+	                                        NULL),
+	                      &error);
+
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	/* The NULs must not make the UTF-8 name look like another encoding */
+	g_assert_cmpuint (records->len, ==, 2);
+	g_assert_cmpstr (g_ptr_array_index (records, 0), ==, name);
+	g_assert_cmpstr (g_ptr_array_index (records, 1), ==, "test.txt");
+
+	g_ptr_array_foreach (records, (GFunc)g_free, NULL);
+	g_ptr_array_free (records, TRUE);
+
+	g_object_unref (shell);
+}
+
+static void
+test_nul_separated_latin1 (void)
+{
+	GitgShell *shell;
+	GPtrArray *records;
+	GError *error = NULL;
+	gboolean ret;
+
+	shell = gitg_shell_new_synchronized (1000);
+	gitg_shell_set_nul_separated (shell, TRUE);
+
+	records = g_ptr_array_new ();
+
+	g_signal_connect (shell,
+	                  "update",
+	                  G_CALLBACK (on_shell_update),
+	                  records);
+
+	/* Only the record which is not UTF-8 is converted */
+	ret = gitg_shell_run (shell,
+	                      gitg_command_new (NULL,
+	                                        "printf",
+	                                        "caf\xc3\xa9\\0caf\xe9",
+	                                        NULL),
+	                      &error);
+
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	g_assert_cmpuint (records->len, ==, 2);
+	g_assert_cmpstr (g_ptr_array_index (records, 0), ==, "caf\xc3\xa9");
+	g_assert_cmpstr (g_ptr_array_index (records, 1), ==, "caf\xc3\xa9");
+
+	g_ptr_array_foreach (records, (GFunc)g_free, NULL);
+	g_ptr_array_free (records, TRUE);
+
+	g_object_unref (shell);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -268,6 +524,11 @@ main (int   argc,
 	g_test_add_func ("/shell/pipe", test_pipe);
 	g_test_add_func ("/shell/pipestr", test_pipestr);
 
+	g_test_add_func ("/shell/nul-separated-parser", test_nul_separated_parser);
+	g_test_add_func ("/shell/nul-separated-shell", test_nul_separated_shell);
+	g_test_add_func ("/shell/nul-separated-latin1", test_nul_separated_latin1);
+	test_add_repo ("/shell/nul-separated-utf8", test_nul_separated_utf8);
+
 	return g_test_run ();
 }
 /* ex:ts=8:noet: */